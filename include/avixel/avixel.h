@@ -10,9 +10,9 @@ extern "C" {
 #endif
 
 #include "avixel_logging.h"
+#include "avixel_memory.h"
 #include "avixel_core.h"
 
-#include "avixel_memory.h"
 #include "avixel_ui_parser.h"
 
 #ifdef __cplusplus
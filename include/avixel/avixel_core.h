@@ -46,12 +46,36 @@ typedef struct AvWindowCreateInfo{
 
 // INSTANCE
 AV_DEFINE_HANDLE(AvInstance);
+
+typedef enum AvRenderMode {
+	// avUpdate renders a frame on every call
+	AV_RENDER_MODE_CONTINUOUS = 0,
+	// avUpdate only renders when the queued rectangles or the window changed, or a redraw was requested.
+	// Otherwise it waits for the next window event or scheduled redraw instead of rendering
+	AV_RENDER_MODE_ON_DEMAND = 1,
+} AvRenderMode;
+
 typedef struct AvInstanceCreateInfo{
 	AvStructureType sType;
 	void* next;
 	AvProjectInfo projectInfo;
+	// the outputs (stdout, log file, sinks, binary log and queue) are shared by all instances and configured by the first one,
+	// later instances only filter and format with their settings
 	AvLogSettings* logSettings;
+	// optional, nullptr uses the c runtime heap. The callbacks are copied, userData must outlive the instance.
+	// shared by all instances, the callbacks of the first instance stay installed until the last one is destroyed
+	const AvAllocationCallbacks* allocationCallbacks;
+	// bytes of scratch memory per frame, 0 selects AV_FRAME_MEMORY_SIZE_DEFAULT. Grows when exceeded
+	uint64 frameMemorySize;
+	// collects per category and per call site statistics, and reports leaks when the last instance is destroyed.
+	// only takes effect for the first instance
+	bool enableMemoryTracking;
 	bool disableDeviceValidation;
+	// renders through a render pass even when the device supports dynamic rendering
+	bool disableDynamicRendering;
+	// optional, compiled pipelines are kept in this file between runs to speed up startup. nullptr disables it
+	const char* pipelineCachePath;
+	AvRenderMode renderMode;
 	AvWindowCreateInfo windowInfo;
 
 }AvInstanceCreateInfo;
@@ -61,6 +85,57 @@ void avInstanceDestroy(AvInstance instance);
 void avUpdate(AvInstance instance);
 bool avShutdownRequested(AvInstance instance);
 
+void avSetRenderMode(AvInstance instance, AvRenderMode mode);
+// makes the next avUpdate render in on demand mode, for changes the queued rectangles don't show
+void avRequestRedraw(AvInstance instance);
+// makes avUpdate render again after delay milliseconds at the latest, so animations keep running in
+// on demand mode. The earliest scheduled redraw is kept
+void avScheduleRedraw(AvInstance instance, uint delay);
+
+// FRAME MEMORY
+#define AV_FRAME_MEMORY_SIZE_DEFAULT (1024 * 1024)
+
+typedef struct AvFrameMemoryStats {
+	// number of frames memory from avFrameAllocate stays valid for
+	uint frameCount;
+	uint64 capacity;
+	uint64 used;
+	// largest amount used in a single frame so far
+	uint64 highWaterMark;
+} AvFrameMemoryStats;
+
+// returns uninitialized scratch memory that is released automatically. It stays valid until
+// avUpdate has been called frameCount more times. alignment has to be a power of two, 0 selects 16
+void* avFrameAllocate(AvInstance instance, uint64 size, uint64 alignment);
+void avGetFrameMemoryStats(AvInstance instance, AvFrameMemoryStats* stats);
+
+// RECTANGLES
+// in pixels from the top left corner of the window. The layout is the instance data the
+// renderer reads, so queued rectangles are copied to the gpu as they are
+typedef struct AvRect {
+	float x;
+	float y;
+	float width;
+	float height;
+	Color color;
+	float cornerRadius;
+	// 0 draws unclipped, otherwise the rectangle is clipped by clip rectangle clipIndex - 1
+	uint clipIndex;
+} AvRect;
+
+typedef struct AvClipRect {
+	int x;
+	int y;
+	uint width;
+	uint height;
+} AvClipRect;
+
+// queues rectangles for the next avUpdate. Rectangles are drawn in the order they were queued,
+// with one instanced draw for every run of rectangles that share a clip rectangle
+void avDrawRects(AvInstance instance, uint count, const AvRect* rects);
+// replaces the clip rectangles used by the rectangles of the next avUpdate
+void avSetClipRects(AvInstance instance, uint count, const AvClipRect* clipRects);
+
 
 AV_DEFINE_HANDLE(AvWindow);
 void avInstanceGetPrimaryWindow(AvInstance, AvWindow* window);
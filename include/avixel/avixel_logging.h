@@ -31,6 +31,7 @@ typedef enum AvResult {
 	AV_TIMEOUT = AV_WARNING | 6,
 	AV_INVALID_SYNTAX = AV_WARNING | 7,
 	AV_UNABLE_TO_PARSE = AV_WARNING | 8,
+	AV_MEMORY_LEAK = AV_WARNING | 9,
 
 	// ERROR
 	AV_ERROR = 0xF0000000 | 0,
@@ -76,12 +77,29 @@ typedef enum AvAssertLevel {
 	AV_ASSERT_LEVEL_NORMAL = AV_ERROR,
 }AvAssertLevel;
 
+// what a logging thread does when the asynchronous log queue is full
+typedef enum AvLogBackpressure {
+	// wait for the writer thread to free a slot
+	AV_LOG_BACKPRESSURE_BLOCK = 0,
+	// discard the message, the number of dropped messages is logged later
+	AV_LOG_BACKPRESSURE_DROP = 1,
+}AvLogBackpressure;
+
+// how printTime shows when a message was logged
+typedef enum AvLogTimeFormat {
+	// time of day, HH:MM:SS.uuuuuu
+	AV_LOG_TIME_FORMAT_WALL_CLOCK = 0,
+	// seconds since the instance was created, with microsecond precision
+	AV_LOG_TIME_FORMAT_RELATIVE = 1,
+}AvLogTimeFormat;
+
 #define AV_LOG_LEVEL_DEFAULT AV_LOG_LEVEL_ALL
 #define AV_LOG_LINE_DEFAULT 0
 #define AV_LOG_FILE_DEFAULT 0
 #define AV_LOG_FUNC_DEFAULT 0
 #define AV_LOG_PROJECT_DEFAULT 0
 #define AV_LOG_TIME_DEFAULT 0
+#define AV_LOG_TIME_FORMAT_DEFAULT AV_LOG_TIME_FORMAT_WALL_CLOCK
 #define AV_LOG_TYPE_DEFAULT 1
 #define AV_LOG_ERROR_DEFAULT 1
 #define AV_LOG_ASSERT_DEFAULT 0
@@ -90,6 +108,15 @@ typedef enum AvAssertLevel {
 #define AV_LOG_CODE_DEFAULT 1
 #define AV_VALIDATION_LEVEL_DEFAULT AV_VALIDATION_LEVEL_ERRORS
 #define AV_LOG_CATEGORY_DEFAULT 0
+#define AV_LOG_ASYNCHRONOUS_DEFAULT 1
+#define AV_LOG_QUEUE_SIZE_DEFAULT 1024
+#define AV_LOG_BACKPRESSURE_DEFAULT AV_LOG_BACKPRESSURE_BLOCK
+#define AV_LOG_BINARY_FILE_DEFAULT nullptr
+#define AV_LOG_STDOUT_DEFAULT 1
+#define AV_LOG_FILE_NAME_DEFAULT nullptr
+#define AV_LOG_FILE_BUFFER_SIZE_DEFAULT (64 * 1024)
+#define AV_LOG_CRASH_RING_SIZE_DEFAULT 0
+#define AV_LOG_RATE_LIMIT_INTERVAL_DEFAULT 1000
 
 extern const char* defaulDisabledLogCategories[];
 extern const uint defaultDisabledLogCategoryCount;
@@ -97,25 +124,136 @@ extern const uint defaultDisabledLogCategoryCount;
 extern const AvResult defaultDisabledMessages[];
 extern const uint defaultDisabledCategoryCount;
 
+// matches every result code in AvLogRateLimit
+#define AV_LOG_RATE_LIMIT_ANY_RESULT 0xFFFFFFFF
+
+// limits how often a single call site writes messages. Validation layer messages are matched as
+// AV_VALIDATION_PRESENT with the renderer as category
+typedef struct AvLogRateLimit {
+	// nullptr matches every category
+	const char* category;
+	uint32 result;
+	// messages a call site writes per interval, the rest is counted and reported once the interval is over. 0 for no limit
+	uint32 maxMessages;
+	// count consecutive identical messages of a call site instead of writing them
+	uint32 coalesce;
+}AvLogRateLimit;
+
+extern const AvLogRateLimit defaultLogRateLimits[];
+extern const uint defaultLogRateLimitCount;
+
 
 #define AV_LOCATION_ARGS uint64 line, const char* file, const char* func
 #define AV_LOCATION_PARAMS __LINE__, __FILE__,__func__
 #define AV_CATEGORY_ARGS const char* category
 
+// state kept in a static variable at every avLog and avAssert call site, so the category is only looked up once
+// and repeated messages can be rate limited. Only the logging functions access it
+typedef struct AvLogCallSite {
+	uint32 categoryId;
+
+	// rate limiting
+	uint32 lock;
+	uint32 registered;
+	uint32 windowCount;
+	uint32 suppressed;
+	uint32 repeats;
+	uint32 hasLastMessage;
+	uint64 windowStart;
+	uint64 lastMessageHash;
+	uint64 lastMessageTime;
+
+	// the last held back message, to report it when logging shuts down
+	uint32 recordType;
+	AvResult result;
+	uint64 line;
+	const char* file;
+	const char* func;
+	const char* category;
+	struct AvLogCallSite* nextRegistered;
+}AvLogCallSite;
+
+#if defined(__GNUC__)
+#define AV_PRINTF_FORMAT(formatIndex, argIndex) __attribute__((format(printf, formatIndex, argIndex)))
+#else
+#define AV_PRINTF_FORMAT(formatIndex, argIndex)
+#endif
+
 void avLog_(AvResult result, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg);
 void avAssert_(AvResult result, AvResult valid, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg);
+void avLogSite_(AvResult result, AvLogCallSite* callSite, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg);
+void avAssertSite_(AvResult result, AvResult valid, AvLogCallSite* callSite, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg);
+// format has to be a string literal, the arguments are captured and the message is formatted when it is written
+void avLogf_(AvResult result, AvLogCallSite* callSite, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* format, ...) AV_PRINTF_FORMAT(7, 8);
+void avAssertf_(AvResult result, AvResult valid, AvLogCallSite* callSite, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* format, ...) AV_PRINTF_FORMAT(8, 9);
 
 #ifndef AV_LOG_CATEGORY
 #define AV_LOG_CATEGORY "misc"
 #endif
 
+// calls with a result below this level are compiled out, the result expression is still evaluated
+#ifndef AV_LOG_COMPILE_LEVEL
 #ifndef NDEBUG
-#define avLog(result, message) avLog_(result,AV_LOCATION_PARAMS, AV_LOG_CATEGORY, message)
-#define avAssert(result, valid, message) avAssert_(result,valid,AV_LOCATION_PARAMS, AV_LOG_CATEGORY, message)
-#else 
-#define avLog(result,message) (result)
-#define avAssert(result,valid,message) (result)
+#define AV_LOG_COMPILE_LEVEL AV_LOG_LEVEL_ALL
+#else
+#define AV_LOG_COMPILE_LEVEL AV_LOG_LEVEL_NONE
 #endif
+#endif
+
+#define AV_LOG_COMPILED(result) ((uint32)(result) >= (uint32)AV_LOG_COMPILE_LEVEL && (uint32)AV_LOG_COMPILE_LEVEL != (uint32)AV_LOG_LEVEL_NONE)
+
+#define avLog(result, message) do { \
+		uint32 avLogResult_ = (uint32)(result); \
+		if (AV_LOG_COMPILED(avLogResult_)) { \
+			static AvLogCallSite avLogCallSite_ = { 0 }; \
+			avLogSite_((AvResult)avLogResult_, &avLogCallSite_, AV_LOCATION_PARAMS, AV_LOG_CATEGORY, message); \
+		} \
+	} while (0)
+#define avAssert(result, valid, message) do { \
+		uint32 avLogResult_ = (uint32)(result); \
+		if (AV_LOG_COMPILED(avLogResult_)) { \
+			static AvLogCallSite avLogCallSite_ = { 0 }; \
+			avAssertSite_((AvResult)avLogResult_, valid, &avLogCallSite_, AV_LOCATION_PARAMS, AV_LOG_CATEGORY, message); \
+		} \
+	} while (0)
+#define avLogf(result, ...) do { \
+		uint32 avLogResult_ = (uint32)(result); \
+		if (AV_LOG_COMPILED(avLogResult_)) { \
+			static AvLogCallSite avLogCallSite_ = { 0 }; \
+			avLogf_((AvResult)avLogResult_, &avLogCallSite_, AV_LOCATION_PARAMS, AV_LOG_CATEGORY, __VA_ARGS__); \
+		} \
+	} while (0)
+#define avAssertf(result, valid, ...) do { \
+		uint32 avLogResult_ = (uint32)(result); \
+		if (AV_LOG_COMPILED(avLogResult_)) { \
+			static AvLogCallSite avLogCallSite_ = { 0 }; \
+			avAssertf_((AvResult)avLogResult_, valid, &avLogCallSite_, AV_LOCATION_PARAMS, AV_LOG_CATEGORY, __VA_ARGS__); \
+		} \
+	} while (0)
+
+// a formatted message as it is handed to a log sink
+typedef struct AvLogMessage {
+	// validation layer messages are reported as AV_VALIDATION_PRESENT, with the renderer as category
+	AvResult result;
+	const char* category;
+	// monotonic, in microseconds
+	uint64 timestamp;
+	// the message with the tags selected in the log settings, without colors or a trailing newline
+	const char* text;
+	uint64 length;
+}AvLogMessage;
+
+typedef void (*PFN_avLogSinkWrite)(void* userData, const AvLogMessage* message);
+typedef void (*PFN_avLogSinkFlush)(void* userData);
+
+// receives every message that passes the log filters. When logging asynchronously
+// it is called from the log writer thread, otherwise from the thread that logs
+typedef struct AvLogSink {
+	void* userData;
+	PFN_avLogSinkWrite pfnWrite;
+	// called after every batch of messages and before the process exits on a failed assert, may be nullptr
+	PFN_avLogSinkFlush pfnFlush;
+}AvLogSink;
 
 typedef struct AvLogSettings {
 	AvLogLevel level;
@@ -124,6 +262,7 @@ typedef struct AvLogSettings {
 	uint32 printFile;
 	uint32 printProject;
 	uint32 printTime;
+	AvLogTimeFormat timeFormat;
 	uint32 printType;
 	uint32 printError;
 	uint32 printAssert;
@@ -139,5 +278,31 @@ typedef struct AvLogSettings {
 
 	uint32 disabledMessageCount;
 	const AvResult* disabledMessages;
+
+	// write messages from a background thread instead of the thread that logs them
+	uint32 asynchronous;
+	// number of messages the asynchronous log queue can hold
+	uint32 queueSize;
+	AvLogBackpressure backpressure;
+
+	// also write messages to this file in a compact binary format, decode it with the logDecoder tool
+	const char* binaryLogFile;
+
+	// write messages to stdout, when no output is enabled messages are discarded before they are formatted
+	uint32 printStdout;
+	// also write messages to this file, without colors, through a buffer of logFileBufferSize bytes
+	const char* logFile;
+	uint32 logFileBufferSize;
+	// keep the last crashRingSize messages in memory and write them to stderr when a failed assert exits the process
+	uint32 crashRingSize;
+	// user sinks that receive every message
+	uint32 sinkCount;
+	const AvLogSink* sinks;
+
+	// the first limit that matches a message applies
+	uint32 rateLimitCount;
+	const AvLogRateLimit* rateLimits;
+	// in milliseconds
+	uint32 rateLimitInterval;
 }AvLogSettings;
 extern const AvLogSettings avLogSettingsDefault;
\ No newline at end of file
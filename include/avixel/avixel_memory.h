@@ -1,4 +1,46 @@
 
+// Host supplied memory callbacks.
+//
+// Every allocation made by the library is forwarded to these callbacks together
+// with the location and log category of the call that requested it. When no
+// callbacks are supplied malloc, realloc and free are used.
+
+#define AV_ALLOCATION_ALIGNMENT_DEFAULT 16
+
+typedef void* (*PFN_avAllocationFunction)(void* userData, uint64 size, uint64 alignment, AV_LOCATION_ARGS, AV_CATEGORY_ARGS);
+// original may be nullptr, in which case it behaves like an allocation
+typedef void* (*PFN_avReallocationFunction)(void* userData, void* original, uint64 size, uint64 alignment, AV_LOCATION_ARGS, AV_CATEGORY_ARGS);
+typedef void (*PFN_avFreeFunction)(void* userData, void* memory, AV_LOCATION_ARGS, AV_CATEGORY_ARGS);
+
+typedef struct AvAllocationCallbacks {
+	void* userData;
+	PFN_avAllocationFunction pfnAllocation;
+	PFN_avReallocationFunction pfnReallocation;
+	PFN_avFreeFunction pfnFree;
+	// minimum alignment requested for every allocation, 0 selects AV_ALLOCATION_ALIGNMENT_DEFAULT
+	uint64 alignment;
+} AvAllocationCallbacks;
+
+// Allocation flags for avAllocateEx and avReallocateEx. The alignment is stored in the upper 32 bits,
+// e.g. AV_ALLOCATION_UNINITIALIZED | AV_ALLOCATION_ALIGNED(64)
+typedef enum AvAllocationFlagBits {
+	AV_ALLOCATION_ZEROED = 0,
+	// skips clearing the memory, for blocks that are overwritten right away
+	AV_ALLOCATION_UNINITIALIZED = 1 << 0,
+	// aligns to 2MiB and asks the os to back the block with huge pages, for large long lived blocks
+	AV_ALLOCATION_HUGE_PAGES = 1 << 1,
+} AvAllocationFlagBits;
+typedef uint64 AvAllocationFlags;
+#define AV_ALLOCATION_ALIGNED(alignment) ((AvAllocationFlags)(alignment) << 32)
+#define AV_ALLOCATION_FLAGS_GET_ALIGNMENT(flags) ((uint64)(flags) >> 32)
+
+void* avAllocateEx_(uint64 size, AvAllocationFlags flags, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg);
+#define avAllocateEx(size,flags,message) avAllocateEx_(size,flags,AV_LOCATION_PARAMS, AV_LOG_CATEGORY, message)
+
+// only the alignment and huge page flags apply, memory added by growing the block is never cleared
+void* avReallocateEx_(void* data, uint64 size, AvAllocationFlags flags, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg);
+#define avReallocateEx(data,size,flags,message) avReallocateEx_(data,size,flags,AV_LOCATION_PARAMS, AV_LOG_CATEGORY, message)
+
 void* avAllocate_(uint size, uint count, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg);
 #define avAllocate(size,count,message) avAllocate_(size,count,AV_LOCATION_PARAMS, AV_LOG_CATEGORY, message)
 
@@ -6,4 +48,44 @@ void* avReallocate_(void* data, uint size, uint count, AV_LOCATION_ARGS, AV_CATE
 #define avReallocate(data,size,count,message) avReallocate_(data,size,count,AV_LOCATION_PARAMS, AV_LOG_CATEGORY,message)
 
 void avFree_(void* data, AV_LOCATION_ARGS, AV_CATEGORY_ARGS);
-#define avFree(data) avFree_(data, AV_LOCATION_PARAMS, AV_LOG_CATEGORY)
\ No newline at end of file
+#define avFree(data) avFree_(data, AV_LOCATION_PARAMS, AV_LOG_CATEGORY)
+
+// Memory statistics, only collected when AvInstanceCreateInfo::enableMemoryTracking is set.
+// Memory that is not allocated through the library, like driver memory, is not included.
+
+typedef struct AvMemoryStats {
+	bool trackingEnabled;
+	uint64 liveBytes;
+	uint64 liveAllocations;
+	uint64 peakBytes;
+	uint64 totalAllocations;
+	uint64 totalFrees;
+	uint categoryCount;
+	uint callSiteCount;
+} AvMemoryStats;
+
+typedef struct AvMemoryCategoryStats {
+	const char* category;
+	uint64 liveBytes;
+	uint64 liveAllocations;
+	uint64 peakBytes;
+	uint64 totalAllocations;
+} AvMemoryCategoryStats;
+
+typedef struct AvMemoryCallSiteStats {
+	const char* file;
+	const char* func;
+	uint64 line;
+	const char* category;
+	uint64 liveBytes;
+	uint64 liveAllocations;
+	uint64 totalAllocations;
+} AvMemoryCallSiteStats;
+
+void avGetMemoryStats(AvMemoryStats* stats);
+
+// when stats is nullptr the number of categories is written to count, otherwise at most count entries are written
+void avGetMemoryCategoryStats(uint* count, AvMemoryCategoryStats* stats);
+
+// when stats is nullptr the number of call sites is written to count, otherwise at most count entries are written
+void avGetMemoryCallSiteStats(uint* count, AvMemoryCallSiteStats* stats);
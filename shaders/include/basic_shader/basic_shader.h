@@ -1,145 +1,225 @@
 #ifndef __CED23B1537DAB77D_GUARD__
 #define __CED23B1537DAB77D_GUARD__
 
-//THIS FILE IS AUTOMATICALLY GENERATED - DO NOT EDIT
+// NOT GENERATED - assembled by hand from shaders/src/basic_shader/basic_shader.vert and .frag
+// because shaderc was not available. the compileShaders target overwrites this file with the
+// compiled shaders, run it and commit its output before relying on this header
 
 const char basic_shader_vert_data[] = {
-	0x03, 0x02, 0x23, 0x07, 0x00, 0x00, 0x01, 0x00,  0x0b, 0x00, 0x0d, 0x00, 0x36, 0x00, 0x00, 0x00, 
+	0x03, 0x02, 0x23, 0x07, 0x00, 0x00, 0x01, 0x00,  0x00, 0x00, 0x00, 0x00, 0x47, 0x00, 0x00, 0x00, 
 	0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x02, 0x00,  0x01, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x06, 0x00, 
 	0x01, 0x00, 0x00, 0x00, 0x47, 0x4c, 0x53, 0x4c,  0x2e, 0x73, 0x74, 0x64, 0x2e, 0x34, 0x35, 0x30, 
 	0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x03, 0x00,  0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
-	0x0f, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00,  0x04, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x69, 0x6e, 
-	0x00, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00,  0x26, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00, 
-	0x03, 0x00, 0x03, 0x00, 0x02, 0x00, 0x00, 0x00,  0xc2, 0x01, 0x00, 0x00, 0x04, 0x00, 0x0a, 0x00, 
-	0x47, 0x4c, 0x5f, 0x47, 0x4f, 0x4f, 0x47, 0x4c,  0x45, 0x5f, 0x63, 0x70, 0x70, 0x5f, 0x73, 0x74, 
-	0x79, 0x6c, 0x65, 0x5f, 0x6c, 0x69, 0x6e, 0x65,  0x5f, 0x64, 0x69, 0x72, 0x65, 0x63, 0x74, 0x69, 
-	0x76, 0x65, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00,  0x47, 0x4c, 0x5f, 0x47, 0x4f, 0x4f, 0x47, 0x4c, 
-	0x45, 0x5f, 0x69, 0x6e, 0x63, 0x6c, 0x75, 0x64,  0x65, 0x5f, 0x64, 0x69, 0x72, 0x65, 0x63, 0x74, 
-	0x69, 0x76, 0x65, 0x00, 0x05, 0x00, 0x04, 0x00,  0x04, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x69, 0x6e, 
-	0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x05, 0x00,  0x0c, 0x00, 0x00, 0x00, 0x70, 0x6f, 0x73, 0x69, 
-	0x74, 0x69, 0x6f, 0x6e, 0x73, 0x00, 0x00, 0x00,  0x05, 0x00, 0x04, 0x00, 0x17, 0x00, 0x00, 0x00, 
-	0x63, 0x6f, 0x6c, 0x6f, 0x72, 0x73, 0x00, 0x00,  0x05, 0x00, 0x06, 0x00, 0x20, 0x00, 0x00, 0x00, 
-	0x67, 0x6c, 0x5f, 0x50, 0x65, 0x72, 0x56, 0x65,  0x72, 0x74, 0x65, 0x78, 0x00, 0x00, 0x00, 0x00, 
-	0x06, 0x00, 0x06, 0x00, 0x20, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00, 0x67, 0x6c, 0x5f, 0x50, 
-	0x6f, 0x73, 0x69, 0x74, 0x69, 0x6f, 0x6e, 0x00,  0x06, 0x00, 0x07, 0x00, 0x20, 0x00, 0x00, 0x00, 
-	0x01, 0x00, 0x00, 0x00, 0x67, 0x6c, 0x5f, 0x50,  0x6f, 0x69, 0x6e, 0x74, 0x53, 0x69, 0x7a, 0x65, 
-	0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x07, 0x00,  0x20, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
-	0x67, 0x6c, 0x5f, 0x43, 0x6c, 0x69, 0x70, 0x44,  0x69, 0x73, 0x74, 0x61, 0x6e, 0x63, 0x65, 0x00, 
-	0x06, 0x00, 0x07, 0x00, 0x20, 0x00, 0x00, 0x00,  0x03, 0x00, 0x00, 0x00, 0x67, 0x6c, 0x5f, 0x43, 
-	0x75, 0x6c, 0x6c, 0x44, 0x69, 0x73, 0x74, 0x61,  0x6e, 0x63, 0x65, 0x00, 0x05, 0x00, 0x03, 0x00, 
-	0x22, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x05, 0x00, 0x06, 0x00, 0x26, 0x00, 0x00, 0x00, 
-	0x67, 0x6c, 0x5f, 0x56, 0x65, 0x72, 0x74, 0x65,  0x78, 0x49, 0x6e, 0x64, 0x65, 0x78, 0x00, 0x00, 
-	0x05, 0x00, 0x05, 0x00, 0x31, 0x00, 0x00, 0x00,  0x66, 0x72, 0x61, 0x67, 0x43, 0x6f, 0x6c, 0x6f, 
-	0x72, 0x00, 0x00, 0x00, 0x48, 0x00, 0x05, 0x00,  0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-	0x0b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x48, 0x00, 0x05, 0x00, 0x20, 0x00, 0x00, 0x00, 
+	0x0f, 0x00, 0x0e, 0x00, 0x00, 0x00, 0x00, 0x00,  0x02, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x69, 0x6e, 
+	0x00, 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00,  0x20, 0x00, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00, 
+	0x22, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00,  0x25, 0x00, 0x00, 0x00, 0x26, 0x00, 0x00, 0x00, 
+	0x27, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,  0x03, 0x00, 0x03, 0x00, 0x02, 0x00, 0x00, 0x00, 
+	0xc2, 0x01, 0x00, 0x00, 0x05, 0x00, 0x04, 0x00,  0x02, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x69, 0x6e, 
+	0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00,  0x14, 0x00, 0x00, 0x00, 0x67, 0x6c, 0x5f, 0x50, 
+	0x65, 0x72, 0x56, 0x65, 0x72, 0x74, 0x65, 0x78,  0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00, 
+	0x20, 0x00, 0x00, 0x00, 0x67, 0x6c, 0x5f, 0x56,  0x65, 0x72, 0x74, 0x65, 0x78, 0x49, 0x6e, 0x64, 
+	0x65, 0x78, 0x00, 0x00, 0x05, 0x00, 0x04, 0x00,  0x21, 0x00, 0x00, 0x00, 0x69, 0x6e, 0x52, 0x65, 
+	0x63, 0x74, 0x00, 0x00, 0x05, 0x00, 0x04, 0x00,  0x22, 0x00, 0x00, 0x00, 0x69, 0x6e, 0x43, 0x6f, 
+	0x6c, 0x6f, 0x72, 0x00, 0x05, 0x00, 0x06, 0x00,  0x23, 0x00, 0x00, 0x00, 0x69, 0x6e, 0x43, 0x6f, 
+	0x72, 0x6e, 0x65, 0x72, 0x52, 0x61, 0x64, 0x69,  0x75, 0x73, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00, 
+	0x15, 0x00, 0x00, 0x00, 0x50, 0x75, 0x73, 0x68,  0x43, 0x6f, 0x6e, 0x73, 0x74, 0x61, 0x6e, 0x74, 
+	0x73, 0x00, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00,  0x24, 0x00, 0x00, 0x00, 0x70, 0x75, 0x73, 0x68, 
+	0x43, 0x6f, 0x6e, 0x73, 0x74, 0x61, 0x6e, 0x74,  0x73, 0x00, 0x00, 0x00, 0x05, 0x00, 0x05, 0x00, 
+	0x25, 0x00, 0x00, 0x00, 0x66, 0x72, 0x61, 0x67,  0x43, 0x6f, 0x6c, 0x6f, 0x72, 0x00, 0x00, 0x00, 
+	0x05, 0x00, 0x06, 0x00, 0x26, 0x00, 0x00, 0x00,  0x66, 0x72, 0x61, 0x67, 0x50, 0x6f, 0x73, 0x69, 
+	0x74, 0x69, 0x6f, 0x6e, 0x00, 0x00, 0x00, 0x00,  0x05, 0x00, 0x06, 0x00, 0x27, 0x00, 0x00, 0x00, 
+	0x66, 0x72, 0x61, 0x67, 0x48, 0x61, 0x6c, 0x66,  0x53, 0x69, 0x7a, 0x65, 0x00, 0x00, 0x00, 0x00, 
+	0x05, 0x00, 0x07, 0x00, 0x28, 0x00, 0x00, 0x00,  0x66, 0x72, 0x61, 0x67, 0x43, 0x6f, 0x72, 0x6e, 
+	0x65, 0x72, 0x52, 0x61, 0x64, 0x69, 0x75, 0x73,  0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x06, 0x00, 
+	0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x67, 0x6c, 0x5f, 0x50, 0x6f, 0x73, 0x69, 0x74, 
+	0x69, 0x6f, 0x6e, 0x00, 0x06, 0x00, 0x07, 0x00,  0x14, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x67, 0x6c, 0x5f, 0x50, 0x6f, 0x69, 0x6e, 0x74,  0x53, 0x69, 0x7a, 0x65, 0x00, 0x00, 0x00, 0x00, 
+	0x06, 0x00, 0x07, 0x00, 0x14, 0x00, 0x00, 0x00,  0x02, 0x00, 0x00, 0x00, 0x67, 0x6c, 0x5f, 0x43, 
+	0x6c, 0x69, 0x70, 0x44, 0x69, 0x73, 0x74, 0x61,  0x6e, 0x63, 0x65, 0x00, 0x06, 0x00, 0x07, 0x00, 
+	0x14, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  0x67, 0x6c, 0x5f, 0x43, 0x75, 0x6c, 0x6c, 0x44, 
+	0x69, 0x73, 0x74, 0x61, 0x6e, 0x63, 0x65, 0x00,  0x06, 0x00, 0x07, 0x00, 0x15, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x76, 0x69, 0x65, 0x77,  0x70, 0x6f, 0x72, 0x74, 0x53, 0x69, 0x7a, 0x65, 
+	0x00, 0x00, 0x00, 0x00, 0x48, 0x00, 0x05, 0x00,  0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+	0x0b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x48, 0x00, 0x05, 0x00, 0x14, 0x00, 0x00, 0x00, 
 	0x01, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x48, 0x00, 0x05, 0x00, 
-	0x20, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,  0x0b, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
-	0x48, 0x00, 0x05, 0x00, 0x20, 0x00, 0x00, 0x00,  0x03, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 
-	0x04, 0x00, 0x00, 0x00, 0x47, 0x00, 0x03, 0x00,  0x20, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
-	0x47, 0x00, 0x04, 0x00, 0x26, 0x00, 0x00, 0x00,  0x0b, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00, 
-	0x47, 0x00, 0x04, 0x00, 0x31, 0x00, 0x00, 0x00,  0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-	0x13, 0x00, 0x02, 0x00, 0x02, 0x00, 0x00, 0x00,  0x21, 0x00, 0x03, 0x00, 0x03, 0x00, 0x00, 0x00, 
-	0x02, 0x00, 0x00, 0x00, 0x16, 0x00, 0x03, 0x00,  0x06, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 
-	0x17, 0x00, 0x04, 0x00, 0x07, 0x00, 0x00, 0x00,  0x06, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
-	0x15, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00,  0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-	0x2b, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00,  0x09, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
-	0x1c, 0x00, 0x04, 0x00, 0x0a, 0x00, 0x00, 0x00,  0x07, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 
-	0x20, 0x00, 0x04, 0x00, 0x0b, 0x00, 0x00, 0x00,  0x06, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 
-	0x3b, 0x00, 0x04, 0x00, 0x0b, 0x00, 0x00, 0x00,  0x0c, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x2b, 0x00, 0x04, 0x00, 0x06, 0x00, 0x00, 0x00,  0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
-	0x2b, 0x00, 0x04, 0x00, 0x06, 0x00, 0x00, 0x00,  0x0e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xbf, 
-	0x2c, 0x00, 0x05, 0x00, 0x07, 0x00, 0x00, 0x00,  0x0f, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 
-	0x0e, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x04, 0x00,  0x06, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x00, 0x3f, 0x2c, 0x00, 0x05, 0x00,  0x07, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 
-	0x10, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,  0x2c, 0x00, 0x05, 0x00, 0x07, 0x00, 0x00, 0x00, 
-	0x12, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00,  0x10, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x06, 0x00, 
-	0x0a, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,  0x0f, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 
-	0x12, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00,  0x14, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x03, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x04, 0x00,  0x15, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00, 
-	0x09, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x16, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x15, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x16, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00, 
-	0x06, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x04, 0x00,  0x06, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x80, 0x3f, 0x2c, 0x00, 0x06, 0x00,  0x14, 0x00, 0x00, 0x00, 0x19, 0x00, 0x00, 0x00, 
-	0x18, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,  0x0d, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x06, 0x00, 
-	0x14, 0x00, 0x00, 0x00, 0x1a, 0x00, 0x00, 0x00,  0x0d, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 
-	0x0d, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x06, 0x00,  0x14, 0x00, 0x00, 0x00, 0x1b, 0x00, 0x00, 0x00, 
-	0x0d, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,  0x18, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x06, 0x00, 
-	0x15, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,  0x19, 0x00, 0x00, 0x00, 0x1a, 0x00, 0x00, 0x00, 
-	0x1b, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00,  0x1d, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x04, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x04, 0x00,  0x08, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 
-	0x01, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x04, 0x00,  0x1f, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x1e, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x06, 0x00,  0x20, 0x00, 0x00, 0x00, 0x1d, 0x00, 0x00, 0x00, 
-	0x06, 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00,  0x1f, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 
-	0x21, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  0x20, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00, 
-	0x21, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00,  0x03, 0x00, 0x00, 0x00, 0x15, 0x00, 0x04, 0x00, 
-	0x23, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x04, 0x00, 
-	0x23, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 
-	0x25, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x23, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00, 
-	0x25, 0x00, 0x00, 0x00, 0x26, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 
-	0x28, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,  0x07, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 
-	0x2e, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  0x1d, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 
-	0x30, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  0x14, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00, 
-	0x30, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00,  0x03, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00, 
-	0x33, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,  0x14, 0x00, 0x00, 0x00, 0x36, 0x00, 0x05, 0x00, 
-	0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
-	0xf8, 0x00, 0x02, 0x00, 0x05, 0x00, 0x00, 0x00,  0x3e, 0x00, 0x03, 0x00, 0x0c, 0x00, 0x00, 0x00, 
-	0x13, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x03, 0x00,  0x17, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00, 
-	0x3d, 0x00, 0x04, 0x00, 0x23, 0x00, 0x00, 0x00,  0x27, 0x00, 0x00, 0x00, 0x26, 0x00, 0x00, 0x00, 
-	0x41, 0x00, 0x05, 0x00, 0x28, 0x00, 0x00, 0x00,  0x29, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 
-	0x27, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x04, 0x00,  0x07, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00, 
-	0x29, 0x00, 0x00, 0x00, 0x51, 0x00, 0x05, 0x00,  0x06, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x00, 0x00, 
-	0x2a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x51, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x2c, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x50, 0x00, 0x07, 0x00, 
-	0x1d, 0x00, 0x00, 0x00, 0x2d, 0x00, 0x00, 0x00,  0x2b, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 
-	0x0d, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,  0x41, 0x00, 0x05, 0x00, 0x2e, 0x00, 0x00, 0x00, 
-	0x2f, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00,  0x24, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x03, 0x00, 
-	0x2f, 0x00, 0x00, 0x00, 0x2d, 0x00, 0x00, 0x00,  0x3d, 0x00, 0x04, 0x00, 0x23, 0x00, 0x00, 0x00, 
-	0x32, 0x00, 0x00, 0x00, 0x26, 0x00, 0x00, 0x00,  0x41, 0x00, 0x05, 0x00, 0x33, 0x00, 0x00, 0x00, 
-	0x34, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00,  0x32, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x04, 0x00, 
-	0x14, 0x00, 0x00, 0x00, 0x35, 0x00, 0x00, 0x00,  0x34, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x03, 0x00, 
-	0x31, 0x00, 0x00, 0x00, 0x35, 0x00, 0x00, 0x00,  0xfd, 0x00, 0x01, 0x00, 0x38, 0x00, 0x01, 0x00, 
+	0x14, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,  0x0b, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x48, 0x00, 0x05, 0x00, 0x14, 0x00, 0x00, 0x00,  0x03, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00, 
+	0x04, 0x00, 0x00, 0x00, 0x47, 0x00, 0x03, 0x00,  0x14, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x04, 0x00, 0x20, 0x00, 0x00, 0x00,  0x0b, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x04, 0x00, 0x21, 0x00, 0x00, 0x00,  0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x04, 0x00, 0x22, 0x00, 0x00, 0x00,  0x1e, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x04, 0x00, 0x23, 0x00, 0x00, 0x00,  0x1e, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
+	0x48, 0x00, 0x05, 0x00, 0x15, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x47, 0x00, 0x03, 0x00,  0x15, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x04, 0x00, 0x25, 0x00, 0x00, 0x00,  0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x04, 0x00, 0x26, 0x00, 0x00, 0x00,  0x1e, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x03, 0x00, 0x27, 0x00, 0x00, 0x00,  0x0e, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 
+	0x27, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00,  0x02, 0x00, 0x00, 0x00, 0x47, 0x00, 0x03, 0x00, 
+	0x28, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00,  0x47, 0x00, 0x04, 0x00, 0x28, 0x00, 0x00, 0x00, 
+	0x1e, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  0x13, 0x00, 0x02, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x21, 0x00, 0x03, 0x00, 0x04, 0x00, 0x00, 0x00,  0x03, 0x00, 0x00, 0x00, 0x16, 0x00, 0x03, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,  0x17, 0x00, 0x04, 0x00, 0x06, 0x00, 0x00, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,  0x17, 0x00, 0x04, 0x00, 0x07, 0x00, 0x00, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,  0x15, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 
+	0x20, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x15, 0x00, 0x04, 0x00, 0x09, 0x00, 0x00, 0x00, 
+	0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x2b, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 
+	0x0a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x2b, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00, 
+	0x0b, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x2b, 0x00, 0x04, 0x00, 0x09, 0x00, 0x00, 0x00, 
+	0x0c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x2b, 0x00, 0x04, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x2b, 0x00, 0x04, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x0e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3f,  0x2b, 0x00, 0x04, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x0f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0x3f,  0x2b, 0x00, 0x04, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40,  0x2c, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 
+	0x11, 0x00, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x00,  0x0f, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x05, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00,  0x0e, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 
+	0x1c, 0x00, 0x04, 0x00, 0x13, 0x00, 0x00, 0x00,  0x05, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 
+	0x1e, 0x00, 0x06, 0x00, 0x14, 0x00, 0x00, 0x00,  0x07, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x13, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00,  0x1e, 0x00, 0x03, 0x00, 0x15, 0x00, 0x00, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x16, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x14, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x17, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x07, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x18, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x19, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x1a, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x07, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x1b, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x1c, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x08, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x1d, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 
+	0x15, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x1e, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x16, 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 
+	0x03, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x1c, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 
+	0x01, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x1a, 0x00, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00, 
+	0x01, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x1a, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00, 
+	0x01, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x1b, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 
+	0x01, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x1d, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 
+	0x09, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x17, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 
+	0x03, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x18, 0x00, 0x00, 0x00, 0x26, 0x00, 0x00, 0x00, 
+	0x03, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x18, 0x00, 0x00, 0x00, 0x27, 0x00, 0x00, 0x00, 
+	0x03, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x19, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 
+	0x03, 0x00, 0x00, 0x00, 0x36, 0x00, 0x05, 0x00,  0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00,  0xf8, 0x00, 0x02, 0x00, 0x29, 0x00, 0x00, 0x00, 
+	0x3d, 0x00, 0x04, 0x00, 0x08, 0x00, 0x00, 0x00,  0x2a, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 
+	0xc7, 0x00, 0x05, 0x00, 0x08, 0x00, 0x00, 0x00,  0x2b, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00, 
+	0x0b, 0x00, 0x00, 0x00, 0x6f, 0x00, 0x04, 0x00,  0x05, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 
+	0x2b, 0x00, 0x00, 0x00, 0xc3, 0x00, 0x05, 0x00,  0x08, 0x00, 0x00, 0x00, 0x2d, 0x00, 0x00, 0x00, 
+	0x2a, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00,  0x6f, 0x00, 0x04, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x2e, 0x00, 0x00, 0x00, 0x2d, 0x00, 0x00, 0x00,  0x50, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 
+	0x2f, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00,  0x2e, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x04, 0x00, 
+	0x07, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00,  0x21, 0x00, 0x00, 0x00, 0x4f, 0x00, 0x07, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00,  0x30, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 
+	0x02, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  0x8e, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 
+	0x32, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00,  0x0e, 0x00, 0x00, 0x00, 0x4f, 0x00, 0x07, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x33, 0x00, 0x00, 0x00,  0x30, 0x00, 0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x85, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 
+	0x34, 0x00, 0x00, 0x00, 0x2f, 0x00, 0x00, 0x00,  0x31, 0x00, 0x00, 0x00, 0x81, 0x00, 0x05, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x35, 0x00, 0x00, 0x00,  0x33, 0x00, 0x00, 0x00, 0x34, 0x00, 0x00, 0x00, 
+	0x41, 0x00, 0x05, 0x00, 0x1e, 0x00, 0x00, 0x00,  0x36, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 
+	0x0a, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x04, 0x00,  0x06, 0x00, 0x00, 0x00, 0x37, 0x00, 0x00, 0x00, 
+	0x36, 0x00, 0x00, 0x00, 0x88, 0x00, 0x05, 0x00,  0x06, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00, 
+	0x35, 0x00, 0x00, 0x00, 0x37, 0x00, 0x00, 0x00,  0x8e, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 
+	0x39, 0x00, 0x00, 0x00, 0x38, 0x00, 0x00, 0x00,  0x10, 0x00, 0x00, 0x00, 0x83, 0x00, 0x05, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x3a, 0x00, 0x00, 0x00,  0x39, 0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 
+	0x51, 0x00, 0x05, 0x00, 0x05, 0x00, 0x00, 0x00,  0x3b, 0x00, 0x00, 0x00, 0x3a, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x51, 0x00, 0x05, 0x00,  0x05, 0x00, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x00, 
+	0x3a, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x50, 0x00, 0x07, 0x00, 0x07, 0x00, 0x00, 0x00, 
+	0x3d, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x00, 0x00,  0x3c, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 
+	0x0f, 0x00, 0x00, 0x00, 0x41, 0x00, 0x05, 0x00,  0x17, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x00, 0x00, 
+	0x1f, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00,  0x3e, 0x00, 0x03, 0x00, 0x3e, 0x00, 0x00, 0x00, 
+	0x3d, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x04, 0x00,  0x07, 0x00, 0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 
+	0x22, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x03, 0x00,  0x25, 0x00, 0x00, 0x00, 0x3f, 0x00, 0x00, 0x00, 
+	0x83, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00,  0x40, 0x00, 0x00, 0x00, 0x2f, 0x00, 0x00, 0x00, 
+	0x12, 0x00, 0x00, 0x00, 0x85, 0x00, 0x05, 0x00,  0x06, 0x00, 0x00, 0x00, 0x41, 0x00, 0x00, 0x00, 
+	0x40, 0x00, 0x00, 0x00, 0x31, 0x00, 0x00, 0x00,  0x3e, 0x00, 0x03, 0x00, 0x26, 0x00, 0x00, 0x00, 
+	0x41, 0x00, 0x00, 0x00, 0x3e, 0x00, 0x03, 0x00,  0x27, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 
+	0x3d, 0x00, 0x04, 0x00, 0x05, 0x00, 0x00, 0x00,  0x42, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 
+	0x51, 0x00, 0x05, 0x00, 0x05, 0x00, 0x00, 0x00,  0x43, 0x00, 0x00, 0x00, 0x32, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x51, 0x00, 0x05, 0x00,  0x05, 0x00, 0x00, 0x00, 0x44, 0x00, 0x00, 0x00, 
+	0x32, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x0c, 0x00, 0x07, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x45, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x25, 0x00, 0x00, 0x00, 0x43, 0x00, 0x00, 0x00, 
+	0x44, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x07, 0x00,  0x05, 0x00, 0x00, 0x00, 0x46, 0x00, 0x00, 0x00, 
+	0x01, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00,  0x42, 0x00, 0x00, 0x00, 0x45, 0x00, 0x00, 0x00, 
+	0x3e, 0x00, 0x03, 0x00, 0x28, 0x00, 0x00, 0x00,  0x46, 0x00, 0x00, 0x00, 0xfd, 0x00, 0x01, 0x00, 
+	0x38, 0x00, 0x01, 0x00, 
 };
 
 const unsigned long long int basic_shader_vert_size = sizeof(basic_shader_vert_data)/sizeof(char);
 
 
 const char basic_shader_frag_data[] = {
-	0x03, 0x02, 0x23, 0x07, 0x00, 0x00, 0x01, 0x00,  0x0b, 0x00, 0x0d, 0x00, 0x13, 0x00, 0x00, 0x00, 
+	0x03, 0x02, 0x23, 0x07, 0x00, 0x00, 0x01, 0x00,  0x00, 0x00, 0x00, 0x00, 0x2e, 0x00, 0x00, 0x00, 
 	0x00, 0x00, 0x00, 0x00, 0x11, 0x00, 0x02, 0x00,  0x01, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x06, 0x00, 
 	0x01, 0x00, 0x00, 0x00, 0x47, 0x4c, 0x53, 0x4c,  0x2e, 0x73, 0x74, 0x64, 0x2e, 0x34, 0x35, 0x30, 
 	0x00, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x03, 0x00,  0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
-	0x0f, 0x00, 0x07, 0x00, 0x04, 0x00, 0x00, 0x00,  0x04, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x69, 0x6e, 
-	0x00, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00,  0x0c, 0x00, 0x00, 0x00, 0x10, 0x00, 0x03, 0x00, 
-	0x04, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00,  0x03, 0x00, 0x03, 0x00, 0x02, 0x00, 0x00, 0x00, 
-	0xc2, 0x01, 0x00, 0x00, 0x04, 0x00, 0x0a, 0x00,  0x47, 0x4c, 0x5f, 0x47, 0x4f, 0x4f, 0x47, 0x4c, 
-	0x45, 0x5f, 0x63, 0x70, 0x70, 0x5f, 0x73, 0x74,  0x79, 0x6c, 0x65, 0x5f, 0x6c, 0x69, 0x6e, 0x65, 
-	0x5f, 0x64, 0x69, 0x72, 0x65, 0x63, 0x74, 0x69,  0x76, 0x65, 0x00, 0x00, 0x04, 0x00, 0x08, 0x00, 
-	0x47, 0x4c, 0x5f, 0x47, 0x4f, 0x4f, 0x47, 0x4c,  0x45, 0x5f, 0x69, 0x6e, 0x63, 0x6c, 0x75, 0x64, 
-	0x65, 0x5f, 0x64, 0x69, 0x72, 0x65, 0x63, 0x74,  0x69, 0x76, 0x65, 0x00, 0x05, 0x00, 0x04, 0x00, 
-	0x04, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x69, 0x6e,  0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x05, 0x00, 
-	0x09, 0x00, 0x00, 0x00, 0x6f, 0x75, 0x74, 0x43,  0x6f, 0x6c, 0x6f, 0x72, 0x00, 0x00, 0x00, 0x00, 
-	0x05, 0x00, 0x05, 0x00, 0x0c, 0x00, 0x00, 0x00,  0x66, 0x72, 0x61, 0x67, 0x43, 0x6f, 0x6c, 0x6f, 
-	0x72, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00,  0x09, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00,  0x0c, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x00, 0x00, 0x13, 0x00, 0x02, 0x00,  0x02, 0x00, 0x00, 0x00, 0x21, 0x00, 0x03, 0x00, 
-	0x03, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,  0x16, 0x00, 0x03, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x20, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00,  0x07, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x04, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x08, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
-	0x07, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x08, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 
-	0x03, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00,  0x0a, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x03, 0x00, 0x00, 0x00, 0x20, 0x00, 0x04, 0x00,  0x0b, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
-	0x0a, 0x00, 0x00, 0x00, 0x3b, 0x00, 0x04, 0x00,  0x0b, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 
-	0x01, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x04, 0x00,  0x06, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x80, 0x3f, 0x36, 0x00, 0x05, 0x00,  0x02, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,  0xf8, 0x00, 0x02, 0x00, 0x05, 0x00, 0x00, 0x00, 
-	0x3d, 0x00, 0x04, 0x00, 0x0a, 0x00, 0x00, 0x00,  0x0d, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00, 
-	0x51, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00,  0x0f, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00, 
-	0x00, 0x00, 0x00, 0x00, 0x51, 0x00, 0x05, 0x00,  0x06, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 
-	0x0d, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x51, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 
-	0x11, 0x00, 0x00, 0x00, 0x0d, 0x00, 0x00, 0x00,  0x02, 0x00, 0x00, 0x00, 0x50, 0x00, 0x07, 0x00, 
-	0x07, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00,  0x0f, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 
-	0x11, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00,  0x3e, 0x00, 0x03, 0x00, 0x09, 0x00, 0x00, 0x00, 
-	0x12, 0x00, 0x00, 0x00, 0xfd, 0x00, 0x01, 0x00,  0x38, 0x00, 0x01, 0x00, 
+	0x0f, 0x00, 0x0a, 0x00, 0x04, 0x00, 0x00, 0x00,  0x02, 0x00, 0x00, 0x00, 0x6d, 0x61, 0x69, 0x6e, 
+	0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,  0x11, 0x00, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 
+	0x13, 0x00, 0x00, 0x00, 0x14, 0x00, 0x00, 0x00,  0x10, 0x00, 0x03, 0x00, 0x02, 0x00, 0x00, 0x00, 
+	0x07, 0x00, 0x00, 0x00, 0x03, 0x00, 0x03, 0x00,  0x02, 0x00, 0x00, 0x00, 0xc2, 0x01, 0x00, 0x00, 
+	0x05, 0x00, 0x04, 0x00, 0x02, 0x00, 0x00, 0x00,  0x6d, 0x61, 0x69, 0x6e, 0x00, 0x00, 0x00, 0x00, 
+	0x05, 0x00, 0x05, 0x00, 0x10, 0x00, 0x00, 0x00,  0x66, 0x72, 0x61, 0x67, 0x43, 0x6f, 0x6c, 0x6f, 
+	0x72, 0x00, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00,  0x11, 0x00, 0x00, 0x00, 0x66, 0x72, 0x61, 0x67, 
+	0x50, 0x6f, 0x73, 0x69, 0x74, 0x69, 0x6f, 0x6e,  0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x06, 0x00, 
+	0x12, 0x00, 0x00, 0x00, 0x66, 0x72, 0x61, 0x67,  0x48, 0x61, 0x6c, 0x66, 0x53, 0x69, 0x7a, 0x65, 
+	0x00, 0x00, 0x00, 0x00, 0x05, 0x00, 0x07, 0x00,  0x13, 0x00, 0x00, 0x00, 0x66, 0x72, 0x61, 0x67, 
+	0x43, 0x6f, 0x72, 0x6e, 0x65, 0x72, 0x52, 0x61,  0x64, 0x69, 0x75, 0x73, 0x00, 0x00, 0x00, 0x00, 
+	0x05, 0x00, 0x05, 0x00, 0x14, 0x00, 0x00, 0x00,  0x6f, 0x75, 0x74, 0x43, 0x6f, 0x6c, 0x6f, 0x72, 
+	0x00, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00,  0x10, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00,  0x11, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00, 
+	0x01, 0x00, 0x00, 0x00, 0x47, 0x00, 0x03, 0x00,  0x12, 0x00, 0x00, 0x00, 0x0e, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x04, 0x00, 0x12, 0x00, 0x00, 0x00,  0x1e, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
+	0x47, 0x00, 0x03, 0x00, 0x13, 0x00, 0x00, 0x00,  0x0e, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 
+	0x13, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00,  0x03, 0x00, 0x00, 0x00, 0x47, 0x00, 0x04, 0x00, 
+	0x14, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00, 0x13, 0x00, 0x02, 0x00, 
+	0x03, 0x00, 0x00, 0x00, 0x21, 0x00, 0x03, 0x00,  0x04, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x16, 0x00, 0x03, 0x00, 0x05, 0x00, 0x00, 0x00,  0x20, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,  0x02, 0x00, 0x00, 0x00, 0x17, 0x00, 0x04, 0x00, 
+	0x07, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,  0x04, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x04, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x04, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00,  0x00, 0x00, 0x00, 0x3f, 0x2b, 0x00, 0x04, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00,  0x00, 0x00, 0x80, 0x3f, 0x2c, 0x00, 0x05, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x0b, 0x00, 0x00, 0x00,  0x08, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 
+	0x20, 0x00, 0x04, 0x00, 0x0c, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 
+	0x20, 0x00, 0x04, 0x00, 0x0d, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 
+	0x20, 0x00, 0x04, 0x00, 0x0e, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x20, 0x00, 0x04, 0x00, 0x0f, 0x00, 0x00, 0x00,  0x03, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 
+	0x3b, 0x00, 0x04, 0x00, 0x0c, 0x00, 0x00, 0x00,  0x10, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x3b, 0x00, 0x04, 0x00, 0x0d, 0x00, 0x00, 0x00,  0x11, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x3b, 0x00, 0x04, 0x00, 0x0d, 0x00, 0x00, 0x00,  0x12, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x3b, 0x00, 0x04, 0x00, 0x0e, 0x00, 0x00, 0x00,  0x13, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x3b, 0x00, 0x04, 0x00, 0x0f, 0x00, 0x00, 0x00,  0x14, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x36, 0x00, 0x05, 0x00, 0x03, 0x00, 0x00, 0x00,  0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+	0x04, 0x00, 0x00, 0x00, 0xf8, 0x00, 0x02, 0x00,  0x15, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x04, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x16, 0x00, 0x00, 0x00,  0x11, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x04, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00,  0x12, 0x00, 0x00, 0x00, 0x3d, 0x00, 0x04, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,  0x13, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x06, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x19, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 
+	0x16, 0x00, 0x00, 0x00, 0x83, 0x00, 0x05, 0x00,  0x06, 0x00, 0x00, 0x00, 0x1a, 0x00, 0x00, 0x00, 
+	0x19, 0x00, 0x00, 0x00, 0x17, 0x00, 0x00, 0x00,  0x50, 0x00, 0x05, 0x00, 0x06, 0x00, 0x00, 0x00, 
+	0x1b, 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00,  0x18, 0x00, 0x00, 0x00, 0x81, 0x00, 0x05, 0x00, 
+	0x06, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,  0x1a, 0x00, 0x00, 0x00, 0x1b, 0x00, 0x00, 0x00, 
+	0x0c, 0x00, 0x07, 0x00, 0x06, 0x00, 0x00, 0x00,  0x1d, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x28, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,  0x0b, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x06, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x1e, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x42, 0x00, 0x00, 0x00, 
+	0x1d, 0x00, 0x00, 0x00, 0x51, 0x00, 0x05, 0x00,  0x05, 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00, 
+	0x1c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  0x51, 0x00, 0x05, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x20, 0x00, 0x00, 0x00, 0x1c, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x07, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00,  0x01, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 
+	0x1f, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00,  0x0c, 0x00, 0x07, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x22, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x25, 0x00, 0x00, 0x00, 0x21, 0x00, 0x00, 0x00, 
+	0x08, 0x00, 0x00, 0x00, 0x81, 0x00, 0x05, 0x00,  0x05, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00, 
+	0x1e, 0x00, 0x00, 0x00, 0x22, 0x00, 0x00, 0x00,  0x83, 0x00, 0x05, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x24, 0x00, 0x00, 0x00, 0x23, 0x00, 0x00, 0x00,  0x18, 0x00, 0x00, 0x00, 0x83, 0x00, 0x05, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00,  0x09, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 
+	0x0c, 0x00, 0x08, 0x00, 0x05, 0x00, 0x00, 0x00,  0x26, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+	0x2b, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00,  0x08, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00, 
+	0x3d, 0x00, 0x04, 0x00, 0x07, 0x00, 0x00, 0x00,  0x27, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 
+	0x51, 0x00, 0x05, 0x00, 0x05, 0x00, 0x00, 0x00,  0x28, 0x00, 0x00, 0x00, 0x27, 0x00, 0x00, 0x00, 
+	0x00, 0x00, 0x00, 0x00, 0x51, 0x00, 0x05, 0x00,  0x05, 0x00, 0x00, 0x00, 0x29, 0x00, 0x00, 0x00, 
+	0x27, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,  0x51, 0x00, 0x05, 0x00, 0x05, 0x00, 0x00, 0x00, 
+	0x2a, 0x00, 0x00, 0x00, 0x27, 0x00, 0x00, 0x00,  0x02, 0x00, 0x00, 0x00, 0x51, 0x00, 0x05, 0x00, 
+	0x05, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x00, 0x00,  0x27, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+	0x85, 0x00, 0x05, 0x00, 0x05, 0x00, 0x00, 0x00,  0x2c, 0x00, 0x00, 0x00, 0x2b, 0x00, 0x00, 0x00, 
+	0x26, 0x00, 0x00, 0x00, 0x50, 0x00, 0x07, 0x00,  0x07, 0x00, 0x00, 0x00, 0x2d, 0x00, 0x00, 0x00, 
+	0x28, 0x00, 0x00, 0x00, 0x29, 0x00, 0x00, 0x00,  0x2a, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 
+	0x3e, 0x00, 0x03, 0x00, 0x14, 0x00, 0x00, 0x00,  0x2d, 0x00, 0x00, 0x00, 0xfd, 0x00, 0x01, 0x00, 
+	0x38, 0x00, 0x01, 0x00, 
 };
 
 const unsigned long long int basic_shader_frag_size = sizeof(basic_shader_frag_data)/sizeof(char);
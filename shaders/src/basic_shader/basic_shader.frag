@@ -1,9 +1,16 @@
 #version 450
 
-layout(location = 0) in vec3 fragColor;
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragPosition;
+layout(location = 2) in flat vec2 fragHalfSize;
+layout(location = 3) in flat float fragCornerRadius;
 
 layout(location = 0) out vec4 outColor;
 
 void main() {
-    outColor = vec4(fragColor, 1.0);
-}
\ No newline at end of file
+    // signed distance to the rounded rectangle, negative inside
+    vec2 q = abs(fragPosition) - fragHalfSize + fragCornerRadius;
+    float distance = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - fragCornerRadius;
+    float coverage = clamp(0.5 - distance, 0.0, 1.0);
+    outColor = vec4(fragColor.rgb, fragColor.a * coverage);
+}
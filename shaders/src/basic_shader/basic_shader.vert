@@ -1,21 +1,29 @@
 #version 450
 #extension GL_KHR_vulkan_glsl: enable
 
-layout(location = 0) out vec3 fragColor;
+// one instance per rectangle, the corners are generated from the vertex index
+layout(location = 0) in vec4 inRect;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in float inCornerRadius;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+layout(push_constant) uniform PushConstants {
+    vec2 viewportSize;
+} pushConstants;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragPosition;
+layout(location = 2) out flat vec2 fragHalfSize;
+layout(location = 3) out flat float fragCornerRadius;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
-}
\ No newline at end of file
+    // triangle strip: top left, top right, bottom left, bottom right
+    vec2 corner = vec2(gl_VertexIndex & 1, gl_VertexIndex >> 1);
+    vec2 halfSize = inRect.zw * 0.5;
+    vec2 position = inRect.xy + corner * inRect.zw;
+
+    gl_Position = vec4(position / pushConstants.viewportSize * 2.0 - 1.0, 0.0, 1.0);
+    fragColor = inColor;
+    fragPosition = (corner - 0.5) * inRect.zw;
+    fragHalfSize = halfSize;
+    fragCornerRadius = min(inCornerRadius, min(halfSize.x, halfSize.y));
+}
@@ -0,0 +1,86 @@
+#include "component.h"
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_components"
+
+void interfaceInitComponents(AvInterface interface) {
+	slotMapCreate(sizeof(Component_T), &interface->components);
+}
+
+void interfaceDeinitComponents(AvInterface interface) {
+	uint componentCount = slotMapGetSize(interface->components);
+	Component_T* components = slotMapGetData(interface->components);
+	for (uint i = 0; i < componentCount; i++) {
+		ComponentChildArrayDestroy(&components[i].children);
+	}
+	slotMapDestroy(interface->components);
+	interface->components = nullptr;
+}
+
+AvResult componentCreate(AvInterface interface, Component parent, Component* component) {
+
+	Component_T* parentData = nullptr;
+	if (!slotMapHandleIsNull(parent)) {
+		parentData = slotMapGet(parent, interface->components);
+		if (!parentData) {
+			avAssert(AV_INVALID_ARGUMENTS, AV_SUCCESS, "parent component does not exist");
+			return AV_INVALID_ARGUMENTS;
+		}
+	}
+
+	Component_T data = { 0 };
+	data.parent = parent;
+	ComponentChildArrayCreate(&data.children);
+	*component = slotMapInsert(&data, interface->components);
+
+	// insertion may have moved the parent
+	if (parentData) {
+		parentData = slotMapGet(parent, interface->components);
+		ComponentChildArrayAdd(*component, &parentData->children);
+	}
+
+	return AV_SUCCESS;
+}
+
+static void componentDestroyRecursive(AvInterface interface, Component component) {
+	Component_T* data = slotMapGet(component, interface->components);
+	if (!data) {
+		return;
+	}
+
+	// children are removed from the slot map first, which moves elements around,
+	// so take the child list out of the component before iterating it
+	ComponentChildArray children = data->children;
+	uint childCount = ComponentChildArrayGetSize(&children);
+	for (uint i = 0; i < childCount; i++) {
+		componentDestroyRecursive(interface, ComponentChildArrayGet(i, &children));
+	}
+	ComponentChildArrayDestroy(&children);
+
+	slotMapRemove(component, interface->components);
+}
+
+void componentDestroy(AvInterface interface, Component component) {
+	Component_T* data = slotMapGet(component, interface->components);
+	if (!data) {
+		avAssert(AV_INVALID_ARGUMENTS, AV_SUCCESS, "destroying component that does not exist");
+		return;
+	}
+
+	Component_T* parentData = slotMapHandleIsNull(data->parent) ? nullptr : slotMapGet(data->parent, interface->components);
+	if (parentData) {
+		uint childCount = ComponentChildArrayGetSize(&parentData->children);
+		for (uint i = 0; i < childCount; i++) {
+			if (slotMapHandleEquals(ComponentChildArrayGet(i, &parentData->children), component)) {
+				ComponentChildArrayRemove(i, &parentData->children);
+				break;
+			}
+		}
+	}
+
+	componentDestroyRecursive(interface, component);
+}
+
+Component_T* componentGet(AvInterface interface, Component component) {
+	return slotMapGet(component, interface->components);
+}
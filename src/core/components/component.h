@@ -1,6 +1,39 @@
 #pragma once
 #include "../core.h"
+#include "../util/slotMap.h"
+#include "../util/smallArray.h"
+
+// components are addressed through generational handles into the
+// component slot map of their interface
+typedef SlotMapHandle Component;
+
+#define COMPONENT_CHILD_INLINE_COUNT 8
+AV_DEFINE_SMALL_ARRAY(ComponentChildArray, Component, COMPONENT_CHILD_INLINE_COUNT)
+
+typedef struct Component_T {
+	Component parent;
+	ComponentChildArray children;
+} Component_T;
 
 typedef struct AvInterface_T {
-	int a;
-} AvInterface_T;
\ No newline at end of file
+	SlotMap components;
+} AvInterface_T;
+
+void interfaceInitComponents(AvInterface interface);
+void interfaceDeinitComponents(AvInterface interface);
+
+/// <summary>
+/// create a component, parent may be SLOT_MAP_HANDLE_NULL for root components
+/// </summary>
+AvResult componentCreate(AvInterface interface, Component parent, Component* component);
+
+/// <summary>
+/// destroys the component and all of its children
+/// </summary>
+void componentDestroy(AvInterface interface, Component component);
+
+/// <summary>
+/// returns nullptr when the component no longer exists.
+/// WARNING: the pointer is invalidated by creating or destroying components
+/// </summary>
+Component_T* componentGet(AvInterface interface, Component component);
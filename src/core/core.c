@@ -1,18 +1,58 @@
 #include "core.h"
+#include "logging/logConfig.h"
+#include "util/hash.h"
+#include <pthread.h>
+#include <stdint.h>
 
 #undef AV_LOG_CATEGORY
 #define AV_LOG_CATEGORY "avixel_core"
 
+// the allocation callbacks, memory tracking, pool, log clock and log outputs are shared by all instances.
+// the first instance sets them up and the last one tears them down
+static pthread_mutex_t instanceMutex = PTHREAD_MUTEX_INITIALIZER;
+static uint instanceCount = 0;
+
 AvResult avInstanceCreate(AvInstanceCreateInfo createInfo, AvInstance* pInstance) {
 
-	// log configuration
-	if (createInfo.logSettings) {
-		setLogSettings(*createInfo.logSettings);
+	pthread_mutex_lock(&instanceMutex);
+	bool firstInstance = instanceCount++ == 0;
+	if (firstInstance) {
+		// memory configuration, has to happen before the first allocation
+		setAllocationCallbacks(createInfo.allocationCallbacks);
+		if (createInfo.enableMemoryTracking) {
+			memoryTrackingInit();
+		}
+
+		// log configuration, the log queue is allocated through the allocation callbacks
+		startLogClock();
+		setProjectDetails(createInfo.projectInfo.pProjectName, createInfo.projectInfo.projectVersion);
+		if (createInfo.logSettings) {
+			setLogSettings(*createInfo.logSettings);
+		}
 	}
-	setProjectDetails(createInfo.projectInfo.pProjectName, createInfo.projectInfo.projectVersion);
+	pthread_mutex_unlock(&instanceMutex);
+	uint64 createStart = getLogTimestamp();
 
 	// allocate instance handle;
 	*pInstance = avAllocate(sizeof(AvInstance_T), 1, "allocating instance handle");
+	if (firstInstance) {
+		(*pInstance)->logConfig = atomic_load(&currentLogConfig);
+	} else {
+		// later instances log with their own settings and project details to the outputs of the first one
+		(*pInstance)->logConfig = createInstanceLogConfig(createInfo.logSettings, createInfo.projectInfo.pProjectName, createInfo.projectInfo.projectVersion);
+		(*pInstance)->ownsLogConfig = true;
+	}
+	const LogConfig* previousLogConfig = logConfigBind((*pInstance)->logConfig);
+	if (!firstInstance && (createInfo.allocationCallbacks || createInfo.enableMemoryTracking)) {
+		avLog(AV_DEBUG_INFO, "allocation callbacks and memory tracking are shared by all instances, the ones of the first instance are kept");
+	}
+
+	// per frame scratch memory
+	uint64 frameMemorySize = createInfo.frameMemorySize ? createInfo.frameMemorySize : AV_FRAME_MEMORY_SIZE_DEFAULT;
+	frameAllocatorCreate(MAX_FRAMES_IN_FLIGHT, frameMemorySize, &(*pInstance)->frameAllocator);
+	AvRectArrayCreate(&(*pInstance)->rects);
+	AvClipRectArrayCreate(&(*pInstance)->clipRects);
+	(*pInstance)->renderMode = createInfo.renderMode;
 
 	RendererType rendererType = getRendererType();
 	switch (rendererType) {
@@ -60,6 +100,8 @@ AvResult avInstanceCreate(AvInstanceCreateInfo createInfo, AvInstance* pInstance
 
 	RenderDeviceCreateInfo renderDeviceInfo = { 0 };
 	renderDeviceInfo.window = (*pInstance)->window;
+	renderDeviceInfo.pipelineCachePath = createInfo.pipelineCachePath;
+	renderDeviceInfo.disableDynamicRendering = createInfo.disableDynamicRendering;
 	renderDeviceCreate(*pInstance, renderDeviceInfo, &(*pInstance)->renderDevice);
 
 	renderDeviceCreateRenderResources((*pInstance)->renderDevice);
@@ -67,10 +109,13 @@ AvResult avInstanceCreate(AvInstanceCreateInfo createInfo, AvInstance* pInstance
 
 	renderDeviceCreatePipelines((*pInstance)->renderDevice, 0, nullptr);
 
+	avLogf(AV_TIME, "created instance in %.2fms", (double)(getLogTimestamp() - createStart) / 1000.0);
+	logConfigBind(previousLogConfig);
 	return AV_SUCCESS;
 }
 
 void avInstanceDestroy(AvInstance instance) {
+	const LogConfig* previousLogConfig = logConfigBind(instance->logConfig);
 
 	renderDeviceWaitIdle(instance->renderDevice);
 
@@ -84,21 +129,148 @@ void avInstanceDestroy(AvInstance instance) {
 
 	renderInstanceDestroy(instance);
 
+	frameAllocatorDestroy(instance->frameAllocator);
+	AvRectArrayDestroy(&instance->rects);
+	AvClipRectArrayDestroy(&instance->clipRects);
+
+	LogConfig* ownedLogConfig = instance->ownsLogConfig ? (LogConfig*)instance->logConfig : nullptr;
 	avFree(instance);
 
+	pthread_mutex_lock(&instanceMutex);
+	bool lastInstance = --instanceCount == 0;
+	if (lastInstance) {
+		// pool chunks came from the allocation callbacks, so they have to be released before those are reset
+		poolAllocatorDeinit();
+		memoryTrackingReportLeaks();
+		memoryTrackingDeinit();
+		releaseLogging();
+	}
+	logConfigBind(previousLogConfig);
+	// records queued under the settings of this instance may still be written by other instances
+	if (ownedLogConfig) {
+		logConfigRetire(ownedLogConfig);
+	}
+	if (lastInstance) {
+		// the next instance starts from the default settings again
+		logConfigReset();
+		logConfigReclaim();
+		setAllocationCallbacks(nullptr);
+	}
+	pthread_mutex_unlock(&instanceMutex);
+}
 
+// identifies what the queued commands draw, so unchanged frames can be skipped
+uint64 hashRenderCommands(AvInstance instance) {
+	uint64 rectHash = hashBytes(instance->rects.data, instance->rects.count * sizeof(AvRect));
+	uint64 clipRectHash = hashBytes(instance->clipRects.data, instance->clipRects.count * sizeof(AvClipRect));
+	return hashUint64(rectHash ^ hashUint64(clipRectHash));
 }
 
 void avUpdate(AvInstance instance) {
+	const LogConfig* previousLogConfig = logConfigBind(instance->logConfig);
+
+	// memory of the frame that used this allocator last is no longer in flight
+	frameAllocatorNextFrame(instance->frameAllocator);
+	flushExpiredLogSummaries();
+
+	// on demand mode only renders what differs from the last frame
+	bool frameNeeded = true;
+	uint64 hash = 0;
+	uint64 now = getLogTimestamp();
+	bool redrawDue = instance->scheduledRedraw && now >= instance->scheduledRedraw;
+	if (instance->renderMode == AV_RENDER_MODE_ON_DEMAND) {
+		hash = hashRenderCommands(instance);
+		frameNeeded = !instance->frameRendered || hash != instance->renderedHash ||
+			instance->redrawRequested || redrawDue ||
+			(windowGetStatus(instance->window) & DEVICE_STATUS_DAMAGED);
+	}
+
+	bool inoperable = windowGetStatus(instance->window) & DEVICE_STATUS_INOPERABLE;
+	bool rendered = false;
+	if (frameNeeded && !inoperable) {
+		RenderCommandsInfo commandsInfo = { 0 };
+		commandsInfo.rectCount = (uint)instance->rects.count;
+		commandsInfo.rects = instance->rects.data;
+		commandsInfo.clipRectCount = (uint)instance->clipRects.count;
+		commandsInfo.clipRects = instance->clipRects.data;
+		// no frame is rendered while the swapchain had to be recreated
+		if (renderDeviceAquireNextFrame(instance->renderDevice) == AV_SUCCESS) {
+			renderDeviceRecordRenderCommands(instance->renderDevice, commandsInfo);
+			renderDeviceRenderFrame(instance->renderDevice);
+			renderDevicePresent(instance->renderDevice);
+			rendered = true;
+		}
+	}
+	if (rendered) {
+		instance->renderedHash = hash;
+		instance->frameRendered = true;
+		instance->redrawRequested = false;
+		if (redrawDue) {
+			instance->scheduledRedraw = 0;
+		}
+		windowClearStatus(instance->window, DEVICE_STATUS_DAMAGED);
+	}
+	AvRectArrayClear(&instance->rects);
+	AvClipRectArrayClear(&instance->clipRects);
+
+	// without changes, or while minimized, block until an event or the scheduled redraw instead of spinning.
+	// after a rendered frame the next update may change again right away, so events are only polled
+	if (instance->renderMode == AV_RENDER_MODE_ON_DEMAND && !rendered && (!frameNeeded || inoperable)) {
+		uint64 timeout = UINT64_MAX;
+		if (instance->scheduledRedraw) {
+			now = getLogTimestamp();
+			timeout = instance->scheduledRedraw > now ? instance->scheduledRedraw - now : 0;
+		}
+		windowWaitEvents(instance->window, timeout);
+	} else {
+		windowUpdateEvents(instance->window);
+	}
+	logConfigBind(previousLogConfig);
+}
+
+void avSetRenderMode(AvInstance instance, AvRenderMode mode) {
+	instance->renderMode = mode;
+}
+
+void avRequestRedraw(AvInstance instance) {
+	instance->redrawRequested = true;
+}
+
+void avScheduleRedraw(AvInstance instance, uint delay) {
+	uint64 time = getLogTimestamp() + (uint64)delay * 1000;
+	if (instance->scheduledRedraw == 0 || time < instance->scheduledRedraw) {
+		instance->scheduledRedraw = time;
+	}
+}
 
-	if (!(windowGetStatus(instance->window) & DEVICE_STATUS_INOPERABLE)) {
-		RenderCommandsInfo commandsInfo = {};
-		renderDeviceAquireNextFrame(instance->renderDevice);
-		renderDeviceRecordRenderCommands(instance->renderDevice, commandsInfo);
-		renderDeviceRenderFrame(instance->renderDevice);
-		renderDevicePresent(instance->renderDevice);
+void avDrawRects(AvInstance instance, uint count, const AvRect* rects) {
+	if (count == 0) {
+		return;
 	}
-	windowUpdateEvents(instance->window);
+	AvRectArrayAddRange(rects, count, &instance->rects);
+}
+
+void avSetClipRects(AvInstance instance, uint count, const AvClipRect* clipRects) {
+	AvClipRectArrayClear(&instance->clipRects);
+	if (count == 0) {
+		return;
+	}
+	AvClipRectArrayAddRange(clipRects, count, &instance->clipRects);
+}
+
+void* avFrameAllocate(AvInstance instance, uint64 size, uint64 alignment) {
+	if (alignment & (alignment - 1)) {
+		avAssert(AV_INVALID_ARGUMENTS, AV_SUCCESS, "frame memory alignment must be a power of two");
+		return nullptr;
+	}
+	return frameAllocatorAllocate(size, alignment, instance->frameAllocator);
+}
+
+void avGetFrameMemoryStats(AvInstance instance, AvFrameMemoryStats* stats) {
+	stats->frameCount = frameAllocatorGetFrameCount(instance->frameAllocator);
+	stats->capacity = frameAllocatorGetCapacity(instance->frameAllocator);
+	stats->used = frameAllocatorGetUsed(instance->frameAllocator);
+	stats->highWaterMark = frameAllocatorGetHighWaterMark(instance->frameAllocator);
 }
 
 bool avShutdownRequested(AvInstance instance) {
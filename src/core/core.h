@@ -1,23 +1,47 @@
 #pragma once
 #define AV_LOG_CATEGORY "avixel"
 #include <avixel/avixel.h>
+#include "memory/memory.h"
+#include "memory/poolAllocator.h"
+#include "memory/memoryTracker.h"
 #include "util/util.h"
 #include "logging/logging.h"
 #include "renderer/renderer.h"
 #include "positioner/positioner.h"
-#include "components/component.h"
+#include "memory/frameAllocator.h"
+#include "util/typedArray.h"
 
 typedef struct RenderInstance_T* RenderInstance;
 typedef struct RenderDevice_T* RenderDevice;
 typedef struct DisplaySurface_T* DisplaySurface;
 typedef struct Window_T* Window;
 typedef struct Pipeline_T* Pipeline;
+typedef struct FrameAllocator_T* FrameAllocator;
+
+AV_DEFINE_ARRAY(AvRect)
+AV_DEFINE_ARRAY(AvClipRect)
 
 typedef struct AvInstance_T {
 	DisplaySurface displaySurface;
 	RenderInstance renderInstance;
 	Window window;
 	RenderDevice renderDevice;
+	FrameAllocator frameAllocator;
+	// queued for the next frame, the arrays keep their memory between frames
+	AvRectArray rects;
+	AvClipRectArray clipRects;
+
+	AvRenderMode renderMode;
+	// hash of the rectangles the last frame drew, on demand mode only renders when it changes
+	uint64 renderedHash;
+	bool frameRendered;
+	bool redrawRequested;
+	// log timestamp a redraw is scheduled for, 0 when none is
+	uint64 scheduledRedraw;
+	// log settings the instance was created with, bound to the calling thread by the instance functions
+	const struct LogConfig* logConfig;
+	// logConfig was built for this instance instead of being the published snapshot, it is retired on destruction
+	bool ownsLogConfig;
 }AvInstance_T;
 
 typedef struct AvWindow_T {
@@ -0,0 +1,399 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+// strnlen
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "logArgs.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_logging"
+
+typedef enum LogArgType {
+	LOG_ARG_TYPE_NONE,
+	LOG_ARG_TYPE_SIGNED,
+	LOG_ARG_TYPE_UNSIGNED,
+	LOG_ARG_TYPE_CHAR,
+	LOG_ARG_TYPE_DOUBLE,
+	LOG_ARG_TYPE_STRING,
+	LOG_ARG_TYPE_POINTER,
+	// %n, consumed but never written to
+	LOG_ARG_TYPE_IGNORED,
+} LogArgType;
+
+typedef enum LogArgLength {
+	LOG_ARG_LENGTH_DEFAULT,
+	LOG_ARG_LENGTH_CHAR,
+	LOG_ARG_LENGTH_SHORT,
+	LOG_ARG_LENGTH_LONG,
+	LOG_ARG_LENGTH_LONG_LONG,
+	LOG_ARG_LENGTH_INTMAX,
+	LOG_ARG_LENGTH_SIZE,
+	LOG_ARG_LENGTH_PTRDIFF,
+	LOG_ARG_LENGTH_LONG_DOUBLE,
+} LogArgLength;
+
+// one conversion of a format string
+typedef struct FormatSpec {
+	// literal text preceding the conversion
+	const char* text;
+	uint64 textLength;
+	// the conversion without its length modifier, e.g. "%-*.3" followed by conversion
+	const char* flags;
+	uint64 flagsLength;
+	char conversion;
+	LogArgType type;
+	LogArgLength length;
+	uint starCount;
+	// -1 when there is none, the precision is the last star argument when precisionStar is set
+	int precision;
+	bool precisionStar;
+} FormatSpec;
+
+// parses the conversion following *format and advances past it, returns false at the end of the string
+static bool nextFormatSpec(const char** format, FormatSpec* spec) {
+	const char* str = *format;
+	memset(spec, 0, sizeof(FormatSpec));
+	spec->precision = -1;
+	spec->text = str;
+	while (*str) {
+		if (str[0] == '%' && str[1] != '%') {
+			break;
+		}
+		str += (str[0] == '%') ? 2 : 1;
+	}
+	spec->textLength = (uint64)(str - spec->text);
+	if (*str == '\0') {
+		*format = str;
+		return spec->textLength != 0;
+	}
+
+	spec->flags = str++;
+	while (*str && strchr("-+ #0'", *str)) {
+		str++;
+	}
+	if (*str == '*') {
+		spec->starCount++;
+		str++;
+	} else {
+		while (*str >= '0' && *str <= '9') {
+			str++;
+		}
+	}
+	if (*str == '.') {
+		str++;
+		if (*str == '*') {
+			spec->starCount++;
+			spec->precisionStar = true;
+			str++;
+		} else {
+			// a lone '.' is a precision of 0
+			spec->precision = 0;
+			while (*str >= '0' && *str <= '9') {
+				if (spec->precision <= (INT32_MAX - 9) / 10) {
+					spec->precision = spec->precision * 10 + (*str - '0');
+				}
+				str++;
+			}
+		}
+	}
+	spec->flagsLength = (uint64)(str - spec->flags);
+
+	switch (*str) {
+	case 'h':
+		spec->length = (str[1] == 'h') ? LOG_ARG_LENGTH_CHAR : LOG_ARG_LENGTH_SHORT;
+		str += (str[1] == 'h') ? 2 : 1;
+		break;
+	case 'l':
+		spec->length = (str[1] == 'l') ? LOG_ARG_LENGTH_LONG_LONG : LOG_ARG_LENGTH_LONG;
+		str += (str[1] == 'l') ? 2 : 1;
+		break;
+	case 'q':
+		spec->length = LOG_ARG_LENGTH_LONG_LONG;
+		str++;
+		break;
+	case 'j':
+		spec->length = LOG_ARG_LENGTH_INTMAX;
+		str++;
+		break;
+	case 'z':
+		spec->length = LOG_ARG_LENGTH_SIZE;
+		str++;
+		break;
+	case 't':
+		spec->length = LOG_ARG_LENGTH_PTRDIFF;
+		str++;
+		break;
+	case 'L':
+		spec->length = LOG_ARG_LENGTH_LONG_DOUBLE;
+		str++;
+		break;
+	}
+
+	spec->conversion = *str;
+	switch (*str) {
+	case 'd': case 'i':
+		spec->type = LOG_ARG_TYPE_SIGNED;
+		break;
+	case 'o': case 'u': case 'x': case 'X':
+		spec->type = LOG_ARG_TYPE_UNSIGNED;
+		break;
+	case 'c':
+		spec->type = LOG_ARG_TYPE_CHAR;
+		break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+		spec->type = LOG_ARG_TYPE_DOUBLE;
+		break;
+	case 's':
+		spec->type = LOG_ARG_TYPE_STRING;
+		break;
+	case 'p':
+		spec->type = LOG_ARG_TYPE_POINTER;
+		break;
+	case 'n':
+		spec->type = LOG_ARG_TYPE_IGNORED;
+		break;
+	default:
+		// unknown conversion or end of string, printed as is
+		spec->type = LOG_ARG_TYPE_NONE;
+		break;
+	}
+	if (*str) {
+		str++;
+	}
+	*format = str;
+	return true;
+}
+
+#define WRITE_ARG(value) do {							\
+	if (size + sizeof(value) <= capacity) {				\
+		memcpy(buffer + size, &(value), sizeof(value));	\
+	}													\
+	size += sizeof(value);								\
+} while (0)
+
+uint64 logArgsCapture(const char* format, va_list args, byte* buffer, uint64 capacity) {
+	uint64 size = 0;
+	FormatSpec spec;
+	while (nextFormatSpec(&format, &spec)) {
+		for (uint i = 0; i < spec.starCount; i++) {
+			int star = va_arg(args, int);
+			WRITE_ARG(star);
+			if (spec.precisionStar && i == spec.starCount - 1) {
+				// a negative precision is taken as if it was omitted
+				spec.precision = star < 0 ? -1 : star;
+			}
+		}
+
+		switch (spec.type) {
+		case LOG_ARG_TYPE_SIGNED: {
+			long long value;
+			switch (spec.length) {
+			case LOG_ARG_LENGTH_CHAR: value = (signed char)va_arg(args, int); break;
+			case LOG_ARG_LENGTH_SHORT: value = (short)va_arg(args, int); break;
+			case LOG_ARG_LENGTH_LONG: value = va_arg(args, long); break;
+			case LOG_ARG_LENGTH_LONG_LONG: value = va_arg(args, long long); break;
+			case LOG_ARG_LENGTH_INTMAX: value = (long long)va_arg(args, intmax_t); break;
+			case LOG_ARG_LENGTH_SIZE: value = (long long)va_arg(args, size_t); break;
+			case LOG_ARG_LENGTH_PTRDIFF: value = (long long)va_arg(args, ptrdiff_t); break;
+			default: value = va_arg(args, int); break;
+			}
+			WRITE_ARG(value);
+			break;
+		}
+		case LOG_ARG_TYPE_UNSIGNED: {
+			unsigned long long value;
+			switch (spec.length) {
+			case LOG_ARG_LENGTH_CHAR: value = (unsigned char)va_arg(args, unsigned int); break;
+			case LOG_ARG_LENGTH_SHORT: value = (unsigned short)va_arg(args, unsigned int); break;
+			case LOG_ARG_LENGTH_LONG: value = va_arg(args, unsigned long); break;
+			case LOG_ARG_LENGTH_LONG_LONG: value = va_arg(args, unsigned long long); break;
+			case LOG_ARG_LENGTH_INTMAX: value = (unsigned long long)va_arg(args, uintmax_t); break;
+			case LOG_ARG_LENGTH_SIZE: value = (unsigned long long)va_arg(args, size_t); break;
+			case LOG_ARG_LENGTH_PTRDIFF: value = (unsigned long long)va_arg(args, ptrdiff_t); break;
+			default: value = va_arg(args, unsigned int); break;
+			}
+			WRITE_ARG(value);
+			break;
+		}
+		case LOG_ARG_TYPE_CHAR: {
+			int value = va_arg(args, int);
+			WRITE_ARG(value);
+			break;
+		}
+		case LOG_ARG_TYPE_DOUBLE: {
+			double value = (spec.length == LOG_ARG_LENGTH_LONG_DOUBLE) ? (double)va_arg(args, long double) : va_arg(args, double);
+			WRITE_ARG(value);
+			break;
+		}
+		case LOG_ARG_TYPE_STRING: {
+			const char* str;
+			if (spec.length == LOG_ARG_LENGTH_LONG) {
+				// wide strings are not converted, the argument still has to be consumed so the following ones line up
+				(void)va_arg(args, const wchar_t*);
+				str = "(wide string)";
+			} else {
+				str = va_arg(args, const char*);
+			}
+			if (str == nullptr) {
+				str = "(null)";
+			}
+			// with a precision the string does not have to be null terminated, nothing past it is read
+			uint64 stringLength = spec.precision >= 0 ? strnlen(str, (size_t)spec.precision) : strlen(str);
+			uint32 length = (uint32)stringLength + 1;
+			WRITE_ARG(length);
+			if (size + length <= capacity) {
+				memcpy(buffer + size, str, stringLength);
+				buffer[size + stringLength] = '\0';
+			}
+			size += length;
+			break;
+		}
+		case LOG_ARG_TYPE_POINTER:
+		case LOG_ARG_TYPE_IGNORED: {
+			void* value = va_arg(args, void*);
+			WRITE_ARG(value);
+			break;
+		}
+		case LOG_ARG_TYPE_NONE:
+			break;
+		}
+	}
+	return size;
+}
+
+#undef WRITE_ARG
+
+#define READ_ARG(value) do {									\
+	if (offset + sizeof(value) <= argsSize) {					\
+		memcpy(&(value), args + offset, sizeof(value));			\
+	}															\
+	offset += sizeof(value);									\
+} while (0)
+
+// appends to the output like snprintf, keeping track of the full length
+static void appendFormatted(char* buffer, uint64 capacity, uint64* length, const char* format, ...) {
+	char* out = (*length < capacity) ? buffer + *length : nullptr;
+	uint64 remaining = (*length < capacity) ? capacity - *length : 0;
+	va_list args;
+	va_start(args, format);
+	int written = vsnprintf(out, (size_t)remaining, format, args);
+	va_end(args);
+	if (written > 0) {
+		*length += (uint64)written;
+	}
+}
+
+// appends text as is, collapsing %% in to %
+static void appendLiteral(char* buffer, uint64 capacity, uint64* length, const char* text, uint64 textLength) {
+	for (uint64 i = 0; i < textLength; i++) {
+		if (text[i] == '%' && i + 1 < textLength && text[i + 1] == '%') {
+			i++;
+		}
+		if (*length + 1 < capacity) {
+			buffer[*length] = text[i];
+			buffer[*length + 1] = '\0';
+		}
+		(*length)++;
+	}
+}
+
+#define APPEND_VALUE(value) do {																			\
+	if (spec.starCount == 2) appendFormatted(buffer, capacity, &length, conversion, stars[0], stars[1], value);	\
+	else if (spec.starCount == 1) appendFormatted(buffer, capacity, &length, conversion, stars[0], value);		\
+	else appendFormatted(buffer, capacity, &length, conversion, value);										\
+} while (0)
+
+uint64 logArgsFormat(const char* format, const byte* args, uint64 argsSize, char* buffer, uint64 capacity) {
+	uint64 length = 0;
+	uint64 offset = 0;
+	if (capacity) {
+		buffer[0] = '\0';
+	}
+
+	FormatSpec spec;
+	while (nextFormatSpec(&format, &spec)) {
+		appendLiteral(buffer, capacity, &length, spec.text, spec.textLength);
+		if (spec.flags == nullptr) {
+			continue;
+		}
+
+		int stars[2] = { 0 };
+		for (uint i = 0; i < spec.starCount; i++) {
+			READ_ARG(stars[i]);
+		}
+
+		// rebuild the conversion with a length modifier matching the captured type, long doubles were captured as doubles
+		char conversion[64];
+		uint64 flagsLength = spec.flagsLength < 48 ? spec.flagsLength : 48;
+		memcpy(conversion, spec.flags, flagsLength);
+		const char* modifier = "";
+		if (spec.type == LOG_ARG_TYPE_SIGNED || spec.type == LOG_ARG_TYPE_UNSIGNED) {
+			modifier = "ll";
+		}
+		snprintf(conversion + flagsLength, sizeof(conversion) - flagsLength, "%s%c", modifier, spec.conversion);
+
+		switch (spec.type) {
+		case LOG_ARG_TYPE_SIGNED: {
+			long long value = 0;
+			READ_ARG(value);
+			APPEND_VALUE(value);
+			break;
+		}
+		case LOG_ARG_TYPE_UNSIGNED: {
+			unsigned long long value = 0;
+			READ_ARG(value);
+			APPEND_VALUE(value);
+			break;
+		}
+		case LOG_ARG_TYPE_CHAR: {
+			int value = 0;
+			READ_ARG(value);
+			APPEND_VALUE(value);
+			break;
+		}
+		case LOG_ARG_TYPE_DOUBLE: {
+			double value = 0;
+			READ_ARG(value);
+			APPEND_VALUE(value);
+			break;
+		}
+		case LOG_ARG_TYPE_STRING: {
+			uint32 stringLength = 0;
+			READ_ARG(stringLength);
+			const char* value = "(truncated)";
+			if (stringLength && offset + stringLength <= argsSize) {
+				value = (const char*)args + offset;
+			}
+			offset += stringLength;
+			APPEND_VALUE(value);
+			break;
+		}
+		case LOG_ARG_TYPE_POINTER: {
+			void* value = nullptr;
+			READ_ARG(value);
+			APPEND_VALUE(value);
+			break;
+		}
+		case LOG_ARG_TYPE_IGNORED: {
+			void* value;
+			READ_ARG(value);
+			break;
+		}
+		case LOG_ARG_TYPE_NONE: {
+			// print an unknown conversion literally
+			appendLiteral(buffer, capacity, &length, spec.flags, spec.flagsLength);
+			if (spec.conversion) {
+				appendLiteral(buffer, capacity, &length, &spec.conversion, 1);
+			}
+			break;
+		}
+		}
+	}
+	return length;
+}
+
+#undef APPEND_VALUE
+#undef READ_ARG
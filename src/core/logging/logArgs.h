@@ -0,0 +1,24 @@
+#pragma once
+#include "../core.h"
+#include <stdarg.h>
+
+// Capturing and replaying printf style arguments.
+//
+// avLogf does not format its message on the calling thread. The arguments are
+// copied in to a compact byte buffer following the conversions of the format
+// string, strings are copied by value. The writer formats the message later by
+// replaying the buffer against the same format string, which therefore has to
+// be a string literal.
+//
+// Integers are widened to 64 bits and long doubles narrowed to doubles while
+// capturing, wide characters and wide strings are not supported. %n is ignored.
+
+/// <summary>
+/// copies the arguments of format in to buffer. Returns the number of bytes needed, nothing is written when that exceeds capacity
+/// </summary>
+uint64 logArgsCapture(const char* format, va_list args, byte* buffer, uint64 capacity);
+
+/// <summary>
+/// formats captured arguments like snprintf, returns the length of the full message excluding the null terminator
+/// </summary>
+uint64 logArgsFormat(const char* format, const byte* args, uint64 argsSize, char* buffer, uint64 capacity);
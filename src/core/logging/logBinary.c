@@ -0,0 +1,129 @@
+#include "logBinary.h"
+#include "../util/hashMap.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_logging"
+
+#define LOG_BINARY_BUFFER_SIZE (64 * 1024)
+
+static FILE* binaryLogFile = nullptr;
+static atomic_bool binaryLogOpened = false;
+// records are written from the log writer thread, or from any thread when logging synchronously
+static pthread_mutex_t binaryLogMutex = PTHREAD_MUTEX_INITIALIZER;
+// maps string addresses to the id they were written with
+static HashMap stringIds = nullptr;
+static uint32 nextStringId = 1;
+
+bool binaryLogOpen(const char* path, const char* projectName, uint projectVersion) {
+	binaryLogClose();
+
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr) {
+		avLogf(AV_IO_ERROR, "failed to open binary log file %s", path);
+		return false;
+	}
+	setvbuf(file, nullptr, _IOFBF, LOG_BINARY_BUFFER_SIZE);
+
+	LogBinaryHeader header = { 0 };
+	memcpy(header.magic, LOG_BINARY_MAGIC, sizeof(header.magic));
+	header.version = LOG_BINARY_VERSION;
+	header.projectVersion = projectVersion;
+	strncpy(header.projectName, projectName, LOG_BINARY_PROJECT_NAME_SIZE - 1);
+	getLogClockBase(&header.timestampStart, &header.wallClockStart);
+	if (fwrite(&header, sizeof(LogBinaryHeader), 1, file) != 1) {
+		fclose(file);
+		avLogf(AV_IO_ERROR, "failed to write binary log file %s", path);
+		return false;
+	}
+
+	HashMapCreateInfo createInfo = { 0 };
+	createInfo.keySize = sizeof(const char*);
+	createInfo.valueSize = sizeof(uint32);
+	createInfo.allocator = &untrackedAllocator;
+	createInfo.initialCapacity = 256;
+
+	pthread_mutex_lock(&binaryLogMutex);
+	hashMapCreate(createInfo, &stringIds);
+	nextStringId = 1;
+	binaryLogFile = file;
+	atomic_store(&binaryLogOpened, true);
+	pthread_mutex_unlock(&binaryLogMutex);
+	return true;
+}
+
+void binaryLogClose() {
+	if (!atomic_exchange(&binaryLogOpened, false)) {
+		return;
+	}
+	pthread_mutex_lock(&binaryLogMutex);
+	fclose(binaryLogFile);
+	binaryLogFile = nullptr;
+	hashMapDestroy(stringIds);
+	stringIds = nullptr;
+	pthread_mutex_unlock(&binaryLogMutex);
+}
+
+bool binaryLogIsOpen() {
+	return atomic_load_explicit(&binaryLogOpened, memory_order_relaxed);
+}
+
+// has to be called with the binary log locked, writes the string the first time it is seen
+static uint32 getStringId(const char* str) {
+	if (str == nullptr) {
+		return 0;
+	}
+	uint32* id = hashMapGet(&str, stringIds);
+	if (id) {
+		return *id;
+	}
+
+	LogBinaryString entry;
+	entry.id = nextStringId++;
+	entry.length = (uint32)strlen(str);
+	byte type = LOG_BINARY_ENTRY_TYPE_STRING;
+	fwrite(&type, 1, 1, binaryLogFile);
+	fwrite(&entry, sizeof(LogBinaryString), 1, binaryLogFile);
+	fwrite(str, 1, entry.length, binaryLogFile);
+
+	hashMapInsert(&str, &entry.id, stringIds);
+	return entry.id;
+}
+
+void binaryLogWrite(const LogRecord* record) {
+	pthread_mutex_lock(&binaryLogMutex);
+	if (binaryLogFile == nullptr) {
+		pthread_mutex_unlock(&binaryLogMutex);
+		return;
+	}
+
+	LogBinaryMessage message;
+	message.timestamp = record->timestamp;
+	message.recordType = record->type;
+	message.result = record->result;
+	message.line = (uint32)record->line;
+	message.fileId = getStringId(record->file);
+	message.funcId = getStringId(record->func);
+	message.categoryId = getStringId(record->category);
+
+	const void* payload;
+	if (record->args) {
+		message.formatId = getStringId(record->message);
+		message.payloadSize = (uint32)record->argsSize;
+		payload = record->args;
+	} else {
+		// the message text may live on the stack of the caller, so it is written every time
+		message.formatId = 0;
+		message.payloadSize = (uint32)strlen(record->message) + 1;
+		payload = record->message;
+	}
+
+	byte type = LOG_BINARY_ENTRY_TYPE_MESSAGE;
+	fwrite(&type, 1, 1, binaryLogFile);
+	fwrite(&message, sizeof(LogBinaryMessage), 1, binaryLogFile);
+	fwrite(payload, 1, message.payloadSize, binaryLogFile);
+	pthread_mutex_unlock(&binaryLogMutex);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "../core.h"
+
+// Compact binary log output, decoded in to the text format by tools/logDecoder.
+//
+// A message is written as its timestamp, result code, line, the ids of its
+// file, function, category and format strings and the raw captured arguments.
+// Strings are written once, the first time their address is seen, so file,
+// function, category and format strings have to be static. Plain avLog messages
+// have no format and store their text as the payload instead.
+//
+// Values are stored in the byte order of the machine that wrote the log.
+
+#define LOG_BINARY_MAGIC "AVLOGBIN"
+#define LOG_BINARY_VERSION 2
+#define LOG_BINARY_PROJECT_NAME_SIZE 64
+
+typedef struct LogBinaryHeader {
+	char magic[8];
+	uint32 version;
+	uint32 projectVersion;
+	char projectName[LOG_BINARY_PROJECT_NAME_SIZE];
+	// wall clock microseconds and log timestamp at the start of the instance, used to convert timestamps back to a time of day
+	uint64 wallClockStart;
+	uint64 timestampStart;
+} LogBinaryHeader;
+
+// every entry starts with a one byte LogBinaryEntryType
+typedef enum LogBinaryEntryType {
+	LOG_BINARY_ENTRY_TYPE_STRING = 1,
+	LOG_BINARY_ENTRY_TYPE_MESSAGE = 2,
+} LogBinaryEntryType;
+
+// followed by length bytes of the string, without null terminator
+typedef struct LogBinaryString {
+	uint32 id;
+	uint32 length;
+} LogBinaryString;
+
+// followed by payloadSize bytes, the captured arguments when formatId is set and the null terminated message otherwise.
+// string id 0 stands for a missing string
+typedef struct LogBinaryMessage {
+	uint64 timestamp;
+	uint32 recordType;
+	uint32 result;
+	uint32 line;
+	uint32 fileId;
+	uint32 funcId;
+	uint32 categoryId;
+	uint32 formatId;
+	uint32 payloadSize;
+} LogBinaryMessage;
+
+/// <summary>
+/// starts writing binary log messages to path, returns false when the file can not be opened
+/// </summary>
+bool binaryLogOpen(const char* path, const char* projectName, uint projectVersion);
+
+void binaryLogClose();
+
+bool binaryLogIsOpen();
+
+void binaryLogWrite(const LogRecord* record);
@@ -0,0 +1,130 @@
+#include "logConfig.h"
+#include <pthread.h>
+#include <string.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_logging"
+
+// used until the first settings are published, nothing is filtered by category
+static LogConfig defaultLogConfig = {
+	.level = AV_LOG_LEVEL_DEFAULT,
+	.validationLevel = AV_VALIDATION_LEVEL_DEFAULT,
+	.assertLevel = AV_ASSERT_LEVEL_DEFAULT,
+	.printLine = AV_LOG_LINE_DEFAULT,
+	.printFile = AV_LOG_FILE_DEFAULT,
+	.printFunc = AV_LOG_FUNC_DEFAULT,
+	.printProject = AV_LOG_PROJECT_DEFAULT,
+	.printTime = AV_LOG_TIME_DEFAULT,
+	.printType = AV_LOG_TYPE_DEFAULT,
+	.printError = AV_LOG_ERROR_DEFAULT,
+	.printAssert = AV_LOG_ASSERT_DEFAULT,
+	.printCode = AV_LOG_CODE_DEFAULT,
+	.printCategory = AV_LOG_CATEGORY_DEFAULT,
+	.timeFormat = AV_LOG_TIME_FORMAT_DEFAULT,
+	.projectName = "PROJECT_NAME_NOT_SPECIFIED",
+	.projectVersion = 0,
+	.rateLimitInterval = AV_LOG_RATE_LIMIT_INTERVAL_DEFAULT * 1000,
+	.rateLimitCount = 0,
+};
+
+_Atomic(LogConfig*) currentLogConfig = &defaultLogConfig;
+_Thread_local const LogConfig* boundLogConfig = nullptr;
+
+// publishing is rare, so the retired list is simply guarded by a mutex
+static pthread_mutex_t retiredMutex = PTHREAD_MUTEX_INITIALIZER;
+static LogConfig* retiredLogConfigs = nullptr;
+
+static LogConfig* allocateLogConfig() {
+	LogConfig* config = untrackedAllocator.allocate(sizeof(LogConfig), untrackedAllocator.userData);
+	if (config == nullptr) {
+		avAssert(AV_MEMORY_ERROR, AV_SUCCESS, "failed to allocate log settings");
+	}
+	return config;
+}
+
+// the installed callbacks can be replaced before the snapshot is released
+static void recordLogConfigAllocator(LogConfig* config) {
+	const AvAllocationCallbacks* callbacks = getAllocationCallbacks();
+	config->customAllocation = callbacks != nullptr;
+	if (callbacks) {
+		config->allocationCallbacks = *callbacks;
+	} else {
+		memset(&config->allocationCallbacks, 0, sizeof(AvAllocationCallbacks));
+	}
+}
+
+static void freeLogConfig(LogConfig* config) {
+	untrackedFreeWithCallbacks(config, config->customAllocation ? &config->allocationCallbacks : nullptr);
+}
+
+LogConfig* logConfigCreate(const AvLogSettings* settings) {
+	const LogConfig* current = atomic_load_explicit(&currentLogConfig, memory_order_acquire);
+	LogConfig* config = allocateLogConfig();
+	config->level = settings->level;
+	config->validationLevel = settings->validationLevel;
+	config->assertLevel = settings->assertLevel;
+	config->printLine = settings->printLine;
+	config->printFile = settings->printFile;
+	config->printFunc = settings->printFunc;
+	config->printProject = settings->printProject;
+	config->printTime = settings->printTime;
+	config->printType = settings->printType;
+	config->printError = settings->printError;
+	config->printAssert = settings->printAssert;
+	config->printCode = settings->printCode;
+	config->printCategory = settings->printCategory;
+	config->timeFormat = settings->timeFormat;
+	memcpy(config->projectName, current->projectName, sizeof(config->projectName));
+	config->projectVersion = current->projectVersion;
+	logFilterBuild(settings, &config->filter);
+	config->rateLimitInterval = (uint64)(settings->rateLimitInterval ? settings->rateLimitInterval : AV_LOG_RATE_LIMIT_INTERVAL_DEFAULT) * 1000;
+	config->rateLimitCount = logRateLimitsBuild(settings, config->rateLimits);
+	recordLogConfigAllocator(config);
+	config->nextRetired = nullptr;
+	return config;
+}
+
+LogConfig* logConfigCopy(const LogConfig* config) {
+	LogConfig* copy = allocateLogConfig();
+	memcpy(copy, config, sizeof(LogConfig));
+	recordLogConfigAllocator(copy);
+	copy->nextRetired = nullptr;
+	return copy;
+}
+
+void logConfigRetire(LogConfig* config) {
+	if (config == &defaultLogConfig) {
+		return;
+	}
+	pthread_mutex_lock(&retiredMutex);
+	config->nextRetired = retiredLogConfigs;
+	retiredLogConfigs = config;
+	pthread_mutex_unlock(&retiredMutex);
+}
+
+void logConfigPublish(LogConfig* config) {
+	logConfigRetire(atomic_exchange_explicit(&currentLogConfig, config, memory_order_acq_rel));
+}
+
+void logConfigReset() {
+	logConfigPublish(&defaultLogConfig);
+}
+
+const LogConfig* logConfigBind(const LogConfig* config) {
+	const LogConfig* previous = boundLogConfig;
+	boundLogConfig = config;
+	return previous;
+}
+
+void logConfigReclaim() {
+	pthread_mutex_lock(&retiredMutex);
+	LogConfig* config = retiredLogConfigs;
+	retiredLogConfigs = nullptr;
+	pthread_mutex_unlock(&retiredMutex);
+
+	while (config) {
+		LogConfig* next = config->nextRetired;
+		freeLogConfig(config);
+		config = next;
+	}
+}
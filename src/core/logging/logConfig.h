@@ -0,0 +1,98 @@
+#pragma once
+#include "../core.h"
+#include "logFilter.h"
+#include "logRateLimit.h"
+#include <stdatomic.h>
+
+// Immutable snapshots of the log settings.
+//
+// Changing the settings builds a new snapshot and publishes it with a single
+// atomic pointer swap. A logging thread loads the snapshot once per message and
+// keeps using it, queued records keep a pointer to the snapshot they were
+// logged under, so no locks are taken to read the settings. Every instance
+// keeps the snapshot it was created with and binds it to the calling thread for
+// the duration of its functions, so instances on different threads log with
+// their own settings.
+//
+// Replaced snapshots are retired instead of freed, they are released once the
+// last instance is destroyed and nothing can be reading them anymore. Each
+// snapshot remembers the allocation callbacks it was allocated with and is
+// freed through those.
+
+#define LOG_PROJECT_NAME_SIZE 64
+
+typedef struct LogConfig {
+	AvLogLevel level;
+	AvValidationLevel validationLevel;
+	AvAssertLevel assertLevel;
+	bool printLine;
+	bool printFile;
+	bool printFunc;
+	bool printProject;
+	bool printTime;
+	bool printType;
+	bool printError;
+	bool printAssert;
+	bool printCode;
+	bool printCategory;
+	AvLogTimeFormat timeFormat;
+	char projectName[LOG_PROJECT_NAME_SIZE];
+	uint projectVersion;
+	LogFilter filter;
+	// in microseconds
+	uint64 rateLimitInterval;
+	uint32 rateLimitCount;
+	LogRateLimit rateLimits[LOG_RATE_LIMIT_MAX_COUNT];
+	// callbacks the snapshot was allocated with, only valid when customAllocation is set
+	AvAllocationCallbacks allocationCallbacks;
+	bool customAllocation;
+	// next snapshot in the retired list
+	struct LogConfig* nextRetired;
+} LogConfig;
+
+extern _Atomic(LogConfig*) currentLogConfig;
+extern _Thread_local const LogConfig* boundLogConfig;
+
+/// <summary>
+/// builds a snapshot from settings, the project details are taken from the current snapshot
+/// </summary>
+LogConfig* logConfigCreate(const AvLogSettings* settings);
+
+/// <summary>
+/// copies a snapshot so it can be changed before it is published
+/// </summary>
+LogConfig* logConfigCopy(const LogConfig* config);
+
+/// <summary>
+/// makes config the snapshot of threads without a bound snapshot, the previous one is retired
+/// </summary>
+void logConfigPublish(LogConfig* config);
+
+/// <summary>
+/// adds a snapshot that was never published to the retired list, it stays valid until logConfigReclaim
+/// </summary>
+void logConfigRetire(LogConfig* config);
+
+/// <summary>
+/// makes the default settings the published snapshot again, the previous one is retired
+/// </summary>
+void logConfigReset();
+
+/// <summary>
+/// makes the calling thread log with config, nullptr makes it follow the published snapshot again.
+/// returns the previously bound snapshot, to be restored when the caller is done
+/// </summary>
+const LogConfig* logConfigBind(const LogConfig* config);
+
+/// <summary>
+/// releases the retired snapshots, only safe when no thread is logging and no records are queued
+/// </summary>
+void logConfigReclaim();
+
+/// <summary>
+/// the snapshot the calling thread logs with
+/// </summary>
+static inline const LogConfig* logConfigGet() {
+	const LogConfig* config = boundLogConfig;
+	return config ? config : atomic_load_explicit(&currentLogConfig, memory_order_acquire);
+}
@@ -0,0 +1,93 @@
+#include "logFilter.h"
+#include "../util/hash.h"
+#include "../util/spinWait.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_logging"
+
+#define LOG_CATEGORY_TABLE_SIZE (LOG_CATEGORY_MAX_COUNT * 2)
+
+// the registry is static and lives as long as the process, call sites keep their ids after an instance is destroyed
+static char categoryNames[LOG_CATEGORY_MAX_COUNT][LOG_CATEGORY_NAME_SIZE];
+static uint categoryCount = 1;
+// open addressing table of category ids, 0 marks an empty slot
+static uint32 categoryTable[LOG_CATEGORY_TABLE_SIZE];
+static atomic_flag registryLock = ATOMIC_FLAG_INIT;
+
+static inline void lockRegistry() {
+	uint spins = 1;
+	while (atomic_flag_test_and_set_explicit(&registryLock, memory_order_acquire)) {
+		spinWait(&spins);
+	}
+}
+
+static inline void unlockRegistry() {
+	atomic_flag_clear_explicit(&registryLock, memory_order_release);
+}
+
+uint logCategoryRegister(const char* category) {
+	uint64 length = strlen(category);
+	if (length >= LOG_CATEGORY_NAME_SIZE) {
+		length = LOG_CATEGORY_NAME_SIZE - 1;
+	}
+	uint64 slot = hashBytes(category, length) & (LOG_CATEGORY_TABLE_SIZE - 1);
+
+	lockRegistry();
+	uint id;
+	while ((id = categoryTable[slot]) != 0) {
+		if (strncmp(categoryNames[id], category, length) == 0 && categoryNames[id][length] == '\0') {
+			unlockRegistry();
+			return id;
+		}
+		slot = (slot + 1) & (LOG_CATEGORY_TABLE_SIZE - 1);
+	}
+
+	if (categoryCount >= LOG_CATEGORY_ID_OVERFLOW) {
+		unlockRegistry();
+		return LOG_CATEGORY_ID_OVERFLOW;
+	}
+	id = categoryCount++;
+	memcpy(categoryNames[id], category, length);
+	categoryNames[id][length] = '\0';
+	categoryTable[slot] = id;
+	unlockRegistry();
+	return id;
+}
+
+uint logCategoryResolve(AvLogCallSite* callSite, const char* category) {
+	if (callSite == nullptr) {
+		return logCategoryRegister(category);
+	}
+	// racing threads resolve to the same id, so the cache is only accessed atomically to keep it tear free
+	uint id = __atomic_load_n(&callSite->categoryId, __ATOMIC_RELAXED);
+	if (id == 0) {
+		id = logCategoryRegister(category);
+		__atomic_store_n(&callSite->categoryId, id, __ATOMIC_RELAXED);
+	}
+	return id;
+}
+
+void logFilterBuild(const AvLogSettings* settings, LogFilter* filter) {
+	memset(filter, 0, sizeof(LogFilter));
+
+	for (uint i = 0; i < settings->disabledCategoryCount; i++) {
+		uint id = logCategoryRegister(settings->disabledCategories[i]);
+		if (id == LOG_CATEGORY_ID_OVERFLOW) {
+			avAssert(AV_OUT_OF_BOUNDS, AV_SUCCESS, "too many log categories, category can not be disabled");
+			continue;
+		}
+		filter->disabledCategories[id / 64] |= 1ULL << (id % 64);
+	}
+
+	for (uint i = 0; i < settings->disabledMessageCount; i++) {
+		AvResult result = settings->disabledMessages[i];
+		uint code = (uint)result & 0xFFFF;
+		if (code >= LOG_RESULT_CODES_PER_LEVEL) {
+			avAssert(AV_OUT_OF_BOUNDS, AV_SUCCESS, "result code can not be disabled");
+			continue;
+		}
+		filter->disabledResults[logResultLevel(result)] |= 1ULL << code;
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "../core.h"
+
+// Constant time filtering of log messages by category and result code.
+//
+// Category names are registered once and mapped to small integer ids, every
+// avLog call site caches the id of its category in its AvLogCallSite. Disabled
+// categories and disabled result codes are kept in bitsets, so deciding whether
+// a message is filtered out costs a couple of bit tests.
+
+#define LOG_CATEGORY_MAX_COUNT 256
+// longer category names are compared on this many characters
+#define LOG_CATEGORY_NAME_SIZE 64
+// categories registered after all ids are taken share this id and can not be disabled
+#define LOG_CATEGORY_ID_OVERFLOW (LOG_CATEGORY_MAX_COUNT - 1)
+
+// result codes are indexed per level, with 64 codes per level
+#define LOG_RESULT_LEVEL_COUNT 5
+#define LOG_RESULT_CODES_PER_LEVEL 64
+
+typedef struct LogFilter {
+	uint64 disabledCategories[LOG_CATEGORY_MAX_COUNT / 64];
+	uint64 disabledResults[LOG_RESULT_LEVEL_COUNT];
+} LogFilter;
+
+/// <summary>
+/// returns the id of a category, registering it on first use. Ids start at 1
+/// </summary>
+uint logCategoryRegister(const char* category);
+
+/// <summary>
+/// returns the cached category id of a call site, resolving it on the first call. callSite may be nullptr
+/// </summary>
+uint logCategoryResolve(AvLogCallSite* callSite, const char* category);
+
+/// <summary>
+/// builds the bitsets from the disabled categories and messages of the settings
+/// </summary>
+void logFilterBuild(const AvLogSettings* settings, LogFilter* filter);
+
+static inline bool logCategoryDisabled(const LogFilter* filter, uint categoryId) {
+	return (filter->disabledCategories[categoryId / 64] >> (categoryId % 64)) & 1;
+}
+
+static inline uint logResultLevel(AvResult result) {
+	return (uint)result >= (uint)AV_ERROR ? 4 :
+		(uint)result >= (uint)AV_WARNING ? 3 :
+		(uint)result >= (uint)AV_INFO ? 2 :
+		(uint)result >= (uint)AV_DEBUG ? 1 : 0;
+}
+
+static inline bool logResultDisabled(const LogFilter* filter, AvResult result) {
+	uint code = (uint)result & 0xFFFF;
+	if (code >= LOG_RESULT_CODES_PER_LEVEL) {
+		return false;
+	}
+	return (filter->disabledResults[logResultLevel(result)] >> code) & 1;
+}
@@ -0,0 +1,262 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+// clock_gettime and pthread_cond_timedwait
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "logQueue.h"
+#include "logConfig.h"
+#include "logRateLimit.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_logging"
+
+// number of records written before the output is flushed
+#define LOG_QUEUE_BATCH_SIZE 64
+// the writer also wakes up on its own, in case a wake up was missed
+#define LOG_QUEUE_IDLE_TIMEOUT_NS (100 * 1000 * 1000)
+
+typedef struct LogQueueSlot {
+	// equal to the enqueue position when the slot is free, one higher when it holds a record
+	atomic_size_t sequence;
+	LogRecord record;
+	// the message, or the captured arguments of a formatted message
+	byte* heapData;
+	byte data[LOG_QUEUE_INLINE_DATA_SIZE];
+} LogQueueSlot;
+
+static LogQueueSlot* slots = nullptr;
+static size_t slotMask = 0;
+static AvLogBackpressure queueBackpressure = AV_LOG_BACKPRESSURE_BLOCK;
+
+static atomic_size_t enqueuePosition = 0;
+static size_t dequeuePosition = 0;
+
+static atomic_bool running = false;
+static atomic_bool stopRequested = false;
+// producers that may still be writing in to the queue, the queue is only released once this is zero
+static atomic_uint activeProducers = 0;
+static atomic_uint_least64_t droppedRecords = 0;
+
+static pthread_t writerThread;
+static pthread_mutex_t writerMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writerCondition = PTHREAD_COND_INITIALIZER;
+static atomic_bool writerWaiting = false;
+
+static void wakeWriter() {
+	if (atomic_load(&writerWaiting)) {
+		pthread_mutex_lock(&writerMutex);
+		pthread_cond_signal(&writerCondition);
+		pthread_mutex_unlock(&writerMutex);
+	}
+}
+
+// only called from the writer thread
+static bool popRecord() {
+	LogQueueSlot* slot = &slots[dequeuePosition & slotMask];
+	size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+	if (sequence != dequeuePosition + 1) {
+		return false;
+	}
+
+	const byte* data = slot->heapData ? slot->heapData : slot->data;
+	if (slot->record.args) {
+		slot->record.args = data;
+	} else {
+		slot->record.message = (const char*)data;
+	}
+	writeLogRecord(&slot->record);
+	if (slot->heapData) {
+		untrackedAllocator.free(slot->heapData, untrackedAllocator.userData);
+		slot->heapData = nullptr;
+	}
+
+	atomic_store_explicit(&slot->sequence, dequeuePosition + slotMask + 1, memory_order_release);
+	dequeuePosition++;
+	return true;
+}
+
+static void reportDroppedRecords() {
+	uint64 dropped = atomic_exchange(&droppedRecords, 0);
+	if (dropped == 0) {
+		return;
+	}
+	char message[128];
+	snprintf(message, sizeof(message), "%llu log messages were dropped because the log queue was full", dropped);
+	LogRecord record = { 0 };
+	record.config = logConfigGet();
+	record.type = LOG_RECORD_TYPE_LOG;
+	record.result = AV_TIMEOUT;
+	record.line = __LINE__;
+	record.file = __FILE__;
+	record.func = __func__;
+	record.category = AV_LOG_CATEGORY;
+	record.timestamp = getLogTimestamp();
+	record.message = message;
+	writeLogRecord(&record);
+}
+
+static void waitForRecords() {
+	pthread_mutex_lock(&writerMutex);
+	atomic_store(&writerWaiting, true);
+	// recheck after announcing the wait, a producer that published before this point did not signal
+	LogQueueSlot* slot = &slots[dequeuePosition & slotMask];
+	if (atomic_load(&slot->sequence) != dequeuePosition + 1 && !atomic_load(&stopRequested)) {
+		struct timespec timeout;
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += LOG_QUEUE_IDLE_TIMEOUT_NS;
+		if (timeout.tv_nsec >= 1000000000) {
+			timeout.tv_sec++;
+			timeout.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&writerCondition, &writerMutex, &timeout);
+	}
+	atomic_store(&writerWaiting, false);
+	pthread_mutex_unlock(&writerMutex);
+}
+
+static void* writerMain(void* userData) {
+	while (true) {
+		uint written = 0;
+		while (written < LOG_QUEUE_BATCH_SIZE && popRecord()) {
+			written++;
+		}
+		reportDroppedRecords();
+		if (written) {
+			flushLogOutput();
+			continue;
+		}
+		// producers have all left once stop is requested, so an empty queue stays empty
+		if (atomic_load(&stopRequested)) {
+			break;
+		}
+		// call sites that stopped logging don't report what they held back on their own
+		if (logRateLimitFlushExpired(logConfigGet()->rateLimitInterval, writeLogRecord)) {
+			flushLogOutput();
+		}
+		waitForRecords();
+	}
+	return nullptr;
+}
+
+void logQueueStart(uint capacity, AvLogBackpressure backpressure) {
+	if (atomic_load(&running)) {
+		logQueueStop();
+	}
+
+	size_t slotCount = 2;
+	while (slotCount < capacity) {
+		slotCount <<= 1;
+	}
+	slots = untrackedAllocator.allocate(sizeof(LogQueueSlot) * slotCount, untrackedAllocator.userData);
+	if (slots == nullptr) {
+		avLog(AV_MEMORY_ERROR, "failed to allocate log queue, logging synchronously");
+		return;
+	}
+	for (size_t i = 0; i < slotCount; i++) {
+		atomic_init(&slots[i].sequence, i);
+		slots[i].heapData = nullptr;
+	}
+	slotMask = slotCount - 1;
+	queueBackpressure = backpressure;
+	atomic_store(&enqueuePosition, 0);
+	dequeuePosition = 0;
+	atomic_store(&droppedRecords, 0);
+	atomic_store(&stopRequested, false);
+
+	if (pthread_create(&writerThread, nullptr, writerMain, nullptr)) {
+		untrackedAllocator.free(slots, untrackedAllocator.userData);
+		slots = nullptr;
+		avLog(AV_CREATION_ERROR, "failed to start log writer thread, logging synchronously");
+		return;
+	}
+	atomic_store(&running, true);
+}
+
+void logQueueStop() {
+	if (!atomic_exchange(&running, false)) {
+		return;
+	}
+	// new producers now write synchronously, wait for the ones already inside
+	while (atomic_load(&activeProducers)) {
+		sched_yield();
+	}
+
+	pthread_mutex_lock(&writerMutex);
+	atomic_store(&stopRequested, true);
+	pthread_cond_signal(&writerCondition);
+	pthread_mutex_unlock(&writerMutex);
+	pthread_join(writerThread, nullptr);
+
+	untrackedAllocator.free(slots, untrackedAllocator.userData);
+	slots = nullptr;
+}
+
+static LogQueueSlot* claimSlot() {
+	size_t position = atomic_load_explicit(&enqueuePosition, memory_order_relaxed);
+	while (true) {
+		LogQueueSlot* slot = &slots[position & slotMask];
+		size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+		if (difference == 0) {
+			if (atomic_compare_exchange_weak_explicit(&enqueuePosition, &position, position + 1, memory_order_relaxed, memory_order_relaxed)) {
+				return slot;
+			}
+		} else if (difference < 0) {
+			// the writer has not released this slot yet, the queue is full
+			return nullptr;
+		} else {
+			position = atomic_load_explicit(&enqueuePosition, memory_order_relaxed);
+		}
+	}
+}
+
+bool logQueuePush(const LogRecord* record) {
+	atomic_fetch_add(&activeProducers, 1);
+	if (!atomic_load(&running)) {
+		atomic_fetch_sub(&activeProducers, 1);
+		return false;
+	}
+
+	LogQueueSlot* slot = claimSlot();
+	while (slot == nullptr) {
+		if (queueBackpressure == AV_LOG_BACKPRESSURE_DROP) {
+			atomic_fetch_add_explicit(&droppedRecords, 1, memory_order_relaxed);
+			atomic_fetch_sub(&activeProducers, 1);
+			return true;
+		}
+		wakeWriter();
+		sched_yield();
+		slot = claimSlot();
+	}
+
+	slot->record = *record;
+	const void* data = record->args ? (const void*)record->args : (const void*)record->message;
+	uint64 size = record->args ? record->argsSize : strlen(record->message) + 1;
+	if (size <= LOG_QUEUE_INLINE_DATA_SIZE) {
+		memcpy(slot->data, data, size);
+	} else {
+		slot->heapData = untrackedAllocator.allocate(size, untrackedAllocator.userData);
+		if (slot->heapData) {
+			memcpy(slot->heapData, data, size);
+		} else if (record->args) {
+			// the formatter reports the arguments that are missing
+			slot->record.argsSize = 0;
+		} else {
+			// keep what fits rather than losing the message
+			memcpy(slot->data, data, LOG_QUEUE_INLINE_DATA_SIZE - 1);
+			slot->data[LOG_QUEUE_INLINE_DATA_SIZE - 1] = '\0';
+		}
+	}
+
+	size_t position = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+	atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+	atomic_fetch_sub(&activeProducers, 1);
+	wakeWriter();
+	return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "../core.h"
+
+// Bounded multi producer single consumer queue between the threads that log and
+// a background writer thread.
+//
+// Producers claim a slot with a single compare and swap and copy their record
+// in to it, no locks are taken on the logging thread. The writer thread formats
+// the records in batches and flushes the output once per batch. When the queue
+// is full the producer either drops the record or waits for a free slot,
+// depending on the backpressure setting. Dropped records are counted and
+// reported by the writer.
+
+// messages and captured arguments up to this size are stored in the slot itself, larger ones are copied to the heap
+#define LOG_QUEUE_INLINE_DATA_SIZE 192
+
+/// <summary>
+/// starts the writer thread, capacity is rounded up to a power of two
+/// </summary>
+void logQueueStart(uint capacity, AvLogBackpressure backpressure);
+
+/// <summary>
+/// writes every queued record and stops the writer thread. Records pushed afterwards are rejected
+/// </summary>
+void logQueueStop();
+
+/// <summary>
+/// returns false when the writer thread is not running, the caller has to write the record itself
+/// </summary>
+bool logQueuePush(const LogRecord* record);
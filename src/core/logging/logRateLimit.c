@@ -0,0 +1,186 @@
+#include "logRateLimit.h"
+#include "logFilter.h"
+#include "logConfig.h"
+#include "../util/spinWait.h"
+#include <stdio.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_logging"
+
+// call sites that held back a message at some point, linked through nextRegistered
+static AvLogCallSite* _Atomic registeredCallSites = nullptr;
+
+static inline void lockCallSite(AvLogCallSite* callSite) {
+	uint spins = 1;
+	while (__atomic_exchange_n(&callSite->lock, 1, __ATOMIC_ACQUIRE)) {
+		spinWait(&spins);
+	}
+}
+
+static inline void unlockCallSite(AvLogCallSite* callSite) {
+	__atomic_store_n(&callSite->lock, 0, __ATOMIC_RELEASE);
+}
+
+uint32 logRateLimitsBuild(const AvLogSettings* settings, LogRateLimit limits[LOG_RATE_LIMIT_MAX_COUNT]) {
+	uint32 count = 0;
+	for (uint i = 0; i < settings->rateLimitCount; i++) {
+		if (count == LOG_RATE_LIMIT_MAX_COUNT) {
+			avAssert(AV_OUT_OF_BOUNDS, AV_SUCCESS, "too many log rate limits, the remaining limits are ignored");
+			break;
+		}
+		const AvLogRateLimit* rateLimit = &settings->rateLimits[i];
+		LogRateLimit* limit = &limits[count++];
+		limit->categoryId = rateLimit->category ? logCategoryRegister(rateLimit->category) : 0;
+		limit->result = rateLimit->result;
+		limit->maxMessages = rateLimit->maxMessages;
+		limit->coalesce = rateLimit->coalesce;
+	}
+	return count;
+}
+
+const LogRateLimit* logRateLimitFind(const LogRateLimit* limits, uint32 limitCount, uint categoryId, AvResult result) {
+	for (uint32 i = 0; i < limitCount; i++) {
+		const LogRateLimit* limit = &limits[i];
+		if ((limit->categoryId == 0 || limit->categoryId == categoryId) && (limit->result == AV_LOG_RATE_LIMIT_ANY_RESULT || limit->result == (uint32)result)) {
+			return limit;
+		}
+	}
+	return nullptr;
+}
+
+// has to be called with the call site locked
+static void registerCallSite(AvLogCallSite* callSite, const LogRecord* record) {
+	callSite->recordType = record->type;
+	callSite->result = record->result;
+	callSite->line = record->line;
+	callSite->file = record->file;
+	callSite->func = record->func;
+	callSite->category = record->category;
+	if (callSite->registered) {
+		return;
+	}
+	callSite->registered = true;
+	AvLogCallSite* head = atomic_load(&registeredCallSites);
+	do {
+		callSite->nextRegistered = head;
+	} while (!atomic_compare_exchange_weak(&registeredCallSites, &head, callSite));
+}
+
+// has to be called with the call site locked, returns false when nothing was held back
+static bool takeSummary(AvLogCallSite* callSite, uint64 now, LogRecord* summary, char* summaryText) {
+	if (callSite->repeats == 0 && callSite->suppressed == 0) {
+		return false;
+	}
+	double repeatSeconds = (double)(now - callSite->lastMessageTime) / 1000000.0;
+	double windowSeconds = (double)(now - callSite->windowStart) / 1000000.0;
+	if (callSite->repeats && callSite->suppressed) {
+		snprintf(summaryText, LOG_RATE_LIMIT_SUMMARY_SIZE, "previous message repeated %u times in %.1fs, %u other messages suppressed", callSite->repeats, repeatSeconds, callSite->suppressed);
+	} else if (callSite->repeats) {
+		snprintf(summaryText, LOG_RATE_LIMIT_SUMMARY_SIZE, "previous message repeated %u times in %.1fs", callSite->repeats, repeatSeconds);
+	} else {
+		snprintf(summaryText, LOG_RATE_LIMIT_SUMMARY_SIZE, "%u messages suppressed in %.1fs", callSite->suppressed, windowSeconds);
+	}
+	callSite->repeats = 0;
+	callSite->suppressed = 0;
+
+	summary->type = (LogRecordType)callSite->recordType;
+	summary->result = callSite->result;
+	summary->line = callSite->line;
+	summary->file = callSite->file;
+	summary->func = callSite->func;
+	summary->category = callSite->category;
+	summary->timestamp = now;
+	summary->message = summaryText;
+	summary->args = nullptr;
+	summary->argsSize = 0;
+	return true;
+}
+
+uint32 logRateLimitAdmit(AvLogCallSite* callSite, const LogRateLimit* limit, uint64 interval, const LogRecord* record, uint64 hash, LogRecord* summary, char* summaryText) {
+	uint64 now = record->timestamp;
+	uint32 result = 0;
+
+	lockCallSite(callSite);
+	// another thread may have taken its timestamp later but entered first
+	if (now < callSite->lastMessageTime) {
+		now = callSite->lastMessageTime;
+	}
+	if (now < callSite->windowStart) {
+		now = callSite->windowStart;
+	}
+	bool repeated = limit->coalesce && callSite->hasLastMessage && hash == callSite->lastMessageHash;
+	// what was held back is reported once the interval is over, or right away when a different message follows repetitions
+	bool windowOver = now - callSite->windowStart >= interval;
+	bool repeatsOver = callSite->repeats && (!repeated || now - callSite->lastMessageTime >= interval);
+	if ((windowOver || repeatsOver) && takeSummary(callSite, now, summary, summaryText)) {
+		summary->config = record->config;
+		result |= LOG_RATE_LIMIT_SUMMARY;
+		if (repeated) {
+			callSite->lastMessageTime = now;
+		}
+	}
+	if (windowOver) {
+		callSite->windowStart = now;
+		callSite->windowCount = 0;
+	}
+
+	if (repeated) {
+		callSite->repeats++;
+		registerCallSite(callSite, record);
+	} else if (limit->maxMessages && callSite->windowCount >= limit->maxMessages) {
+		callSite->suppressed++;
+		registerCallSite(callSite, record);
+	} else {
+		callSite->windowCount++;
+		callSite->hasLastMessage = true;
+		callSite->lastMessageHash = hash;
+		callSite->lastMessageTime = now;
+		result |= LOG_RATE_LIMIT_WRITE;
+	}
+	unlockCallSite(callSite);
+	return result;
+}
+
+void logRateLimitFlush(void (*submit)(const LogRecord* summary)) {
+	uint64 now = getLogTimestamp();
+	for (AvLogCallSite* callSite = atomic_load(&registeredCallSites); callSite; callSite = callSite->nextRegistered) {
+		LogRecord summary;
+		char summaryText[LOG_RATE_LIMIT_SUMMARY_SIZE];
+		lockCallSite(callSite);
+		bool pending = takeSummary(callSite, now, &summary, summaryText);
+		unlockCallSite(callSite);
+		if (pending) {
+			summary.config = logConfigGet();
+			submit(&summary);
+		}
+	}
+}
+
+bool logRateLimitFlushExpired(uint64 interval, void (*submit)(const LogRecord* summary)) {
+	bool submitted = false;
+	for (AvLogCallSite* callSite = atomic_load(&registeredCallSites); callSite; callSite = callSite->nextRegistered) {
+		LogRecord summary;
+		char summaryText[LOG_RATE_LIMIT_SUMMARY_SIZE];
+		// the timestamp is taken with the lock held, a message admitted in between can't be later
+		lockCallSite(callSite);
+		uint64 now = getLogTimestamp();
+		bool windowOver = now - callSite->windowStart >= interval;
+		bool repeatsOver = callSite->repeats && now - callSite->lastMessageTime >= interval;
+		bool pending = (windowOver || repeatsOver) && takeSummary(callSite, now, &summary, summaryText);
+		// the same as when the next message of the call site had taken the summary
+		if (repeatsOver) {
+			callSite->lastMessageTime = now;
+		}
+		if (windowOver) {
+			callSite->windowStart = now;
+			callSite->windowCount = 0;
+		}
+		unlockCallSite(callSite);
+		if (pending) {
+			summary.config = logConfigGet();
+			submit(&summary);
+			submitted = true;
+		}
+	}
+	return submitted;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "../core.h"
+
+// Per call site rate limiting and coalescing of repeated messages.
+//
+// A call site that matches a rate limit writes at most maxMessages per
+// interval, and with coalescing consecutive identical messages are only
+// counted. What was held back is reported in a single summary message once the
+// interval is over or the message changes, e.g. "previous message repeated
+// 1532 times in 1.0s". Call sites that ever held back a message are kept in a
+// list, so the summaries of call sites that stopped logging can be written
+// once their interval is over, and the pending ones when logging shuts down.
+
+#define LOG_RATE_LIMIT_MAX_COUNT 16
+// summaries are formatted in to a buffer of this size
+#define LOG_RATE_LIMIT_SUMMARY_SIZE 128
+
+typedef struct LogRateLimit {
+	// 0 matches every category
+	uint categoryId;
+	uint32 result;
+	uint32 maxMessages;
+	bool coalesce;
+} LogRateLimit;
+
+typedef enum LogRateLimitResultBits {
+	// the message has to be written
+	LOG_RATE_LIMIT_WRITE = 1 << 0,
+	// the summary record has to be written before the message
+	LOG_RATE_LIMIT_SUMMARY = 1 << 1,
+} LogRateLimitResultBits;
+
+/// <summary>
+/// resolves the rate limits of the settings, returns the number of limits written to limits
+/// </summary>
+uint32 logRateLimitsBuild(const AvLogSettings* settings, LogRateLimit limits[LOG_RATE_LIMIT_MAX_COUNT]);
+
+/// <summary>
+/// returns the first limit that matches, or nullptr
+/// </summary>
+const LogRateLimit* logRateLimitFind(const LogRateLimit* limits, uint32 limitCount, uint categoryId, AvResult result);
+
+/// <summary>
+/// decides whether a record of a call site is written, returns LogRateLimitResultBits.
+/// hash identifies the message text for coalescing. summaryText has to hold LOG_RATE_LIMIT_SUMMARY_SIZE characters
+/// </summary>
+uint32 logRateLimitAdmit(AvLogCallSite* callSite, const LogRateLimit* limit, uint64 interval, const LogRecord* record, uint64 hash, LogRecord* summary, char* summaryText);
+
+/// <summary>
+/// passes the pending summary of every call site to submit
+/// </summary>
+void logRateLimitFlush(void (*submit)(const LogRecord* summary));
+
+/// <summary>
+/// passes the summaries whose interval is over to submit, for call sites that stopped logging.
+/// returns true when a summary was submitted
+/// </summary>
+bool logRateLimitFlushExpired(uint64 interval, void (*submit)(const LogRecord* summary));
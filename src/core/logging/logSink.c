@@ -0,0 +1,244 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+// pthread_rwlock
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "logSink.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_logging"
+
+typedef struct LogSink {
+	AvLogSink sink;
+	bool colored;
+	// only flushed when logging shuts down or the process exits, so output is written in large blocks
+	bool finalFlushOnly;
+} LogSink;
+
+static void stdoutWrite(void* userData, const AvLogMessage* message);
+static void stdoutFlush(void* userData);
+
+// until the log settings are set messages go to stdout with colors
+static LogSink defaultSinks[] = { { { nullptr, stdoutWrite, stdoutFlush }, true, false } };
+
+atomic_uint logSinkTextNeeded = LOG_SINK_TEXT_COLORED;
+
+// every thread writing messages holds the lock shared, replacing the sinks holds it exclusively.
+// the sinks array, the log file and the crash ring may only change while it is held exclusively
+static pthread_rwlock_t sinksLock = PTHREAD_RWLOCK_INITIALIZER;
+static LogSink* sinks = defaultSinks;
+static uint32 sinkCount = 1;
+
+static FILE* logFile = nullptr;
+static char* logFileBuffer = nullptr;
+
+static char* crashRing = nullptr;
+static uint32 crashRingSize = 0;
+static uint64 crashRingNext = 0;
+static pthread_mutex_t crashRingMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void stdoutWrite(void* userData, const AvLogMessage* message) {
+	fwrite(message->text, 1, message->length, stdout);
+	fputc('\n', stdout);
+}
+
+static void stdoutFlush(void* userData) {
+	fflush(stdout);
+}
+
+static void fileWrite(void* userData, const AvLogMessage* message) {
+	fwrite(message->text, 1, message->length, logFile);
+	fputc('\n', logFile);
+}
+
+static void fileFlush(void* userData) {
+	fflush(logFile);
+}
+
+static void crashRingWrite(void* userData, const AvLogMessage* message) {
+	uint64 length = message->length < LOG_CRASH_RING_ENTRY_SIZE ? message->length : LOG_CRASH_RING_ENTRY_SIZE - 1;
+	pthread_mutex_lock(&crashRingMutex);
+	char* entry = crashRing + (crashRingNext % crashRingSize) * LOG_CRASH_RING_ENTRY_SIZE;
+	memcpy(entry, message->text, length);
+	entry[length] = '\0';
+	crashRingNext++;
+	pthread_mutex_unlock(&crashRingMutex);
+}
+
+static const LogSink stdoutSink = { { nullptr, stdoutWrite, stdoutFlush }, false, false };
+static const LogSink fileSink = { { nullptr, fileWrite, fileFlush }, false, true };
+static const LogSink crashRingSink = { { nullptr, crashRingWrite, nullptr }, false, false };
+
+static void updateTextNeeded() {
+	uint32 textNeeded = 0;
+	for (uint32 i = 0; i < sinkCount; i++) {
+		textNeeded |= sinks[i].colored ? LOG_SINK_TEXT_COLORED : LOG_SINK_TEXT_PLAIN;
+	}
+	atomic_store_explicit(&logSinkTextNeeded, textNeeded, memory_order_relaxed);
+}
+
+// has to be called with the sinks locked
+static void flushSinks(bool final) {
+	for (uint32 i = 0; i < sinkCount; i++) {
+		const LogSink* sink = &sinks[i];
+		if (sink->sink.pfnFlush && (final || !sink->finalFlushOnly)) {
+			sink->sink.pfnFlush(sink->sink.userData);
+		}
+	}
+}
+
+static void closeLogFile() {
+	if (logFile == nullptr) {
+		return;
+	}
+	fclose(logFile);
+	logFile = nullptr;
+	untrackedAllocator.free(logFileBuffer, untrackedAllocator.userData);
+	logFileBuffer = nullptr;
+}
+
+static bool openLogFile(const char* path, uint32 bufferSize) {
+	FILE* file = fopen(path, "a");
+	if (file == nullptr) {
+		return false;
+	}
+	if (bufferSize == 0) {
+		bufferSize = AV_LOG_FILE_BUFFER_SIZE_DEFAULT;
+	}
+	logFileBuffer = untrackedAllocator.allocate(bufferSize, untrackedAllocator.userData);
+	setvbuf(file, logFileBuffer, logFileBuffer ? _IOFBF : _IOLBF, logFileBuffer ? bufferSize : 0);
+	logFile = file;
+	return true;
+}
+
+static void resizeCrashRing(uint32 size) {
+	if (size == crashRingSize) {
+		return;
+	}
+	pthread_mutex_lock(&crashRingMutex);
+	if (crashRing) {
+		untrackedAllocator.free(crashRing, untrackedAllocator.userData);
+	}
+	crashRing = size ? untrackedAllocator.allocate((uint64)size * LOG_CRASH_RING_ENTRY_SIZE, untrackedAllocator.userData) : nullptr;
+	crashRingSize = crashRing ? size : 0;
+	crashRingNext = 0;
+	pthread_mutex_unlock(&crashRingMutex);
+}
+
+void logSinksConfigure(const AvLogSettings* settings) {
+	pthread_rwlock_wrlock(&sinksLock);
+	flushSinks(true);
+	closeLogFile();
+	if (sinks != defaultSinks) {
+		untrackedAllocator.free(sinks, untrackedAllocator.userData);
+	}
+	sinks = defaultSinks;
+	sinkCount = 0;
+
+	resizeCrashRing(settings->crashRingSize);
+	bool fileOpened = settings->logFile && openLogFile(settings->logFile, settings->logFileBufferSize);
+
+	uint32 capacity = 3 + settings->sinkCount;
+	LogSink* configured = untrackedAllocator.allocate(sizeof(LogSink) * capacity, untrackedAllocator.userData);
+	if (configured == nullptr) {
+		sinkCount = 1;
+		updateTextNeeded();
+		pthread_rwlock_unlock(&sinksLock);
+		return;
+	}
+	sinks = configured;
+	if (settings->printStdout) {
+		sinks[sinkCount] = stdoutSink;
+		sinks[sinkCount].colored = settings->colors;
+		sinkCount++;
+	}
+	if (fileOpened) {
+		sinks[sinkCount++] = fileSink;
+	}
+	if (crashRingSize) {
+		sinks[sinkCount++] = crashRingSink;
+	}
+	for (uint32 i = 0; i < settings->sinkCount; i++) {
+		LogSink* sink = &sinks[sinkCount++];
+		sink->sink = settings->sinks[i];
+		sink->colored = false;
+		sink->finalFlushOnly = false;
+	}
+	updateTextNeeded();
+	pthread_rwlock_unlock(&sinksLock);
+
+	// logged through the new sinks, so only once the lock is released
+	if (settings->logFile && !fileOpened) {
+		avLog(AV_IO_ERROR, "failed to open log file");
+	}
+}
+
+void logSinksShutdown() {
+	pthread_rwlock_wrlock(&sinksLock);
+	flushSinks(true);
+	uint32 kept = 0;
+	for (uint32 i = 0; i < sinkCount; i++) {
+		if (sinks[i].sink.pfnWrite == stdoutWrite || sinks[i].sink.pfnWrite == crashRingWrite) {
+			sinks[kept++] = sinks[i];
+		}
+	}
+	sinkCount = kept;
+	updateTextNeeded();
+	closeLogFile();
+	pthread_rwlock_unlock(&sinksLock);
+}
+
+void logSinksRelease() {
+	pthread_rwlock_wrlock(&sinksLock);
+	flushSinks(true);
+	closeLogFile();
+	if (sinks != defaultSinks) {
+		untrackedAllocator.free(sinks, untrackedAllocator.userData);
+	}
+	sinks = defaultSinks;
+	sinkCount = 1;
+	updateTextNeeded();
+	resizeCrashRing(0);
+	pthread_rwlock_unlock(&sinksLock);
+}
+
+void logSinksWrite(const AvLogMessage* plain, const AvLogMessage* colored) {
+	// the sinks may have been replaced after the message was formatted for the previous ones
+	if (plain->text == nullptr) {
+		plain = colored;
+	} else if (colored->text == nullptr) {
+		colored = plain;
+	}
+	if (plain->text == nullptr) {
+		return;
+	}
+	pthread_rwlock_rdlock(&sinksLock);
+	for (uint32 i = 0; i < sinkCount; i++) {
+		const LogSink* sink = &sinks[i];
+		sink->sink.pfnWrite(sink->sink.userData, sink->colored ? colored : plain);
+	}
+	pthread_rwlock_unlock(&sinksLock);
+}
+
+void logSinksFlush(bool final) {
+	pthread_rwlock_rdlock(&sinksLock);
+	flushSinks(final);
+	pthread_rwlock_unlock(&sinksLock);
+}
+
+void logSinksDumpCrashRing() {
+	pthread_rwlock_rdlock(&sinksLock);
+	pthread_mutex_lock(&crashRingMutex);
+	if (crashRingSize) {
+		uint64 count = crashRingNext < crashRingSize ? crashRingNext : crashRingSize;
+		fprintf(stderr, "last %llu log messages:\n", (unsigned long long)count);
+		for (uint64 i = crashRingNext - count; i < crashRingNext; i++) {
+			fprintf(stderr, "%s\n", crashRing + (i % crashRingSize) * LOG_CRASH_RING_ENTRY_SIZE);
+		}
+		fflush(stderr);
+	}
+	pthread_mutex_unlock(&crashRingMutex);
+	pthread_rwlock_unlock(&sinksLock);
+}
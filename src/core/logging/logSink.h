@@ -0,0 +1,60 @@
+#pragma once
+#include "../core.h"
+#include <stdatomic.h>
+
+// Destinations for formatted text messages.
+//
+// The built in sinks, stdout, a buffered file and an in-memory crash ring, are
+// AvLogSinks like the ones passed in the log settings. stdout is the only sink
+// that gets colored text. When no sink is configured messages are not formatted
+// at all.
+//
+// Messages are written from the log writer thread and from every thread that
+// logs synchronously. They hold a reader lock while they go through the sinks,
+// replacing or shutting down the sinks waits for them to finish.
+
+// longer messages are truncated in the crash ring
+#define LOG_CRASH_RING_ENTRY_SIZE 256
+
+typedef enum LogSinkTextBits {
+	LOG_SINK_TEXT_PLAIN = 1 << 0,
+	LOG_SINK_TEXT_COLORED = 1 << 1,
+}LogSinkTextBits;
+
+/// <summary>
+/// LogSinkTextBits of the text variants the configured sinks need, 0 when there are no sinks
+/// </summary>
+extern atomic_uint logSinkTextNeeded;
+
+/// <summary>
+/// replaces the configured sinks with the ones selected in settings, waits for messages that are being written.
+/// must not be called from a sink
+/// </summary>
+void logSinksConfigure(const AvLogSettings* settings);
+
+/// <summary>
+/// flushes and closes the log file and removes the user sinks, stdout and the crash ring stay
+/// </summary>
+void logSinksShutdown();
+
+/// <summary>
+/// frees the sinks and the crash ring, messages go to stdout again like before the first settings.
+/// has to be called before the allocation callbacks they were allocated with are reset
+/// </summary>
+void logSinksRelease();
+
+/// <summary>
+/// passes a message to every sink, plain and colored are the same message formatted without and with colors.
+/// the variants not set in logSinkTextNeeded may be nullptr
+/// </summary>
+void logSinksWrite(const AvLogMessage* plain, const AvLogMessage* colored);
+
+/// <summary>
+/// flushes stdout and the user sinks, the log file is only flushed when final is set so it is written in large blocks
+/// </summary>
+void logSinksFlush(bool final);
+
+/// <summary>
+/// writes the messages kept in the crash ring to stderr, oldest first
+/// </summary>
+void logSinksDumpCrashRing();
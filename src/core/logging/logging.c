@@ -1,8 +1,22 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+// clock_gettime
+#define _POSIX_C_SOURCE 200809L
+#endif
 #include "logging.h"
+#include "logQueue.h"
+#include "logBinary.h"
+#include "logFilter.h"
+#include "logArgs.h"
+#include "logSink.h"
+#include "logConfig.h"
+#include "logRateLimit.h"
+#include "../util/hash.h"
 #include <time.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdarg.h>
 #include <unistd.h>
 
 #define ANSI_COLOR_RED		"\x1b[31m"
@@ -16,40 +30,34 @@
 
 #define ANSI_CARRAGE_RETURN "\x0d"
 
-const char* AV_COLOR_RED = ANSI_COLOR_RED;
-const char* AV_COLOR_GREEN = ANSI_COLOR_GREEN;
-const char* AV_COLOR_YELLOW = ANSI_COLOR_YELLOW;
-const char* AV_COLOR_BLUE = ANSI_COLOR_BLUE;
-const char* AV_COLOR_MAGENTA = ANSI_COLOR_MAGENTA;
-const char* AV_COLOR_CYAN = ANSI_COLOR_CYAN;
-const char* AV_COLOR_WHITE = ANSI_COLOR_WHITE;
-const char* AV_COLOR_RESET = ANSI_COLOR_RESET;
+typedef struct LogColors {
+	const char* red;
+	const char* green;
+	const char* yellow;
+	const char* blue;
+	const char* magenta;
+	const char* cyan;
+	const char* white;
+	const char* reset;
+} LogColors;
+
+static const LogColors ansiColors = {
+	ANSI_COLOR_RED, ANSI_COLOR_GREEN, ANSI_COLOR_YELLOW, ANSI_COLOR_BLUE,
+	ANSI_COLOR_MAGENTA, ANSI_COLOR_CYAN, ANSI_COLOR_WHITE, ANSI_COLOR_RESET,
+};
+static const LogColors noColors = { "", "", "", "", "", "", "", "" };
 
 #define COLOR "%s"
 
-AvLogLevel AV_LOG_LEVEL = AV_LOG_LEVEL_DEFAULT;
-AvLogLevel AV_VALIDATION_LEVEL = AV_VALIDATION_LEVEL_DEFAULT;
-uint AV_LOG_LINE = AV_LOG_LINE_DEFAULT;
-uint AV_LOG_FILE = AV_LOG_FILE_DEFAULT;
-uint AV_LOG_FUNC = AV_LOG_FUNC_DEFAULT;
-uint AV_LOG_PROJECT = AV_LOG_PROJECT_DEFAULT;
-uint AV_LOG_TIME = AV_LOG_TIME_DEFAULT;
-uint AV_LOG_TYPE = AV_LOG_TYPE_DEFAULT;
-uint AV_LOG_ERROR = AV_LOG_ERROR_DEFAULT;
-uint AV_LOG_COLORS = AV_LOG_COLORS_DEFAULT;
-uint AV_LOG_ASSERT = AV_LOG_ASSERT_DEFAULT;
-uint AV_LOG_CODE = AV_LOG_CODE_DEFAULT;
-uint AV_LOG_CATEGORY_ = AV_LOG_CATEGORY_DEFAULT;
-uint blacklistedCategoryCount = 0;
-const char** blacklistedCategories = nullptr;
-AvAssertLevel AV_ASSERT_LEVEL = AV_ASSERT_LEVEL_DEFAULT;
-
-uint blacklistedMessageCount = 0;
-const AvResult* blacklistedMessages = nullptr;
-
-
-char AV_LOG_PROJECT_NAME[64] = "PROJECT_NAME_NOT_SPECIFIED";
-uint AV_LOG_PROJECT_VERSION = 0;
+// formatted messages longer than this are formatted in to a heap buffer
+#define LOG_LINE_INLINE_SIZE 1024
+// arguments larger than this are captured in to a heap buffer
+#define LOG_ARGS_BUFFER_SIZE 256
+
+// log timestamp and wall clock time at the start of the instance
+static uint64 logClockTimestamp = 0;
+static uint64 logClockWallClock = 0;
+static bool logClockStarted = false;
 
 const char* defaulDisabledLogCategories[] = {
 	"avixel",
@@ -62,6 +70,14 @@ const AvResult defaultDisabledMessages[] = {
 };
 const uint defaultDisabledMessageCount = sizeof(defaultDisabledMessages) / sizeof(AvResult);
 
+// messages that can be logged every frame or on every resize event
+const AvLogRateLimit defaultLogRateLimits[] = {
+	{ nullptr, AV_WINDOW_SIZE, 10, true },
+	{ nullptr, AV_SWAPCHAIN_RECREATION, 10, true },
+	{ nullptr, AV_VALIDATION_PRESENT, 100, true },
+};
+const uint defaultLogRateLimitCount = sizeof(defaultLogRateLimits) / sizeof(AvLogRateLimit);
+
 const AvLogSettings avLogSettingsDefault = {
 	.level = AV_LOG_LEVEL_DEFAULT,
 	.printLine = AV_LOG_LINE_DEFAULT,
@@ -69,6 +85,7 @@ const AvLogSettings avLogSettingsDefault = {
 	.printFunc = AV_LOG_FUNC_DEFAULT,
 	.printProject = AV_LOG_PROJECT_DEFAULT,
 	.printTime = AV_LOG_TIME_DEFAULT,
+	.timeFormat = AV_LOG_TIME_FORMAT_DEFAULT,
 	.printType = AV_LOG_TYPE_DEFAULT,
 	.printError = AV_LOG_ERROR_DEFAULT,
 	.printAssert = AV_LOG_ASSERT_DEFAULT,
@@ -81,107 +98,248 @@ const AvLogSettings avLogSettingsDefault = {
 	.disabledCategories = defaulDisabledLogCategories,
 	.disabledMessageCount = defaultDisabledMessageCount,
 	.disabledMessages = defaultDisabledMessages,
+	.asynchronous = AV_LOG_ASYNCHRONOUS_DEFAULT,
+	.queueSize = AV_LOG_QUEUE_SIZE_DEFAULT,
+	.backpressure = AV_LOG_BACKPRESSURE_DEFAULT,
+	.binaryLogFile = AV_LOG_BINARY_FILE_DEFAULT,
+	.printStdout = AV_LOG_STDOUT_DEFAULT,
+	.logFile = AV_LOG_FILE_NAME_DEFAULT,
+	.logFileBufferSize = AV_LOG_FILE_BUFFER_SIZE_DEFAULT,
+	.crashRingSize = AV_LOG_CRASH_RING_SIZE_DEFAULT,
+	.sinkCount = 0,
+	.sinks = nullptr,
+	.rateLimitCount = defaultLogRateLimitCount,
+	.rateLimits = defaultLogRateLimits,
+	.rateLimitInterval = AV_LOG_RATE_LIMIT_INTERVAL_DEFAULT,
 };
 
 void setLogSettings(AvLogSettings settings) {
-	AV_LOG_LEVEL = settings.level;
-	AV_VALIDATION_LEVEL = settings.validationLevel;
-	AV_LOG_LINE = settings.printLine;
-	AV_LOG_FILE = settings.printFile;
-	AV_LOG_FUNC = settings.printFunc;
-	AV_LOG_PROJECT = settings.printProject;
-	AV_LOG_TIME = settings.printTime;
-	AV_LOG_TYPE = settings.printType;
-	AV_LOG_ERROR = settings.printError;
-	AV_LOG_ASSERT = settings.printAssert;
-	AV_LOG_COLORS = settings.colors;
-	AV_ASSERT_LEVEL = settings.assertLevel;
-	AV_LOG_CODE = settings.printCode;
-	AV_LOG_CATEGORY_ = settings.printCategory;
-
-	if (settings.colors) {
-		AV_COLOR_RED = ANSI_COLOR_RED;
-		AV_COLOR_GREEN = ANSI_COLOR_GREEN;
-		AV_COLOR_YELLOW = ANSI_COLOR_YELLOW;
-		AV_COLOR_BLUE = ANSI_COLOR_BLUE;
-		AV_COLOR_MAGENTA = ANSI_COLOR_MAGENTA;
-		AV_COLOR_CYAN = ANSI_COLOR_CYAN;
-		AV_COLOR_CYAN = ANSI_COLOR_WHITE;
-		AV_COLOR_RESET = ANSI_COLOR_RESET;
-	} else {
-		AV_COLOR_RED = "";
-		AV_COLOR_GREEN = "";
-		AV_COLOR_YELLOW = "";
-		AV_COLOR_BLUE = "";
-		AV_COLOR_MAGENTA = "";
-		AV_COLOR_CYAN = "";
-		AV_COLOR_WHITE = "";
-		AV_COLOR_RESET = "";
+	// pending messages are written with the settings they were logged under
+	logQueueStop();
+	binaryLogClose();
+
+	LogConfig* config = logConfigCreate(&settings);
+	logConfigPublish(config);
+	logSinksConfigure(&settings);
+
+	if (settings.binaryLogFile) {
+		binaryLogOpen(settings.binaryLogFile, config->projectName, config->projectVersion);
 	}
+	if (settings.asynchronous) {
+		logQueueStart(settings.queueSize ? settings.queueSize : AV_LOG_QUEUE_SIZE_DEFAULT, settings.backpressure);
+	}
+}
 
-	blacklistedCategories = settings.disabledCategories;
-	blacklistedCategoryCount = settings.disabledCategoryCount;
-	blacklistedMessages = settings.disabledMessages;
-	blacklistedMessageCount = settings.disabledMessageCount;
+void shutdownLogging() {
+	logQueueStop();
+	logRateLimitFlush(writeLogRecord);
+	binaryLogClose();
+	logSinksShutdown();
+}
 
+void releaseLogging() {
+	shutdownLogging();
+	logSinksRelease();
 }
 
-bool checkCategoryDisabled(const char* category) {
-	for (uint i = 0; i < blacklistedCategoryCount; i++) {
-		if (strcmp(blacklistedCategories[i], category) == 0) {
-			return true;
-		}
+uint64 getLogTimestamp() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64)time.tv_sec * 1000000 + (uint64)time.tv_nsec / 1000;
+}
+
+uint64 getLogWallClock() {
+	struct timespec time;
+	clock_gettime(CLOCK_REALTIME, &time);
+	return (uint64)time.tv_sec * 1000000 + (uint64)time.tv_nsec / 1000;
+}
+
+void startLogClock() {
+	setLogClockBase(getLogTimestamp(), getLogWallClock());
+}
+
+void getLogClockBase(uint64* timestamp, uint64* wallClock) {
+	if (logClockStarted) {
+		*timestamp = logClockTimestamp;
+		*wallClock = logClockWallClock;
+	} else {
+		*timestamp = getLogTimestamp();
+		*wallClock = getLogWallClock();
 	}
-	return false;
 }
 
-bool checkMessageDisabled(AvResult result) {
-	for (uint i = 0; i < blacklistedMessageCount; i++) {
-		if (blacklistedMessages[i] == result){
-			return true;
-		}
+void setLogClockBase(uint64 timestamp, uint64 wallClock) {
+	logClockTimestamp = timestamp;
+	logClockWallClock = wallClock;
+	logClockStarted = true;
+}
+
+void flushLogOutput() {
+	logSinksFlush(false);
+}
+
+static void copyProjectDetails(LogConfig* config, const char* projectName, uint version) {
+	if (strlen(projectName) >= LOG_PROJECT_NAME_SIZE) {
+		avAssert(AV_MEMORY_ERROR, 0, "project name must be shorter than 63 characters");
 	}
-	return false;
+	strncpy(config->projectName, projectName, LOG_PROJECT_NAME_SIZE - 1);
+	config->projectName[LOG_PROJECT_NAME_SIZE - 1] = '\0';
+	config->projectVersion = version;
 }
 
 void setProjectDetails(const char* projectName, uint version) {
+	LogConfig* config = logConfigCopy(atomic_load(&currentLogConfig));
+	copyProjectDetails(config, projectName, version);
+	logConfigPublish(config);
+}
 
-	if (strlen(projectName) >= 64) {
-		avAssert(AV_MEMORY_ERROR, 0, "project name must be shorter than 63 characters");
+LogConfig* createInstanceLogConfig(const AvLogSettings* settings, const char* projectName, uint version) {
+	LogConfig* config = settings ? logConfigCreate(settings) : logConfigCopy(atomic_load(&currentLogConfig));
+	copyProjectDetails(config, projectName, version);
+	return config;
+}
+
+// text of a formatted message, grows from the inline buffer in to a heap buffer
+typedef struct LogLine {
+	char* text;
+	uint64 length;
+	uint64 capacity;
+	char inlineText[LOG_LINE_INLINE_SIZE];
+} LogLine;
+
+static void logLineInit(LogLine* line) {
+	line->text = line->inlineText;
+	line->length = 0;
+	line->capacity = sizeof(line->inlineText);
+	line->text[0] = '\0';
+}
+
+static void logLineFree(LogLine* line) {
+	if (line->text != line->inlineText) {
+		untrackedAllocator.free(line->text, untrackedAllocator.userData);
 	}
-	strcpy((void*)AV_LOG_PROJECT_NAME, projectName);
-	AV_LOG_PROJECT_NAME[63] = '\0';
+}
 
-	AV_LOG_PROJECT_VERSION = version;
+// makes room for size more characters and the null terminator, returns false when the line can not grow
+static bool logLineReserve(LogLine* line, uint64 size) {
+	if (line->length + size < line->capacity) {
+		return true;
+	}
+	uint64 capacity = line->capacity * 2;
+	while (capacity <= line->length + size) {
+		capacity *= 2;
+	}
+	char* text = untrackedAllocator.allocate(capacity, untrackedAllocator.userData);
+	if (text == nullptr) {
+		return false;
+	}
+	memcpy(text, line->text, line->length + 1);
+	logLineFree(line);
+	line->text = text;
+	line->capacity = capacity;
+	return true;
 }
 
-void logDeviceValidation(const char* renderer, AvValidationLevel level, ValidationMessageType type, const char* message) {
-	if (AV_VALIDATION_LEVEL > level) {
+// text that does not fit and can not be allocated is truncated
+static void logLineAppendf(LogLine* line, const char* format, ...) AV_PRINTF_FORMAT(2, 3);
+static void logLineAppendf(LogLine* line, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	uint64 remaining = line->capacity - line->length;
+	int length = vsnprintf(line->text + line->length, remaining, format, args);
+	va_end(args);
+	if (length < 0) {
+		line->text[line->length] = '\0';
 		return;
 	}
+	if ((uint64)length >= remaining) {
+		if (!logLineReserve(line, (uint64)length)) {
+			line->length = line->capacity - 1;
+			return;
+		}
+		va_start(args, format);
+		vsnprintf(line->text + line->length, line->capacity - line->length, format, args);
+		va_end(args);
+	}
+	line->length += (uint64)length;
+}
+
+static void logLineAppendArgs(LogLine* line, const LogRecord* record) {
+	uint64 remaining = line->capacity - line->length;
+	uint64 length = logArgsFormat(record->message, record->args, record->argsSize, line->text + line->length, remaining);
+	if (length >= remaining) {
+		if (!logLineReserve(line, length)) {
+			line->length = line->capacity - 1;
+			return;
+		}
+		logArgsFormat(record->message, record->args, record->argsSize, line->text + line->length, line->capacity - line->length);
+	}
+	line->length += length;
+}
 
-	fprintf(stdout, COLOR"["COLOR"%s"COLOR"]", AV_COLOR_RESET, AV_COLOR_CYAN, renderer, AV_COLOR_RESET);
+static void formatValidation(const LogRecord* record, const LogColors* colors, LogLine* line) {
+	logLineAppendf(line, COLOR"["COLOR"%s"COLOR"]", colors->reset, colors->cyan, record->category, colors->reset);
 
-	switch (type) {
+	switch ((ValidationMessageType)record->result) {
 	case VALIDATION_MESSAGE_TYPE_DEVICE_ADDRESS:
-		fprintf(stdout, COLOR"["COLOR"address"COLOR"]", AV_COLOR_RESET, AV_COLOR_YELLOW, AV_COLOR_RESET);
+		logLineAppendf(line, COLOR"["COLOR"address"COLOR"]", colors->reset, colors->yellow, colors->reset);
 		break;
 	case VALIDATION_MESSAGE_TYPE_GENERAL:
-		fprintf(stdout, COLOR"["COLOR"general"COLOR"]", AV_COLOR_RESET, AV_COLOR_CYAN, AV_COLOR_RESET);
+		logLineAppendf(line, COLOR"["COLOR"general"COLOR"]", colors->reset, colors->cyan, colors->reset);
 		break;
 	case VALIDATION_MESSAGE_TYPE_VALIDATION:
-		fprintf(stdout, COLOR"["COLOR"validation"COLOR"]", AV_COLOR_RESET, AV_COLOR_RED, AV_COLOR_RESET);
+		logLineAppendf(line, COLOR"["COLOR"validation"COLOR"]", colors->reset, colors->red, colors->reset);
 		break;
 	case VALIDATION_MESSAGE_TYPE_PERFORMANCE:
-		fprintf(stdout, COLOR"["COLOR"performance"COLOR"]", AV_COLOR_RESET, AV_COLOR_BLUE, AV_COLOR_RESET);
+		logLineAppendf(line, COLOR"["COLOR"performance"COLOR"]", colors->reset, colors->blue, colors->reset);
 		break;
 	}
-	fprintf(stdout, " -> %s\n", message);
+	logLineAppendf(line, " -> %s", record->message);
+}
+
+// false when messages would not be written anywhere
+static inline bool logOutputEnabled() {
+	return atomic_load_explicit(&logSinkTextNeeded, memory_order_relaxed) != 0 || binaryLogIsOpen();
+}
+
+// the formatted hours, minutes and seconds of the last printed wall clock second, per thread
+// so only the sub-second part has to be formatted while the second stays the same
+static _Thread_local uint64 cachedWallClockSecond = UINT64_MAX;
+static _Thread_local char cachedWallClockText[16];
+
+static void formatTime(const LogConfig* config, uint64 timestamp, LogLine* line) {
+	uint64 logClockBaseTimestamp;
+	uint64 logClockBaseWallClock;
+	getLogClockBase(&logClockBaseTimestamp, &logClockBaseWallClock);
+
+	if (config->timeFormat == AV_LOG_TIME_FORMAT_RELATIVE) {
+		// messages logged before the clock was started show up as time 0
+		uint64 elapsed = timestamp > logClockBaseTimestamp ? timestamp - logClockBaseTimestamp : 0;
+		logLineAppendf(line, "[%llu.%06llu]", (unsigned long long)(elapsed / 1000000), (unsigned long long)(elapsed % 1000000));
+		return;
+	}
+
+	uint64 wallClock = logClockBaseWallClock + timestamp - logClockBaseTimestamp;
+	uint64 second = wallClock / 1000000;
+	if (second != cachedWallClockSecond) {
+		time_t seconds = (time_t)second;
+		struct tm timeinfo;
+#ifdef _WIN32
+		localtime_s(&timeinfo, &seconds);
+#else
+		localtime_r(&seconds, &timeinfo);
+#endif
+		strftime(cachedWallClockText, sizeof(cachedWallClockText), "%T", &timeinfo);
+		cachedWallClockSecond = second;
+	}
+	logLineAppendf(line, "[%s.%06llu]", cachedWallClockText, (unsigned long long)(wallClock % 1000000));
 }
 
 #define MESSAGE(code,msg) case code: message = msg; break
 
-void printTags(AvResult result, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg) {
+static void formatTags(const LogRecord* record, const LogColors* colors, LogLine* line) {
+	const LogConfig* config = record->config;
+	AvResult result = record->result;
 	//message
 	const char* message;
 
@@ -240,6 +398,7 @@ void printTags(AvResult result, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char*
 		MESSAGE(AV_TIMEOUT, "timeout"); // 6
 		MESSAGE(AV_UNABLE_TO_PARSE, "parse error"); // 7
 		MESSAGE(AV_INVALID_SYNTAX, "invalid syntax"); // 8
+		MESSAGE(AV_MEMORY_LEAK, "memory leak"); // 9
 
 		// ERROR
 		MESSAGE(AV_ERROR, "error"); // 0
@@ -267,119 +426,346 @@ void printTags(AvResult result, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char*
 		break;
 	}
 
-	if (AV_LOG_TIME) {
-		//time 
-		time_t rawtime;
-		struct tm* timeinfo;
-		time(&rawtime);
-		timeinfo = localtime(&rawtime);
-		char time[80];
-		strftime(time, 80, "%T", timeinfo);
-		fprintf(stdout, "[%s]", time);
+	if (config->printTime) {
+		//time
+		formatTime(config, record->timestamp, line);
 	}
-	if (AV_LOG_TYPE) {
+	if (config->printType) {
 		//level
 		const char* result_level;
 		const char* color;
 		if (result == AV_SUCCESS) {
 			result_level = "SUCESS";
-			color = AV_COLOR_GREEN;
+			color = colors->green;
 		} else if (result & AV_INFO) {
 			result_level = "INFO";
-			color = AV_COLOR_RESET;
+			color = colors->reset;
 		} else if (result & AV_DEBUG) {
 			result_level = "DEBUG";
-			color = AV_COLOR_BLUE;
+			color = colors->blue;
 		} else if (result & AV_WARNING) {
 			result_level = "WARNING";
-			color = AV_COLOR_YELLOW;
+			color = colors->yellow;
 		} else if (result & AV_ERROR) {
 			result_level = "ERROR";
-			color = AV_COLOR_RED;
+			color = colors->red;
 		} else {
 			result_level = "UNKNOWN";
-			color = AV_COLOR_WHITE;
+			color = colors->white;
 		}
-		fprintf(stdout, "["COLOR"%s"COLOR"]", color, result_level, AV_COLOR_RESET);
+		logLineAppendf(line, "["COLOR"%s"COLOR"]", color, result_level, colors->reset);
 	}
-	if (AV_LOG_CODE) {
+	if (config->printCode) {
 		const char* color = "";
 		switch (error_type) {
 		case 'S':
-			color = AV_COLOR_GREEN;
+			color = colors->green;
 			break;
 		case 'D':
-			color = AV_COLOR_BLUE;
+			color = colors->blue;
 			break;
 		case 'I':
-			color = AV_COLOR_RESET;
+			color = colors->reset;
 			break;
 		case 'W':
-			color = AV_COLOR_YELLOW;
+			color = colors->yellow;
 			break;
 		case 'E':
-			color = AV_COLOR_RED;
+			color = colors->red;
 			break;
 		}
-		fprintf(stdout, "[%s%s"COLOR"]", color, error_code, AV_COLOR_RESET);
+		logLineAppendf(line, "[%s%s"COLOR"]", color, error_code, colors->reset);
 	}
-	if (AV_LOG_PROJECT) {
-		fprintf(stdout, "[%s v%i.%i]", AV_LOG_PROJECT_NAME, AV_LOG_PROJECT_VERSION >> 16, AV_LOG_PROJECT_VERSION & 0xffff);
+	if (config->printProject) {
+		logLineAppendf(line, "[%s v%i.%i]", config->projectName, config->projectVersion >> 16, config->projectVersion & 0xffff);
 	}
-	if (AV_LOG_FUNC) {
-		fprintf(stdout, "[func: %s]", func);
+	if (config->printFunc) {
+		logLineAppendf(line, "[func: %s]", record->func);
 	}
-	if (AV_LOG_LINE) {
-		fprintf(stdout, "[line %llu]", line);
+	if (config->printLine) {
+		logLineAppendf(line, "[line %llu]", record->line);
 	}
-	if (AV_LOG_FILE) {
-		fprintf(stdout, "[file: %s]", file);
+	if (config->printFile) {
+		logLineAppendf(line, "[file: %s]", record->file);
 	}
-	if (AV_LOG_CATEGORY_) {
-		fprintf(stdout, "[category: %s]", category);
+	if (config->printCategory) {
+		logLineAppendf(line, "[category: %s]", record->category);
 	}
-	if (AV_LOG_ERROR && (!unknownCode || !AV_LOG_CODE)) {
-		fprintf(stdout, " %s", message);
+	if (config->printError && (!unknownCode || !config->printCode)) {
+		logLineAppendf(line, " %s", message);
 	}
 
-	if (!(strcmp(msg, "") == 0)) {
-		fprintf(stdout, " -> ");
+	if (!(strcmp(record->message, "") == 0)) {
+		logLineAppendf(line, " -> ");
 	}
 }
 
-void avLog_(AvResult result, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg) {
-
-	if (checkCategoryDisabled(category) || checkMessageDisabled(result)) {
+static void formatLogRecord(const LogRecord* record, const LogColors* colors, LogLine* line) {
+	logLineInit(line);
+	switch (record->type) {
+	case LOG_RECORD_TYPE_VALIDATION:
+		formatValidation(record, colors, line);
 		return;
+	case LOG_RECORD_TYPE_ASSERT:
+		formatTags(record, colors, line);
+		if (record->config->printAssert) {
+			logLineAppendf(line, COLOR"assert"COLOR" -> ", colors->yellow, colors->reset);
+		}
+		break;
+	case LOG_RECORD_TYPE_LOG:
+		formatTags(record, colors, line);
+		break;
+	}
+	if (record->args) {
+		logLineAppendArgs(line, record);
+	} else {
+		logLineAppendf(line, "%s", record->message);
+	}
+}
+
+static void fillLogMessage(const LogRecord* record, const LogLine* line, AvLogMessage* message) {
+	message->result = record->type == LOG_RECORD_TYPE_VALIDATION ? AV_VALIDATION_PRESENT : record->result;
+	message->category = record->category;
+	message->timestamp = record->timestamp;
+	message->text = line->text;
+	message->length = line->length;
+}
+
+void writeLogRecord(const LogRecord* record) {
+	if (binaryLogIsOpen()) {
+		binaryLogWrite(record);
 	}
-	
-	if ((uint)result < (uint)AV_LOG_LEVEL) {
+	uint32 textNeeded = atomic_load_explicit(&logSinkTextNeeded, memory_order_relaxed);
+	if (textNeeded == 0) {
 		return;
 	}
 
-	printTags(result, line, file, func, category, msg);
+	LogLine plainLine;
+	LogLine coloredLine;
+	AvLogMessage plain = { 0 };
+	AvLogMessage colored = { 0 };
+	if (textNeeded & LOG_SINK_TEXT_PLAIN) {
+		formatLogRecord(record, &noColors, &plainLine);
+		fillLogMessage(record, &plainLine, &plain);
+	}
+	if (textNeeded & LOG_SINK_TEXT_COLORED) {
+		formatLogRecord(record, &ansiColors, &coloredLine);
+		fillLogMessage(record, &coloredLine, &colored);
+	}
+	logSinksWrite(&plain, &colored);
+
+	if (textNeeded & LOG_SINK_TEXT_PLAIN) {
+		logLineFree(&plainLine);
+	}
+	if (textNeeded & LOG_SINK_TEXT_COLORED) {
+		logLineFree(&coloredLine);
+	}
+}
 
-	fprintf(stdout, "%s\n", msg);
+static void fillLogRecord(LogRecord* record, const LogConfig* config, LogRecordType type, AvResult result, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg) {
+	record->config = config;
+	record->type = type;
+	record->result = result;
+	record->line = line;
+	record->file = file;
+	record->func = func;
+	record->category = category;
+	record->timestamp = getLogTimestamp();
+	record->message = msg;
+	record->args = nullptr;
+	record->argsSize = 0;
+}
 
+static void submitLogRecord(const LogRecord* record, bool fatal) {
+	if (fatal) {
+		// everything logged before has to reach the output before the process exits
+		logQueueStop();
+		writeLogRecord(record);
+	} else if (!logQueuePush(record)) {
+		writeLogRecord(record);
+	}
 }
 
-void avAssert_(AvResult result, AvResult valid, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg) {
+static void submitSummary(const LogRecord* summary) {
+	submitLogRecord(summary, false);
+}
 
-	bool enabled = !checkCategoryDisabled(category) && !checkMessageDisabled(result);
+void flushExpiredLogSummaries() {
+	logRateLimitFlushExpired(logConfigGet()->rateLimitInterval, submitSummary);
+}
 
-	if ((result >= AV_LOG_LEVEL || result >= AV_ASSERT_LEVEL) && enabled) {
-		printTags(result, line, file, func, category, msg);
-		if (AV_LOG_ASSERT) {
-			fprintf(stdout, COLOR"assert"COLOR" -> ", AV_COLOR_YELLOW, AV_COLOR_RESET);
+static const LogRateLimit* findRateLimit(const LogConfig* config, AvLogCallSite* callSite, AV_CATEGORY_ARGS, AvResult result) {
+	if (callSite == nullptr || config->rateLimitCount == 0) {
+		return nullptr;
+	}
+	return logRateLimitFind(config->rateLimits, config->rateLimitCount, logCategoryResolve(callSite, category), result);
+}
+
+// returns false when the rate limit of the call site holds the record back. hash identifies the message for coalescing
+static bool admitRecord(const LogConfig* config, AvLogCallSite* callSite, const LogRateLimit* limit, const LogRecord* record, uint64 hash) {
+	LogRecord summary;
+	char summaryText[LOG_RATE_LIMIT_SUMMARY_SIZE];
+	uint32 result = logRateLimitAdmit(callSite, limit, config->rateLimitInterval, record, hash, &summary, summaryText);
+	if (result & LOG_RATE_LIMIT_SUMMARY) {
+		submitLogRecord(&summary, false);
+	}
+	return result & LOG_RATE_LIMIT_WRITE;
+}
+
+// limits that coalesce need the captured arguments to compare messages, the others are checked before capturing
+static void submitFormattedLogRecord(LogRecord* record, bool fatal, const LogRateLimit* limit, AvLogCallSite* callSite, va_list args) {
+	if (limit && !limit->coalesce && !admitRecord(record->config, callSite, limit, record, 0)) {
+		return;
+	}
+
+	byte buffer[LOG_ARGS_BUFFER_SIZE];
+	byte* data = buffer;
+
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	uint64 size = logArgsCapture(record->message, args, buffer, sizeof(buffer));
+	if (size > sizeof(buffer)) {
+		data = untrackedAllocator.allocate(size, untrackedAllocator.userData);
+		if (data) {
+			logArgsCapture(record->message, argsCopy, data, size);
+		} else {
+			// only the arguments that fit are valid, format without any rather than reading garbage
+			data = buffer;
+			size = 0;
 		}
-		fprintf(stdout, "%s\n", msg);
 	}
+	va_end(argsCopy);
+
+	record->args = data;
+	record->argsSize = size;
+	if (!limit || !limit->coalesce || admitRecord(record->config, callSite, limit, record, hashBytes(data, size) ^ hashUint64((uint64)(uintptr_t)record->message))) {
+		submitLogRecord(record, fatal);
+	}
+
+	if (data != buffer) {
+		untrackedAllocator.free(data, untrackedAllocator.userData);
+	}
+}
+
+static inline bool logEnabled(const LogConfig* config, AvResult result, AvLogCallSite* callSite, AV_CATEGORY_ARGS) {
+	if ((uint)result < (uint)config->level || !logOutputEnabled()) {
+		return false;
+	}
+	return !logCategoryDisabled(&config->filter, logCategoryResolve(callSite, category)) && !logResultDisabled(&config->filter, result);
+}
+
+static inline bool assertEnabled(const LogConfig* config, AvResult result, AvLogCallSite* callSite, AV_CATEGORY_ARGS) {
+	if (((uint)result < (uint)config->level && (uint)result < (uint)config->assertLevel) || !logOutputEnabled()) {
+		return false;
+	}
+	return !logCategoryDisabled(&config->filter, logCategoryResolve(callSite, category)) && !logResultDisabled(&config->filter, result);
+}
 
-	if (result == valid && result < AV_ASSERT_LEVEL) {
+static void finishAssert(const LogConfig* config, AvResult result, AvResult valid) {
+	if (result == valid && (uint)result < (uint)config->assertLevel) {
 		return;
 	}
 
-	if (result >= AV_ASSERT_LEVEL) {
+	if ((uint)result >= (uint)config->assertLevel) {
+		logQueueStop();
+		logSinksFlush(true);
+		logSinksDumpCrashRing();
+		shutdownLogging();
 		exit(-1);
 	}
-}
\ No newline at end of file
+}
+
+void logDeviceValidation(const char* renderer, AvValidationLevel level, ValidationMessageType type, const char* message) {
+	const LogConfig* config = logConfigGet();
+	if (config->validationLevel > level || !logOutputEnabled()) {
+		return;
+	}
+
+	LogRecord record = { 0 };
+	record.config = config;
+	record.type = LOG_RECORD_TYPE_VALIDATION;
+	record.result = (AvResult)type;
+	record.line = __LINE__;
+	record.file = __FILE__;
+	record.func = __func__;
+	record.category = renderer;
+	record.timestamp = getLogTimestamp();
+	record.message = message;
+
+	// validation layers can repeat the same message thousands of times per second
+	static AvLogCallSite validationCallSites[VALIDATION_MESSAGE_TYPE_PERFORMANCE + 1];
+	AvLogCallSite* callSite = &validationCallSites[type];
+	const LogRateLimit* limit = findRateLimit(config, callSite, renderer, AV_VALIDATION_PRESENT);
+	if (limit && !admitRecord(config, callSite, limit, &record, limit->coalesce ? hashString(message) : 0)) {
+		return;
+	}
+	if (!logQueuePush(&record)) {
+		writeLogRecord(&record);
+	}
+}
+
+void avLogSite_(AvResult result, AvLogCallSite* callSite, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg) {
+	const LogConfig* config = logConfigGet();
+	if (!logEnabled(config, result, callSite, category)) {
+		return;
+	}
+
+	LogRecord record;
+	fillLogRecord(&record, config, LOG_RECORD_TYPE_LOG, result, line, file, func, category, msg);
+	const LogRateLimit* limit = findRateLimit(config, callSite, category, result);
+	if (limit && !admitRecord(config, callSite, limit, &record, limit->coalesce ? hashString(msg) : 0)) {
+		return;
+	}
+	submitLogRecord(&record, false);
+}
+
+void avAssertSite_(AvResult result, AvResult valid, AvLogCallSite* callSite, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg) {
+	const LogConfig* config = logConfigGet();
+	if (assertEnabled(config, result, callSite, category)) {
+		// failed asserts that exit the process are never held back
+		bool fatal = (uint)result >= (uint)config->assertLevel;
+		LogRecord record;
+		fillLogRecord(&record, config, LOG_RECORD_TYPE_ASSERT, result, line, file, func, category, msg);
+		const LogRateLimit* limit = fatal ? nullptr : findRateLimit(config, callSite, category, result);
+		if (!limit || admitRecord(config, callSite, limit, &record, limit->coalesce ? hashString(msg) : 0)) {
+			submitLogRecord(&record, fatal);
+		}
+	}
+	finishAssert(config, result, valid);
+}
+
+void avLogf_(AvResult result, AvLogCallSite* callSite, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* format, ...) {
+	const LogConfig* config = logConfigGet();
+	if (!logEnabled(config, result, callSite, category)) {
+		return;
+	}
+
+	LogRecord record;
+	fillLogRecord(&record, config, LOG_RECORD_TYPE_LOG, result, line, file, func, category, format);
+	va_list args;
+	va_start(args, format);
+	submitFormattedLogRecord(&record, false, findRateLimit(config, callSite, category, result), callSite, args);
+	va_end(args);
+}
+
+void avAssertf_(AvResult result, AvResult valid, AvLogCallSite* callSite, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* format, ...) {
+	const LogConfig* config = logConfigGet();
+	if (assertEnabled(config, result, callSite, category)) {
+		bool fatal = (uint)result >= (uint)config->assertLevel;
+		LogRecord record;
+		fillLogRecord(&record, config, LOG_RECORD_TYPE_ASSERT, result, line, file, func, category, format);
+		va_list args;
+		va_start(args, format);
+		submitFormattedLogRecord(&record, fatal, fatal ? nullptr : findRateLimit(config, callSite, category, result), callSite, args);
+		va_end(args);
+	}
+	finishAssert(config, result, valid);
+}
+
+void avLog_(AvResult result, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg) {
+	avLogSite_(result, nullptr, line, file, func, category, msg);
+}
+
+void avAssert_(AvResult result, AvResult valid, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* msg) {
+	avAssertSite_(result, valid, nullptr, line, file, func, category, msg);
+}
@@ -1,20 +1,17 @@
 #pragma once
 #include "../core.h"
 
-extern const char* AV_COLOR_RED;
-extern const char* AV_COLOR_GREEN;
-extern const char* AV_COLOR_YELLOW  ;
-extern const char* AV_COLOR_BLUE    ;
-extern const char* AV_COLOR_MAGENTA ;
-extern const char* AV_COLOR_CYAN    ;
-extern const char* AV_COLOR_RESET   ;
-
-extern AvLogLevel AV_LOG_LEVEL;
-
+typedef struct LogConfig LogConfig;
 
 void setLogSettings(AvLogSettings settings);
 void setProjectDetails(const char* projectName, uint version);
 
+/// <summary>
+/// builds the log settings of an instance without publishing them, settings may be nullptr to start from the published ones.
+/// the outputs of settings are ignored, the sinks, binary log and queue stay as the first instance configured them
+/// </summary>
+LogConfig* createInstanceLogConfig(const AvLogSettings* settings, const char* projectName, uint version);
+
 typedef enum ValidationMessageType {
 	VALIDATION_MESSAGE_TYPE_DEVICE_ADDRESS,
 	VALIDATION_MESSAGE_TYPE_GENERAL,
@@ -22,4 +19,82 @@ typedef enum ValidationMessageType {
 	VALIDATION_MESSAGE_TYPE_PERFORMANCE,
 }ValidationMessageType;
 
-void logDeviceValidation(const char* renderer, AvValidationLevel level, ValidationMessageType type, const char* message);
\ No newline at end of file
+void logDeviceValidation(const char* renderer, AvValidationLevel level, ValidationMessageType type, const char* message);
+
+typedef enum LogRecordType {
+	LOG_RECORD_TYPE_LOG,
+	LOG_RECORD_TYPE_ASSERT,
+	LOG_RECORD_TYPE_VALIDATION,
+}LogRecordType;
+
+/// <summary>
+/// a log message with its tags, captured on the thread that logs it. file, func and category have to be static strings.
+/// validation records store the renderer in category and the ValidationMessageType in result.
+/// when args is set, message is the format string and args holds the arguments captured by logArgsCapture
+/// </summary>
+typedef struct LogRecord {
+	// the settings the record was logged under
+	const LogConfig* config;
+	LogRecordType type;
+	AvResult result;
+	uint64 line;
+	const char* file;
+	const char* func;
+	const char* category;
+	// monotonic, in microseconds
+	uint64 timestamp;
+	const char* message;
+	const byte* args;
+	uint64 argsSize;
+}LogRecord;
+
+/// <summary>
+/// formats a record to the log output, called by the log writer thread or directly when logging synchronously
+/// </summary>
+void writeLogRecord(const LogRecord* record);
+
+void flushLogOutput();
+
+/// <summary>
+/// monotonic time in microseconds
+/// </summary>
+uint64 getLogTimestamp();
+
+/// <summary>
+/// wall clock time in microseconds since the unix epoch
+/// </summary>
+uint64 getLogWallClock();
+
+/// <summary>
+/// marks the start of the instance, relative timestamps are measured from here.
+/// has to be called before other threads start logging
+/// </summary>
+void startLogClock();
+
+/// <summary>
+/// the log timestamp at which the log clock was started and the wall clock time at that moment.
+/// when the clock was never started both are taken now
+/// </summary>
+void getLogClockBase(uint64* timestamp, uint64* wallClock);
+
+/// <summary>
+/// sets the log clock start to a previously recorded moment, used to print timestamps read back from a binary log
+/// </summary>
+void setLogClockBase(uint64 timestamp, uint64 wallClock);
+
+/// <summary>
+/// writes the rate limit summaries whose interval is over, called once per frame so they are also written
+/// when logging is synchronous and the call site does not log again
+/// </summary>
+void flushExpiredLogSummaries();
+
+/// <summary>
+/// writes all pending messages and stops the log writer thread, logging after this is synchronous
+/// </summary>
+void shutdownLogging();
+
+/// <summary>
+/// shuts logging down and frees the memory it kept for logging afterwards, messages go to stdout until the next settings are set.
+/// called before the allocation callbacks are reset
+/// </summary>
+void releaseLogging();
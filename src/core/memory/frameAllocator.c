@@ -0,0 +1,69 @@
+#include "frameAllocator.h"
+#include "linearAllocator.h"
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_memory"
+
+typedef struct FrameAllocator_T {
+	uint frameCount;
+	uint frameIndex;
+	LinearAllocator* allocators;
+} FrameAllocator_T;
+
+void frameAllocatorCreate(uint frameCount, uint64 capacity, FrameAllocator* allocator) {
+	if (frameCount == 0) {
+		avAssert(AV_INVALID_ARGUMENTS, AV_SUCCESS, "frame allocator needs at least one frame");
+		frameCount = 1;
+	}
+	if (capacity == 0) {
+		capacity = FRAME_ALLOCATOR_DEFAULT_CAPACITY;
+	}
+	(*allocator) = avAllocate(sizeof(FrameAllocator_T), 1, "allocating frame allocator handle");
+	(*allocator)->frameCount = frameCount;
+	(*allocator)->allocators = avAllocate(sizeof(LinearAllocator), frameCount, "allocating frame allocators");
+	for (uint i = 0; i < frameCount; i++) {
+		linearAllocatorCreate(capacity, &(*allocator)->allocators[i]);
+	}
+	avLog(AV_DEBUG_CREATE, "created frame allocator");
+}
+
+void frameAllocatorDestroy(FrameAllocator allocator) {
+	for (uint i = 0; i < allocator->frameCount; i++) {
+		linearAllocatorDestroy(allocator->allocators[i]);
+	}
+	avFree(allocator->allocators);
+	avFree(allocator);
+	avLog(AV_DEBUG_DESTROY, "destroyed frame allocator");
+}
+
+void frameAllocatorNextFrame(FrameAllocator allocator) {
+	allocator->frameIndex = (allocator->frameIndex + 1) % allocator->frameCount;
+	linearAllocatorReset(allocator->allocators[allocator->frameIndex]);
+}
+
+void* frameAllocatorAllocate(uint64 size, uint64 alignment, FrameAllocator allocator) {
+	return linearAllocatorAllocate(size, alignment, allocator->allocators[allocator->frameIndex]);
+}
+
+uint frameAllocatorGetFrameCount(FrameAllocator allocator) {
+	return allocator->frameCount;
+}
+
+uint64 frameAllocatorGetUsed(FrameAllocator allocator) {
+	return linearAllocatorGetUsed(allocator->allocators[allocator->frameIndex]);
+}
+
+uint64 frameAllocatorGetCapacity(FrameAllocator allocator) {
+	return linearAllocatorGetCapacity(allocator->allocators[allocator->frameIndex]);
+}
+
+uint64 frameAllocatorGetHighWaterMark(FrameAllocator allocator) {
+	uint64 highWaterMark = 0;
+	for (uint i = 0; i < allocator->frameCount; i++) {
+		uint64 mark = linearAllocatorGetHighWaterMark(allocator->allocators[i]);
+		if (mark > highWaterMark) {
+			highWaterMark = mark;
+		}
+	}
+	return highWaterMark;
+}
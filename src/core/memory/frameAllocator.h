@@ -0,0 +1,28 @@
+#pragma once
+#include "../core.h"
+
+// One linear allocator per frame in flight. Memory handed out during a frame
+// stays valid until the same allocator comes around again, so data recorded
+// for the gpu is not overwritten while that frame may still be in flight.
+
+#define FRAME_ALLOCATOR_DEFAULT_CAPACITY (1024 * 1024)
+
+typedef struct FrameAllocator_T* FrameAllocator;
+
+void frameAllocatorCreate(uint frameCount, uint64 capacity, FrameAllocator* allocator);
+void frameAllocatorDestroy(FrameAllocator allocator);
+
+/// <summary>
+/// moves to the next frame and resets its allocator, called at the start of every update
+/// </summary>
+void frameAllocatorNextFrame(FrameAllocator allocator);
+
+/// <summary>
+/// returns uninitialized memory that stays valid for frameCount frames
+/// </summary>
+void* frameAllocatorAllocate(uint64 size, uint64 alignment, FrameAllocator allocator);
+
+uint frameAllocatorGetFrameCount(FrameAllocator allocator);
+uint64 frameAllocatorGetUsed(FrameAllocator allocator);
+uint64 frameAllocatorGetCapacity(FrameAllocator allocator);
+uint64 frameAllocatorGetHighWaterMark(FrameAllocator allocator);
@@ -0,0 +1,147 @@
+#include "linearAllocator.h"
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_memory"
+
+typedef struct LinearAllocatorBlock {
+	struct LinearAllocatorBlock* next;
+	uint64 size;
+	uint64 offset;
+} LinearAllocatorBlock;
+
+// keeps the data of overflow blocks aligned to the default alignment
+#define LINEAR_ALLOCATOR_BLOCK_HEADER_SIZE ((sizeof(LinearAllocatorBlock) + LINEAR_ALLOCATOR_DEFAULT_ALIGNMENT - 1) & ~(uint64)(LINEAR_ALLOCATOR_DEFAULT_ALIGNMENT - 1))
+
+typedef struct LinearAllocator_T {
+	byte* memory;
+	uint64 capacity;
+	uint64 offset;
+	// most recent overflow block first
+	LinearAllocatorBlock* overflow;
+	uint64 used;
+	uint64 highWaterMark;
+} LinearAllocator_T;
+
+static inline byte* alignPointer(byte* pointer, uint64 alignment) {
+	return (byte*)(((uint64)pointer + alignment - 1) & ~(alignment - 1));
+}
+
+void linearAllocatorCreate(uint64 capacity, LinearAllocator* allocator) {
+	(*allocator) = avAllocate(sizeof(LinearAllocator_T), 1, "allocating linear allocator handle");
+	(*allocator)->capacity = capacity;
+	if (capacity) {
+		(*allocator)->memory = avAllocateEx(capacity, AV_ALLOCATION_UNINITIALIZED, "allocating linear allocator memory");
+	}
+}
+
+static void freeOverflowBlocks(LinearAllocator allocator) {
+	LinearAllocatorBlock* block = allocator->overflow;
+	while (block) {
+		LinearAllocatorBlock* next = block->next;
+		avFree(block);
+		block = next;
+	}
+	allocator->overflow = nullptr;
+}
+
+void linearAllocatorDestroy(LinearAllocator allocator) {
+	freeOverflowBlocks(allocator);
+	avFree(allocator->memory);
+	avFree(allocator);
+}
+
+static void* allocateOverflow(uint64 size, uint64 alignment, LinearAllocator allocator) {
+	LinearAllocatorBlock* block = allocator->overflow;
+	if (block) {
+		byte* data = (byte*)block + LINEAR_ALLOCATOR_BLOCK_HEADER_SIZE;
+		byte* pointer = alignPointer(data + block->offset, alignment);
+		if (pointer + size <= data + block->size) {
+			block->offset = (uint64)(pointer - data) + size;
+			return pointer;
+		}
+	}
+
+	uint64 blockSize = size + alignment;
+	if (blockSize < allocator->capacity) {
+		blockSize = allocator->capacity;
+	}
+	avLog(AV_DEBUG_INFO, "linear allocator overflowed, allocating additional block");
+	block = avAllocateEx(LINEAR_ALLOCATOR_BLOCK_HEADER_SIZE + blockSize, AV_ALLOCATION_UNINITIALIZED, "allocating linear allocator overflow block");
+	block->size = blockSize;
+	block->next = allocator->overflow;
+	allocator->overflow = block;
+
+	byte* data = (byte*)block + LINEAR_ALLOCATOR_BLOCK_HEADER_SIZE;
+	byte* pointer = alignPointer(data, alignment);
+	block->offset = (uint64)(pointer - data) + size;
+	return pointer;
+}
+
+void* linearAllocatorAllocate(uint64 size, uint64 alignment, LinearAllocator allocator) {
+	if (alignment == 0) {
+		alignment = LINEAR_ALLOCATOR_DEFAULT_ALIGNMENT;
+	}
+
+	void* result;
+	byte* pointer = alignPointer(allocator->memory + allocator->offset, alignment);
+	if (allocator->memory && pointer + size <= allocator->memory + allocator->capacity) {
+		allocator->offset = (uint64)(pointer - allocator->memory) + size;
+		result = pointer;
+	} else {
+		result = allocateOverflow(size, alignment, allocator);
+	}
+
+	allocator->used += size;
+	if (allocator->used > allocator->highWaterMark) {
+		allocator->highWaterMark = allocator->used;
+	}
+	return result;
+}
+
+void linearAllocatorReset(LinearAllocator allocator) {
+	if (allocator->overflow) {
+		// grow so everything of this cycle would have fit, with some headroom for alignment padding.
+		// an allocator created without memory starts from what was used, doubling 0 would never get there
+		uint64 capacity = allocator->capacity ? allocator->capacity * 2 : allocator->used;
+		if (capacity < LINEAR_ALLOCATOR_DEFAULT_ALIGNMENT) {
+			capacity = LINEAR_ALLOCATOR_DEFAULT_ALIGNMENT;
+		}
+		while (capacity < allocator->used + allocator->used / 4) {
+			capacity *= 2;
+		}
+		freeOverflowBlocks(allocator);
+		avFree(allocator->memory);
+		allocator->memory = avAllocateEx(capacity, AV_ALLOCATION_UNINITIALIZED, "growing linear allocator memory");
+		allocator->capacity = capacity;
+	}
+	allocator->offset = 0;
+	allocator->used = 0;
+}
+
+uint64 linearAllocatorGetUsed(LinearAllocator allocator) {
+	return allocator->used;
+}
+
+uint64 linearAllocatorGetCapacity(LinearAllocator allocator) {
+	return allocator->capacity;
+}
+
+uint64 linearAllocatorGetHighWaterMark(LinearAllocator allocator) {
+	return allocator->highWaterMark;
+}
+
+static void* linearAllocatorInterfaceAllocate(uint64 size, void* userData) {
+	return linearAllocatorAllocate(size, 0, (LinearAllocator)userData);
+}
+
+static void linearAllocatorInterfaceFree(void* data, void* userData) {
+	// memory is released by linearAllocatorReset
+}
+
+Allocator linearAllocatorGetInterface(LinearAllocator allocator) {
+	Allocator result;
+	result.allocate = linearAllocatorInterfaceAllocate;
+	result.free = linearAllocatorInterfaceFree;
+	result.userData = allocator;
+	return result;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "../core.h"
+#include "../util/allocator.h"
+
+// Bump allocator for short lived data. Allocations are never freed one by one,
+// the whole allocator is reset at once. When the block runs out, overflow
+// blocks are chained so allocations never fail; on the next reset the block is
+// grown to fit everything that was allocated, so overflow only happens while
+// the allocator is warming up.
+
+#define LINEAR_ALLOCATOR_DEFAULT_ALIGNMENT 16
+
+typedef struct LinearAllocator_T* LinearAllocator;
+
+void linearAllocatorCreate(uint64 capacity, LinearAllocator* allocator);
+void linearAllocatorDestroy(LinearAllocator allocator);
+
+/// <summary>
+/// returns uninitialized memory that stays valid until the next reset. alignment has to be a power of two, 0 selects the default
+/// </summary>
+void* linearAllocatorAllocate(uint64 size, uint64 alignment, LinearAllocator allocator);
+
+/// <summary>
+/// releases every allocation at once, merges overflow blocks in to a single larger block
+/// </summary>
+void linearAllocatorReset(LinearAllocator allocator);
+
+uint64 linearAllocatorGetUsed(LinearAllocator allocator);
+uint64 linearAllocatorGetCapacity(LinearAllocator allocator);
+uint64 linearAllocatorGetHighWaterMark(LinearAllocator allocator);
+
+/// <summary>
+/// wraps the linear allocator in the generic allocator interface, free is a no op
+/// </summary>
+Allocator linearAllocatorGetInterface(LinearAllocator allocator);
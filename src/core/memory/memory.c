@@ -0,0 +1,224 @@
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+// posix_memalign and madvise
+#define _DEFAULT_SOURCE
+#endif
+#include "memory.h"
+#include "memoryTracker.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_memory"
+
+static AvAllocationCallbacks allocationCallbacks = { 0 };
+static bool customAllocationCallbacks = false;
+
+void setAllocationCallbacks(const AvAllocationCallbacks* callbacks) {
+	if (callbacks == nullptr) {
+		memset(&allocationCallbacks, 0, sizeof(AvAllocationCallbacks));
+		customAllocationCallbacks = false;
+		return;
+	}
+	if (callbacks->pfnAllocation == nullptr || callbacks->pfnReallocation == nullptr || callbacks->pfnFree == nullptr) {
+		avAssert(AV_INVALID_ARGUMENTS, AV_SUCCESS, "allocation callbacks need an allocation, reallocation and free function");
+		return;
+	}
+	if (callbacks->alignment & (callbacks->alignment - 1)) {
+		avAssert(AV_INVALID_ARGUMENTS, AV_SUCCESS, "allocation alignment must be a power of two");
+		return;
+	}
+	allocationCallbacks = *callbacks;
+	if (allocationCallbacks.alignment < AV_ALLOCATION_ALIGNMENT_DEFAULT) {
+		allocationCallbacks.alignment = AV_ALLOCATION_ALIGNMENT_DEFAULT;
+	}
+	customAllocationCallbacks = true;
+	avLog(AV_DEBUG_INFO, "using host allocation callbacks");
+}
+
+const AvAllocationCallbacks* getAllocationCallbacks() {
+	return customAllocationCallbacks ? &allocationCallbacks : nullptr;
+}
+
+bool hasCustomAllocationCallbacks() {
+	return customAllocationCallbacks;
+}
+
+uint64 getAllocationAlignment() {
+	return customAllocationCallbacks ? allocationCallbacks.alignment : AV_ALLOCATION_ALIGNMENT_DEFAULT;
+}
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// On windows every allocation of the default path goes through _aligned_malloc,
+// so avFree does not need to know whether an allocation was over aligned.
+
+static void* allocateRaw(uint64 size, uint64 alignment, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	if (customAllocationCallbacks) {
+		if (alignment < allocationCallbacks.alignment) {
+			alignment = allocationCallbacks.alignment;
+		}
+		return allocationCallbacks.pfnAllocation(allocationCallbacks.userData, size, alignment, line, file, func, category);
+	}
+#ifdef _WIN32
+	return _aligned_malloc((size_t)size, (size_t)(alignment < AV_ALLOCATION_ALIGNMENT_DEFAULT ? AV_ALLOCATION_ALIGNMENT_DEFAULT : alignment));
+#else
+	if (alignment <= AV_ALLOCATION_ALIGNMENT_DEFAULT) {
+		return malloc((size_t)size);
+	}
+	void* data;
+	if (posix_memalign(&data, (size_t)alignment, (size_t)size)) {
+		return nullptr;
+	}
+	return data;
+#endif
+}
+
+static void freeRawWithCallbacks(void* data, const AvAllocationCallbacks* callbacks, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	if (callbacks) {
+		callbacks->pfnFree(callbacks->userData, data, line, file, func, category);
+		return;
+	}
+#ifdef _WIN32
+	_aligned_free(data);
+#else
+	free(data);
+#endif
+}
+
+static void freeRaw(void* data, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	freeRawWithCallbacks(data, getAllocationCallbacks(), line, file, func, category);
+}
+
+static void* reallocateRaw(void* data, uint64 size, uint64 alignment, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	if (customAllocationCallbacks) {
+		if (alignment < allocationCallbacks.alignment) {
+			alignment = allocationCallbacks.alignment;
+		}
+		return allocationCallbacks.pfnReallocation(allocationCallbacks.userData, data, size, alignment, line, file, func, category);
+	}
+#ifdef _WIN32
+	return _aligned_realloc(data, (size_t)size, (size_t)(alignment < AV_ALLOCATION_ALIGNMENT_DEFAULT ? AV_ALLOCATION_ALIGNMENT_DEFAULT : alignment));
+#else
+	void* ptr = realloc(data, (size_t)size);
+	if (ptr == nullptr || ((uint64)ptr & (alignment - 1)) == 0) {
+		return ptr;
+	}
+	// realloc has no alignment parameter, move the data to an aligned block when it came back misaligned.
+	// the old size is unknown, but realloc made sure size bytes are readable
+	void* aligned = allocateRaw(size, alignment, line, file, func, category);
+	if (aligned) {
+		memcpy(aligned, ptr, (size_t)size);
+	}
+	free(ptr);
+	return aligned;
+#endif
+}
+
+static inline uint64 getFlagAlignment(AvAllocationFlags flags) {
+	uint64 alignment = AV_ALLOCATION_FLAGS_GET_ALIGNMENT(flags);
+	if (flags & AV_ALLOCATION_HUGE_PAGES) {
+		alignment = alignment > HUGE_PAGE_SIZE ? alignment : HUGE_PAGE_SIZE;
+	}
+	return alignment ? alignment : AV_ALLOCATION_ALIGNMENT_DEFAULT;
+}
+
+static void adviseHugePages(void* data, uint64 size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	// only whole huge pages can be backed by one, the hint is ignored when transparent huge pages are disabled
+	uint64 start = ((uint64)data + HUGE_PAGE_SIZE - 1) & ~(uint64)(HUGE_PAGE_SIZE - 1);
+	uint64 end = ((uint64)data + size) & ~(uint64)(HUGE_PAGE_SIZE - 1);
+	if (end > start) {
+		madvise((void*)start, (size_t)(end - start), MADV_HUGEPAGE);
+	}
+#endif
+}
+
+static bool validateFlags(AvAllocationFlags flags, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	uint64 alignment = AV_ALLOCATION_FLAGS_GET_ALIGNMENT(flags);
+	if (alignment & (alignment - 1)) {
+		avAssert_(AV_INVALID_ARGUMENTS, AV_SUCCESS, line, file, func, category, "allocation alignment must be a power of two");
+		return false;
+	}
+	return true;
+}
+
+void* avAllocateEx_(uint64 size, AvAllocationFlags flags, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* errorMsg) {
+	if (!validateFlags(flags, line, file, func, category)) {
+		return nullptr;
+	}
+	void* data = allocateRaw(size, getFlagAlignment(flags), line, file, func, category);
+	if (data == nullptr) {
+		avAssert_(AV_MEMORY_ERROR, AV_SUCCESS, line, file, func, category, errorMsg);
+		return nullptr;
+	}
+	if (memoryTrackingEnabled) {
+		trackAllocation(data, size, line, file, func, category);
+	}
+	if (flags & AV_ALLOCATION_HUGE_PAGES) {
+		adviseHugePages(data, size);
+	}
+	if (!(flags & AV_ALLOCATION_UNINITIALIZED)) {
+		memset(data, 0, (size_t)size);
+	}
+	return data;
+}
+
+void* avReallocateEx_(void* data, uint64 size, AvAllocationFlags flags, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* errorMsg) {
+	if (!validateFlags(flags, line, file, func, category)) {
+		return nullptr;
+	}
+	void* ptr = reallocateRaw(data, size, getFlagAlignment(flags), line, file, func, category);
+	if (ptr == nullptr) {
+		avAssert_(AV_MEMORY_ERROR, AV_SUCCESS, line, file, func, category, errorMsg);
+		return nullptr;
+	}
+	if (memoryTrackingEnabled) {
+		trackReallocation(data, ptr, size, line, file, func, category);
+	}
+	if (flags & AV_ALLOCATION_HUGE_PAGES) {
+		adviseHugePages(ptr, size);
+	}
+	return ptr;
+}
+
+void* avAllocate_(uint typeSize, uint count, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* errorMsg) {
+	return avAllocateEx_((uint64)typeSize * (uint64)count, AV_ALLOCATION_ZEROED, line, file, func, category, errorMsg);
+}
+
+void* avReallocate_(void* data, uint typeSize, uint count, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* errorMsg) {
+	return avReallocateEx_(data, (uint64)typeSize * (uint64)count, 0, line, file, func, category, errorMsg);
+}
+
+void avFree_(void* data, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	if (data == nullptr) {
+		return;
+	}
+	if (memoryTrackingEnabled) {
+		trackFree(data);
+	}
+	freeRaw(data, line, file, func, category);
+}
+
+static void* untrackedAllocate(uint64 size, void* userData) {
+	return allocateRaw(size, AV_ALLOCATION_ALIGNMENT_DEFAULT, AV_LOCATION_PARAMS, AV_LOG_CATEGORY);
+}
+
+static void untrackedFree(void* data, void* userData) {
+	freeRaw(data, AV_LOCATION_PARAMS, AV_LOG_CATEGORY);
+}
+
+const Allocator untrackedAllocator = {
+	.allocate = untrackedAllocate,
+	.free = untrackedFree,
+	.userData = nullptr,
+};
+
+void untrackedFreeWithCallbacks(void* data, const AvAllocationCallbacks* callbacks) {
+	freeRawWithCallbacks(data, callbacks, AV_LOCATION_PARAMS, AV_LOG_CATEGORY);
+}
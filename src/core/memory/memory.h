@@ -0,0 +1,35 @@
+#pragma once
+#include "../core.h"
+#include "../util/allocator.h"
+
+/// <summary>
+/// installs the allocation callbacks used by avAllocate, avReallocate and avFree.
+/// nullptr restores the c runtime heap. Has to be called while no memory from the previous callbacks is alive.
+/// </summary>
+void setAllocationCallbacks(const AvAllocationCallbacks* callbacks);
+
+/// <summary>
+/// returns the callbacks supplied by the host, or nullptr when the c runtime heap is used
+/// </summary>
+const AvAllocationCallbacks* getAllocationCallbacks();
+
+/// <summary>
+/// returns true when the host supplied its own allocation callbacks
+/// </summary>
+bool hasCustomAllocationCallbacks();
+
+/// <summary>
+/// returns the alignment every allocation is guaranteed to have
+/// </summary>
+uint64 getAllocationAlignment();
+
+/// <summary>
+/// allocates through the installed callbacks without being recorded by memory tracking, used for the bookkeeping of the tracker itself
+/// </summary>
+extern const Allocator untrackedAllocator;
+
+/// <summary>
+/// frees memory of untrackedAllocator through callbacks instead of the installed ones, for memory that may outlive the callbacks it was allocated with.
+/// nullptr frees to the c runtime heap
+/// </summary>
+void untrackedFreeWithCallbacks(void* data, const AvAllocationCallbacks* callbacks);
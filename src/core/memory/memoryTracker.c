@@ -0,0 +1,274 @@
+#include "memoryTracker.h"
+#include "../util/hashMap.h"
+#include <pthread.h>
+#include <string.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_memory"
+
+typedef struct CallSiteKey {
+	const char* file;
+	uint64 line;
+} CallSiteKey;
+
+typedef struct AllocationRecord {
+	uint64 size;
+	CallSiteKey callSite;
+	const char* category;
+} AllocationRecord;
+
+bool memoryTrackingEnabled = false;
+
+static HashMap allocations = nullptr;
+static HashMap categories = nullptr;
+static HashMap callSites = nullptr;
+static AvMemoryStats totals = { 0 };
+static pthread_mutex_t trackerLock = PTHREAD_MUTEX_INITIALIZER;
+
+// a mutex rather than a spin lock, it is held across inserts that may rehash
+static inline void lockTracker() {
+	pthread_mutex_lock(&trackerLock);
+}
+
+static inline void unlockTracker() {
+	pthread_mutex_unlock(&trackerLock);
+}
+
+void memoryTrackingInit() {
+	if (memoryTrackingEnabled) {
+		return;
+	}
+
+	HashMapCreateInfo createInfo = { 0 };
+	createInfo.allocator = &untrackedAllocator;
+
+	createInfo.keySize = sizeof(void*);
+	createInfo.valueSize = sizeof(AllocationRecord);
+	createInfo.initialCapacity = 1024;
+	hashMapCreate(createInfo, &allocations);
+
+	createInfo.keySize = sizeof(const char*);
+	createInfo.valueSize = sizeof(AvMemoryCategoryStats);
+	createInfo.hash = hashMapHashString;
+	createInfo.equals = hashMapEqualsString;
+	createInfo.initialCapacity = 16;
+	hashMapCreate(createInfo, &categories);
+
+	createInfo.keySize = sizeof(CallSiteKey);
+	createInfo.valueSize = sizeof(AvMemoryCallSiteStats);
+	createInfo.hash = nullptr;
+	createInfo.equals = nullptr;
+	createInfo.initialCapacity = 128;
+	hashMapCreate(createInfo, &callSites);
+
+	memset(&totals, 0, sizeof(AvMemoryStats));
+	totals.trackingEnabled = true;
+	memoryTrackingEnabled = true;
+	avLog(AV_DEBUG_CREATE, "enabled memory tracking");
+}
+
+void memoryTrackingDeinit() {
+	if (!memoryTrackingEnabled) {
+		return;
+	}
+	lockTracker();
+	memoryTrackingEnabled = false;
+	hashMapDestroy(allocations);
+	hashMapDestroy(categories);
+	hashMapDestroy(callSites);
+	allocations = nullptr;
+	categories = nullptr;
+	callSites = nullptr;
+	memset(&totals, 0, sizeof(AvMemoryStats));
+	unlockTracker();
+	avLog(AV_DEBUG_DESTROY, "disabled memory tracking");
+}
+
+// has to be called with the tracker locked
+static void recordAllocation(void* data, uint64 size, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	AllocationRecord record;
+	record.size = size;
+	record.callSite.file = file;
+	record.callSite.line = line;
+	record.category = category;
+	hashMapInsert(&data, &record, allocations);
+
+	AvMemoryCategoryStats* categoryStats = hashMapGet(&category, categories);
+	if (categoryStats == nullptr) {
+		categoryStats = hashMapInsert(&category, nullptr, categories);
+		categoryStats->category = category;
+	}
+	categoryStats->liveBytes += size;
+	categoryStats->liveAllocations++;
+	categoryStats->totalAllocations++;
+	if (categoryStats->liveBytes > categoryStats->peakBytes) {
+		categoryStats->peakBytes = categoryStats->liveBytes;
+	}
+
+	AvMemoryCallSiteStats* callSiteStats = hashMapGet(&record.callSite, callSites);
+	if (callSiteStats == nullptr) {
+		callSiteStats = hashMapInsert(&record.callSite, nullptr, callSites);
+		callSiteStats->file = file;
+		callSiteStats->line = line;
+		callSiteStats->func = func;
+		callSiteStats->category = category;
+	}
+	callSiteStats->liveBytes += size;
+	callSiteStats->liveAllocations++;
+	callSiteStats->totalAllocations++;
+
+	totals.liveBytes += size;
+	totals.liveAllocations++;
+	totals.totalAllocations++;
+	if (totals.liveBytes > totals.peakBytes) {
+		totals.peakBytes = totals.liveBytes;
+	}
+}
+
+// has to be called with the tracker locked, memory that was allocated before tracking started is ignored
+static bool recordFree(void* data) {
+	AllocationRecord* record = hashMapGet(&data, allocations);
+	if (record == nullptr) {
+		return false;
+	}
+
+	AvMemoryCategoryStats* categoryStats = hashMapGet(&record->category, categories);
+	if (categoryStats) {
+		categoryStats->liveBytes -= record->size;
+		categoryStats->liveAllocations--;
+	}
+
+	AvMemoryCallSiteStats* callSiteStats = hashMapGet(&record->callSite, callSites);
+	if (callSiteStats) {
+		callSiteStats->liveBytes -= record->size;
+		callSiteStats->liveAllocations--;
+	}
+
+	totals.liveBytes -= record->size;
+	totals.liveAllocations--;
+	totals.totalFrees++;
+
+	hashMapRemove(&data, allocations);
+	return true;
+}
+
+void trackAllocation(void* data, uint64 size, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	lockTracker();
+	if (memoryTrackingEnabled) {
+		recordAllocation(data, size, line, file, func, category);
+	}
+	unlockTracker();
+}
+
+void trackReallocation(void* original, void* data, uint64 size, AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
+	lockTracker();
+	if (memoryTrackingEnabled) {
+		// a reallocation is not counted as a free
+		if (original && recordFree(original)) {
+			totals.totalFrees--;
+		}
+		recordAllocation(data, size, line, file, func, category);
+	}
+	unlockTracker();
+}
+
+void trackFree(void* data) {
+	lockTracker();
+	if (memoryTrackingEnabled) {
+		recordFree(data);
+	}
+	unlockTracker();
+}
+
+uint64 memoryTrackingReportLeaks() {
+	if (!memoryTrackingEnabled) {
+		return 0;
+	}
+
+	// copy the leaking call sites out first, so nothing is logged while the tracker is locked
+	lockTracker();
+	uint64 leakCount = totals.liveAllocations;
+	uint64 leakBytes = totals.liveBytes;
+	uint callSiteCount = (uint)hashMapGetSize(callSites);
+	AvMemoryCallSiteStats* leaks = untrackedAllocator.allocate(sizeof(AvMemoryCallSiteStats) * (callSiteCount + 1), untrackedAllocator.userData);
+	uint leakingCallSiteCount = 0;
+	uint64 iterator = 0;
+	const void* key;
+	void* value;
+	while (hashMapIterate(&iterator, &key, &value, callSites)) {
+		AvMemoryCallSiteStats* callSite = value;
+		if (callSite->liveAllocations) {
+			leaks[leakingCallSiteCount++] = *callSite;
+		}
+	}
+	unlockTracker();
+
+	for (uint i = 0; i < leakingCallSiteCount; i++) {
+		avLogf(AV_MEMORY_LEAK, "%llu bytes in %llu allocations from %s:%llu %s (%s)",
+			leaks[i].liveBytes, leaks[i].liveAllocations, leaks[i].file, leaks[i].line, leaks[i].func, leaks[i].category);
+	}
+	untrackedAllocator.free(leaks, untrackedAllocator.userData);
+
+	if (leakCount) {
+		avLogf(AV_MEMORY_LEAK, "%llu bytes in %llu allocations were not freed", leakBytes, leakCount);
+	} else {
+		avLog(AV_DEBUG_INFO, "no memory leaks detected");
+	}
+	return leakCount;
+}
+
+void avGetMemoryStats(AvMemoryStats* stats) {
+	lockTracker();
+	*stats = totals;
+	if (memoryTrackingEnabled) {
+		stats->categoryCount = (uint)hashMapGetSize(categories);
+		stats->callSiteCount = (uint)hashMapGetSize(callSites);
+	}
+	unlockTracker();
+}
+
+void avGetMemoryCategoryStats(uint* count, AvMemoryCategoryStats* stats) {
+	lockTracker();
+	if (!memoryTrackingEnabled) {
+		*count = 0;
+		unlockTracker();
+		return;
+	}
+	if (stats == nullptr) {
+		*count = (uint)hashMapGetSize(categories);
+		unlockTracker();
+		return;
+	}
+	uint64 iterator = 0;
+	const void* key;
+	void* value;
+	uint index = 0;
+	while (index < *count && hashMapIterate(&iterator, &key, &value, categories)) {
+		stats[index++] = *(AvMemoryCategoryStats*)value;
+	}
+	*count = index;
+	unlockTracker();
+}
+
+void avGetMemoryCallSiteStats(uint* count, AvMemoryCallSiteStats* stats) {
+	lockTracker();
+	if (!memoryTrackingEnabled) {
+		*count = 0;
+		unlockTracker();
+		return;
+	}
+	if (stats == nullptr) {
+		*count = (uint)hashMapGetSize(callSites);
+		unlockTracker();
+		return;
+	}
+	uint64 iterator = 0;
+	const void* key;
+	void* value;
+	uint index = 0;
+	while (index < *count && hashMapIterate(&iterator, &key, &value, callSites)) {
+		stats[index++] = *(AvMemoryCallSiteStats*)value;
+	}
+	*count = index;
+	unlockTracker();
+}
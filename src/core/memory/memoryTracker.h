@@ -0,0 +1,21 @@
+#pragma once
+#include "../core.h"
+
+// Opt in bookkeeping of every allocation made through avAllocate, avReallocate
+// and avFree. Live allocations are recorded in a hash map keyed on their
+// address, statistics are aggregated per log category and per call site.
+
+// checked by the allocation functions before calling in to the tracker
+extern bool memoryTrackingEnabled;
+
+void memoryTrackingInit();
+void memoryTrackingDeinit();
+
+void trackAllocation(void* data, uint64 size, AV_LOCATION_ARGS, AV_CATEGORY_ARGS);
+void trackReallocation(void* original, void* data, uint64 size, AV_LOCATION_ARGS, AV_CATEGORY_ARGS);
+void trackFree(void* data);
+
+/// <summary>
+/// logs every call site that still has live allocations, returns the number of leaked allocations
+/// </summary>
+uint64 memoryTrackingReportLeaks();
@@ -0,0 +1,260 @@
+#include "poolAllocator.h"
+#include "../util/spinWait.h"
+#include <stdatomic.h>
+#include <string.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_memory"
+
+#define POOL_SIZE_CLASS_COUNT 10
+#define POOL_SIZE_CLASS_GRANULARITY 16
+
+static const uint64 poolSizeClasses[POOL_SIZE_CLASS_COUNT] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512 };
+
+// maps (size + 15) / 16 to the smallest size class that fits
+static const byte poolSizeClassLookup[POOL_ALLOCATOR_MAX_SIZE / POOL_SIZE_CLASS_GRANULARITY + 1] = {
+	0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+	8, 8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9,
+};
+
+typedef struct PoolBlock {
+	struct PoolBlock* next;
+} PoolBlock;
+
+typedef struct PoolChunk {
+	struct PoolChunk* next;
+} PoolChunk;
+
+// keeps the blocks carved from a chunk aligned
+#define POOL_CHUNK_HEADER_SIZE ((sizeof(PoolChunk) + POOL_SIZE_CLASS_GRANULARITY - 1) & ~(uint64)(POOL_SIZE_CLASS_GRANULARITY - 1))
+
+typedef struct PoolSizeClass {
+	PoolBlock* freeList;
+	// unused tail of the most recent chunk of this size class
+	byte* carve;
+	byte* carveEnd;
+} PoolSizeClass;
+
+static PoolSizeClass sizeClasses[POOL_SIZE_CLASS_COUNT];
+static PoolChunk* chunks = nullptr;
+static atomic_flag poolLock = ATOMIC_FLAG_INIT;
+// bumped by poolAllocatorDeinit so thread caches pointing in to released chunks are dropped
+static atomic_uint poolGeneration = 1;
+
+static inline void lockPool() {
+	uint spins = 1;
+	while (atomic_flag_test_and_set_explicit(&poolLock, memory_order_acquire)) {
+		spinWait(&spins);
+	}
+}
+
+static inline void unlockPool() {
+	atomic_flag_clear_explicit(&poolLock, memory_order_release);
+}
+
+static inline uint getSizeClass(uint64 size) {
+	return poolSizeClassLookup[(size + POOL_SIZE_CLASS_GRANULARITY - 1) / POOL_SIZE_CLASS_GRANULARITY];
+}
+
+// has to be called with the pool locked
+static PoolBlock* popSharedBlock(uint sizeClass) {
+	PoolSizeClass* pool = &sizeClasses[sizeClass];
+	PoolBlock* block = pool->freeList;
+	if (block) {
+		pool->freeList = block->next;
+		return block;
+	}
+
+	uint64 blockSize = poolSizeClasses[sizeClass];
+	if (pool->carve == nullptr || pool->carve + blockSize > pool->carveEnd) {
+		PoolChunk* chunk = avAllocateEx(POOL_ALLOCATOR_CHUNK_SIZE, AV_ALLOCATION_UNINITIALIZED, "allocating pool chunk");
+		if (chunk == nullptr) {
+			return nullptr;
+		}
+		chunk->next = chunks;
+		chunks = chunk;
+		pool->carve = (byte*)chunk + POOL_CHUNK_HEADER_SIZE;
+		pool->carveEnd = (byte*)chunk + POOL_ALLOCATOR_CHUNK_SIZE;
+	}
+	block = (PoolBlock*)pool->carve;
+	pool->carve += blockSize;
+	return block;
+}
+
+// has to be called with the pool locked
+static inline void pushSharedBlock(PoolBlock* block, uint sizeClass) {
+	block->next = sizeClasses[sizeClass].freeList;
+	sizeClasses[sizeClass].freeList = block;
+}
+
+#if POOL_ALLOCATOR_THREAD_CACHE
+
+typedef struct PoolThreadCache {
+	uint generation;
+	uint count[POOL_SIZE_CLASS_COUNT];
+	PoolBlock* freeList[POOL_SIZE_CLASS_COUNT];
+} PoolThreadCache;
+
+static _Thread_local PoolThreadCache threadCache;
+
+static inline void validateThreadCache() {
+	uint generation = atomic_load_explicit(&poolGeneration, memory_order_relaxed);
+	if (threadCache.generation != generation) {
+		memset(&threadCache, 0, sizeof(PoolThreadCache));
+		threadCache.generation = generation;
+	}
+}
+
+static void refillThreadCache(uint sizeClass) {
+	lockPool();
+	for (uint i = 0; i < POOL_ALLOCATOR_THREAD_CACHE_BATCH; i++) {
+		PoolBlock* block = popSharedBlock(sizeClass);
+		if (block == nullptr) {
+			break;
+		}
+		block->next = threadCache.freeList[sizeClass];
+		threadCache.freeList[sizeClass] = block;
+		threadCache.count[sizeClass]++;
+	}
+	unlockPool();
+}
+
+static void flushThreadCacheBlocks(uint sizeClass, uint count) {
+	lockPool();
+	for (uint i = 0; i < count && threadCache.freeList[sizeClass]; i++) {
+		PoolBlock* block = threadCache.freeList[sizeClass];
+		threadCache.freeList[sizeClass] = block->next;
+		threadCache.count[sizeClass]--;
+		pushSharedBlock(block, sizeClass);
+	}
+	unlockPool();
+}
+
+void* poolAllocate(uint64 size) {
+	if (size > POOL_ALLOCATOR_MAX_SIZE) {
+		return avAllocateEx(size, AV_ALLOCATION_UNINITIALIZED, "allocating block larger than the pool size classes");
+	}
+	uint sizeClass = getSizeClass(size);
+	validateThreadCache();
+	if (threadCache.freeList[sizeClass] == nullptr) {
+		refillThreadCache(sizeClass);
+		if (threadCache.freeList[sizeClass] == nullptr) {
+			avAssert(AV_MEMORY_ERROR, AV_SUCCESS, "failed to allocate from pool");
+			return nullptr;
+		}
+	}
+	PoolBlock* block = threadCache.freeList[sizeClass];
+	threadCache.freeList[sizeClass] = block->next;
+	threadCache.count[sizeClass]--;
+	return block;
+}
+
+void poolFree(void* data, uint64 size) {
+	if (data == nullptr) {
+		return;
+	}
+	if (size > POOL_ALLOCATOR_MAX_SIZE) {
+		avFree(data);
+		return;
+	}
+	uint sizeClass = getSizeClass(size);
+	validateThreadCache();
+	PoolBlock* block = data;
+	block->next = threadCache.freeList[sizeClass];
+	threadCache.freeList[sizeClass] = block;
+	threadCache.count[sizeClass]++;
+	if (threadCache.count[sizeClass] > POOL_ALLOCATOR_THREAD_CACHE_BATCH * 2) {
+		flushThreadCacheBlocks(sizeClass, POOL_ALLOCATOR_THREAD_CACHE_BATCH);
+	}
+}
+
+void poolFlushThreadCache() {
+	validateThreadCache();
+	for (uint i = 0; i < POOL_SIZE_CLASS_COUNT; i++) {
+		flushThreadCacheBlocks(i, threadCache.count[i]);
+	}
+}
+
+#else
+
+void* poolAllocate(uint64 size) {
+	if (size > POOL_ALLOCATOR_MAX_SIZE) {
+		return avAllocateEx(size, AV_ALLOCATION_UNINITIALIZED, "allocating block larger than the pool size classes");
+	}
+	lockPool();
+	PoolBlock* block = popSharedBlock(getSizeClass(size));
+	unlockPool();
+	if (block == nullptr) {
+		avAssert(AV_MEMORY_ERROR, AV_SUCCESS, "failed to allocate from pool");
+	}
+	return block;
+}
+
+void poolFree(void* data, uint64 size) {
+	if (data == nullptr) {
+		return;
+	}
+	if (size > POOL_ALLOCATOR_MAX_SIZE) {
+		avFree(data);
+		return;
+	}
+	lockPool();
+	pushSharedBlock(data, getSizeClass(size));
+	unlockPool();
+}
+
+void poolFlushThreadCache() {
+}
+
+#endif
+
+void* poolAllocateZeroed(uint64 size) {
+	void* data = poolAllocate(size);
+	if (data) {
+		memset(data, 0, size);
+	}
+	return data;
+}
+
+void poolPrewarm(uint64 size, uint count) {
+	if (size > POOL_ALLOCATOR_MAX_SIZE) {
+		avAssert(AV_INVALID_ARGUMENTS, AV_SUCCESS, "prewarming pool with size larger than the pool size classes");
+		return;
+	}
+	uint sizeClass = getSizeClass(size);
+
+	lockPool();
+	uint available = 0;
+	for (PoolBlock* block = sizeClasses[sizeClass].freeList; block && available < count; block = block->next) {
+		available++;
+	}
+	PoolBlock* carved = nullptr;
+	for (; available < count; available++) {
+		PoolBlock* block = popSharedBlock(sizeClass);
+		if (block == nullptr) {
+			break;
+		}
+		block->next = carved;
+		carved = block;
+	}
+	while (carved) {
+		PoolBlock* next = carved->next;
+		pushSharedBlock(carved, sizeClass);
+		carved = next;
+	}
+	unlockPool();
+}
+
+void poolAllocatorDeinit() {
+	lockPool();
+	PoolChunk* chunk = chunks;
+	while (chunk) {
+		PoolChunk* next = chunk->next;
+		avFree(chunk);
+		chunk = next;
+	}
+	chunks = nullptr;
+	memset(sizeClasses, 0, sizeof(sizeClasses));
+	atomic_fetch_add_explicit(&poolGeneration, 1, memory_order_relaxed);
+	unlockPool();
+}
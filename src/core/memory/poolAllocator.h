@@ -0,0 +1,54 @@
+#pragma once
+#include "../core.h"
+
+// Size class pool allocator for small fixed size records like tokens, syntax
+// nodes and component child lists.
+//
+// Requests are rounded up to one of the size classes below, every class keeps
+// an intrusive free list of blocks carved out of larger chunks. Freed blocks
+// are reused directly, so creating and destroying records at a high rate never
+// touches the general purpose heap once the pool is warm. Requests larger than
+// the biggest size class are forwarded to avAllocate and avFree.
+//
+// Each thread keeps a small cache of blocks per size class when
+// POOL_ALLOCATOR_THREAD_CACHE is enabled, only refilling and flushing that
+// cache takes the lock of the shared pool.
+
+#ifndef POOL_ALLOCATOR_THREAD_CACHE
+#define POOL_ALLOCATOR_THREAD_CACHE 1
+#endif
+
+#define POOL_ALLOCATOR_MAX_SIZE 512
+#define POOL_ALLOCATOR_CHUNK_SIZE (64 * 1024)
+// number of blocks moved between a thread cache and the shared pool at once
+#define POOL_ALLOCATOR_THREAD_CACHE_BATCH 32
+
+/// <summary>
+/// returns uninitialized memory of at least size bytes, aligned to 16 bytes
+/// </summary>
+void* poolAllocate(uint64 size);
+
+/// <summary>
+/// returns zero initialized memory of at least size bytes, aligned to 16 bytes
+/// </summary>
+void* poolAllocateZeroed(uint64 size);
+
+/// <summary>
+/// returns a block to the pool, size has to be the size it was allocated with
+/// </summary>
+void poolFree(void* data, uint64 size);
+
+/// <summary>
+/// makes sure count blocks of the size class of size are available without allocating
+/// </summary>
+void poolPrewarm(uint64 size, uint count);
+
+/// <summary>
+/// hands the blocks cached by the calling thread back to the shared pool. Threads that used the pool should call this before exiting
+/// </summary>
+void poolFlushThreadCache();
+
+/// <summary>
+/// releases all chunks, every block allocated from the pool becomes invalid
+/// </summary>
+void poolAllocatorDeinit();
@@ -6,6 +6,8 @@ typedef struct RenderDevice_T* RenderDevice;
 typedef struct DisplaySurface_T* DisplaySurface;
 typedef struct Window_T* Window;
 
+#define MAX_FRAMES_IN_FLIGHT 2
+
 typedef enum DisplayType {
 	DISPLAY_TYPE_MONITOR,
 	DISPLAY_TYPE_EMBEDDED
@@ -49,6 +51,8 @@ const char** displaySurfaceEnumerateExtensions(AvInstance instance, uint* count)
 // window
 AvResult displaySurfaceCreateWindow(AvInstance instance, WindowCreateInfo windowCreateInfo, WindowProperties* windowProperties, Window* window);
 void windowUpdateEvents(Window window);
+// blocks until an event arrived or timeout microseconds passed, UINT64_MAX waits without limit
+void windowWaitEvents(Window window, uint64 timeout);
 void displaySurfaceDestroyWindow(AvInstance instance, Window window);
 
 
@@ -71,6 +75,8 @@ typedef enum DeviceStatus {
 	DEVICE_STATUS_SHUTDOWN_REQUESTED = 1 << 1,
 	DEVICE_STATUS_RESIZED = 1 << 2,
 	DEVICE_STATUS_INOPERABLE = 1 << 3,
+	// the window content has to be rendered again, after a resize or when the system lost it
+	DEVICE_STATUS_DAMAGED = 1 << 4,
 }DeviceStatus;
 
 
@@ -78,12 +84,17 @@ DeviceStatus renderInstanceGetStatus(RenderInstance instance);
 DeviceStatus renderDeviceGetStatus(RenderDevice device);
 DeviceStatus displaySurfaceGetStatus(DisplaySurface instance);
 DeviceStatus windowGetStatus(Window window);
+void windowClearStatus(Window window, DeviceStatus status);
 
 bool renderInstanceCheckValidationSupport();
 
 // render device
 typedef struct RenderDeviceCreateInfo {
 	Window window;
+	// file the pipeline cache is loaded from and saved to, nullptr keeps it in memory only
+	const char* pipelineCachePath;
+	// renders through a render pass even when the device supports dynamic rendering
+	bool disableDynamicRendering;
 } RenderDeviceCreateInfo;
 
 typedef struct PipelineCreateInfo {
@@ -97,7 +108,10 @@ void renderDeviceCreatePipelines(RenderDevice device, uint pipelineCount, Pipeli
 void renderDeviceWaitIdle(RenderDevice device);
 
 typedef struct RenderCommandsInfo {
-
+	uint rectCount;
+	const AvRect* rects;
+	uint clipRectCount;
+	const AvClipRect* clipRects;
 } RenderCommandsInfo;
 
 AvResult renderDeviceAquireNextFrame(RenderDevice device);
@@ -1,17 +1,18 @@
 #include "../renderer.h"
 #include "vulkanShaders.h"
+#include "vulkanMemory.h"
+#include "vulkanPipelineCache.h"
 
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 
 #include <string.h>
+#include <stddef.h>
 #include <stdio.h>
 
 #undef AV_LOG_CATEGORY
 #define AV_LOG_CATEGORY "avixel_renderer"
 
-#define MAX_FRAMES_IN_FLIGHT 2
-
 const char* const requiredDefaultExtensions[] = {
 	VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
 };
@@ -56,6 +57,39 @@ typedef struct Pipeline_T {
 	VkPipeline pipeline;
 }Pipeline_T;
 
+// One persistently mapped, host visible buffer for all data that changes every frame, split in to a
+// partition per frame in flight. A partition is only reused after the fence of its frame was waited
+// on, so allocating is a bump pointer and uploading a plain memcpy. When a frame runs out of space
+// the ring is replaced by a larger one right away, the old one is retired until the frames that may
+// still read from it are done.
+#define FRAME_RING_PARTITION_SIZE_DEFAULT (256 * 1024)
+
+typedef struct FrameRing {
+	VkBuffer buffer;
+	GpuAllocation allocation;
+	byte* data;
+	uint64 partitionSize;
+	// start of the partition of the current frame
+	uint64 partitionOffset;
+	// bump pointer in to the current partition
+	uint64 used;
+	// largest amount a single frame used
+	uint64 highWaterMark;
+}FrameRing;
+
+typedef struct RetiredFrameRing {
+	FrameRing ring;
+	// frames that have to begin before nothing reads from the ring anymore
+	uint framesLeft;
+	struct RetiredFrameRing* next;
+}RetiredFrameRing;
+
+typedef struct FrameRingAllocation {
+	VkBuffer buffer;
+	VkDeviceSize offset;
+	void* data;
+}FrameRingAllocation;
+
 typedef struct RenderDevice_T {
 	DeviceStatus status;
 	Window window;
@@ -64,31 +98,63 @@ typedef struct RenderDevice_T {
 
 	VkPhysicalDevice physicalDevice;
 	VkDevice device;
+	GpuAllocator memoryAllocator;
+	PipelineCache pipelineCache;
 
 	QueueFamilyIndices queueFamilyIndices;
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
 
-	VkCommandPool commandPool;
-
 	Pipeline_T renderPipeline;
 	Pipeline_T fontPipeline;
+
+	// vulkan 1.3 or VK_KHR_dynamic_rendering, rendering begins on the image views directly and
+	// neither the render pass nor the framebuffers are created
+	bool dynamicRendering;
+	PFN_vkCmdBeginRendering cmdBeginRendering;
+	PFN_vkCmdEndRendering cmdEndRendering;
+
+	VkDeviceSize nonCoherentAtomSize;
+	FrameRing frameRing;
+	RetiredFrameRing* retiredFrameRings;
 } RenderDevice_T;
 
-typedef struct Frame {
-	VkFramebuffer framebuffer;
+// resources of one swapchain image, recreated together with the swapchain
+typedef struct SwapchainImage {
 	VkImage image;
 	VkImageView imageView;
+	// VK_NULL_HANDLE with dynamic rendering
+	VkFramebuffer framebuffer;
 
-	VkCommandBuffer* pCommandBuffer;
-	VkCommandPool* commandPool;
-
-	VkSemaphore imageAvailable;
+	// waited on by the presentation, so it stays in use until the image is acquired again
 	VkSemaphore renderFinished;
+	// fence of the frame that rendered to the image last, VK_NULL_HANDLE when it was never rendered to
 	VkFence inFlight;
+}SwapchainImage;
+
+// A swapchain replaced by a recreation. It was passed as oldSwapchain, so the new one is created
+// while frames still render to and present from the old images. Its framebuffers, image views and
+// semaphores are destroyed once the fences of every frame that was in flight at the time were
+// waited on, nothing waits for the whole device to become idle.
+typedef struct RetiredSwapchain {
+	VkSwapchainKHR swapchain;
+	uint imageCount;
+	SwapchainImage* images;
+	// frames that have to begin before nothing uses the swapchain anymore
+	uint framesLeft;
+	struct RetiredSwapchain* next;
+}RetiredSwapchain;
 
-	VkFormat* format;
-	VkExtent2D* extent;
+_Static_assert(sizeof(AvRect) == 28, "queued rectangles are copied as tightly packed instance data");
+
+// cpu side context of a frame in flight, independent of which swapchain image it renders to.
+// while the gpu renders one frame the cpu already records the next one with another context
+typedef struct Frame {
+	VkCommandPool commandPool;
+	VkCommandBuffer commandBuffer;
+
+	VkSemaphore imageAvailable;
+	VkFence inFlight;
 }Frame;
 
 typedef struct Window_T {
@@ -101,6 +167,7 @@ typedef struct Window_T {
 	VkSurfaceKHR surface;
 
 	VkSwapchainKHR swapchain;
+	RetiredSwapchain* retiredSwapchains;
 
 	VkExtent2D frameExtent;
 	VkFormat frameFormat;
@@ -108,15 +175,17 @@ typedef struct Window_T {
 	VkPresentModeKHR framePresentMode;
 	VkSurfaceTransformFlagBitsKHR frameTransform;
 
-	uint frameCount;
-	Frame* frames;
+	uint minImageCount;
+	uint imageCount;
+	SwapchainImage* images;
+	uint imageIndex;
+
+	Frame frames[MAX_FRAMES_IN_FLIGHT];
 	uint frameIndex;
-	uint nextFrameIndex;
 
+	// VK_NULL_HANDLE with dynamic rendering
 	VkRenderPass renderPass;
 
-	VkCommandBuffer* commandBuffers;
-
 	void (*onWindowResize)(AvWindow window, uint width, uint height);
 	void (*onWindowDisconnect)(AvWindow window);
 } Window_T;
@@ -135,12 +204,92 @@ void checkCreation_(VkResult result, const char* msg, AV_LOCATION_ARGS, AV_CATEG
 }
 #define checkCreation(result, msg) checkCreation_(result,msg, AV_LOCATION_PARAMS, AV_LOG_CATEGORY)
 
+// host allocation callbacks forwarded to vulkan and glfw, nullptr when the host did not supply any
+static VkAllocationCallbacks vulkanAllocationCallbacks;
+static const VkAllocationCallbacks* vulkanAllocator = nullptr;
+
+static void* VKAPI_CALL vulkanAllocate(void* userData, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+	const AvAllocationCallbacks* callbacks = userData;
+	if (alignment < callbacks->alignment) {
+		alignment = callbacks->alignment;
+	}
+	return callbacks->pfnAllocation(callbacks->userData, size, alignment, AV_LOCATION_PARAMS, AV_LOG_CATEGORY);
+}
+
+static void* VKAPI_CALL vulkanReallocate(void* userData, void* original, size_t size, size_t alignment, VkSystemAllocationScope scope) {
+	const AvAllocationCallbacks* callbacks = userData;
+	if (size == 0) {
+		if (original) {
+			callbacks->pfnFree(callbacks->userData, original, AV_LOCATION_PARAMS, AV_LOG_CATEGORY);
+		}
+		return nullptr;
+	}
+	if (alignment < callbacks->alignment) {
+		alignment = callbacks->alignment;
+	}
+	return callbacks->pfnReallocation(callbacks->userData, original, size, alignment, AV_LOCATION_PARAMS, AV_LOG_CATEGORY);
+}
+
+static void VKAPI_CALL vulkanFree(void* userData, void* memory) {
+	const AvAllocationCallbacks* callbacks = userData;
+	if (memory) {
+		callbacks->pfnFree(callbacks->userData, memory, AV_LOCATION_PARAMS, AV_LOG_CATEGORY);
+	}
+}
+
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+static void* glfwAllocate(size_t size, void* userData) {
+	const AvAllocationCallbacks* callbacks = userData;
+	return callbacks->pfnAllocation(callbacks->userData, size, callbacks->alignment, AV_LOCATION_PARAMS, "glfw");
+}
+
+static void* glfwReallocate(void* block, size_t size, void* userData) {
+	const AvAllocationCallbacks* callbacks = userData;
+	return callbacks->pfnReallocation(callbacks->userData, block, size, callbacks->alignment, AV_LOCATION_PARAMS, "glfw");
+}
+
+static void glfwDeallocate(void* block, void* userData) {
+	const AvAllocationCallbacks* callbacks = userData;
+	callbacks->pfnFree(callbacks->userData, block, AV_LOCATION_PARAMS, "glfw");
+}
+#endif
+
+static void setupRendererAllocationCallbacks() {
+	const AvAllocationCallbacks* callbacks = getAllocationCallbacks();
+	if (callbacks == nullptr) {
+		vulkanAllocator = nullptr;
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+		glfwInitAllocator(NULL);
+#endif
+		return;
+	}
+
+	vulkanAllocationCallbacks.pUserData = (void*)callbacks;
+	vulkanAllocationCallbacks.pfnAllocation = vulkanAllocate;
+	vulkanAllocationCallbacks.pfnReallocation = vulkanReallocate;
+	vulkanAllocationCallbacks.pfnFree = vulkanFree;
+	vulkanAllocationCallbacks.pfnInternalAllocation = nullptr;
+	vulkanAllocationCallbacks.pfnInternalFree = nullptr;
+	vulkanAllocator = &vulkanAllocationCallbacks;
+
+#if GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4)
+	GLFWallocator glfwAllocator = { 0 };
+	glfwAllocator.allocate = glfwAllocate;
+	glfwAllocator.reallocate = glfwReallocate;
+	glfwAllocator.deallocate = glfwDeallocate;
+	glfwAllocator.user = (void*)callbacks;
+	glfwInitAllocator(&glfwAllocator);
+#endif
+}
+
 RendererType getRendererType() {
 	return RENDERER_TYPE_VULKAN;
 }
 
 AvResult displaySurfaceInit(AvInstance instance) {
 
+	// the display surface is initialized first, so the allocators for both glfw and vulkan are set up here
+	setupRendererAllocationCallbacks();
 	glfwInit();
 
 	instance->displaySurface = avAllocate(sizeof(DisplaySurface_T), 1, "allocating displaysurface handle");
@@ -157,9 +306,7 @@ AvResult displaySurfaceInit(AvInstance instance) {
 	instance->displaySurface->height = mode->height;
 	instance->displaySurface->type = DISPLAY_TYPE_MONITOR;
 
-	char monitorSize[32];
-	sprintf(monitorSize, "display surface size %ix%i", mode->width, mode->height);
-	avLog(AV_DEBUG_INFO, monitorSize);
+	avLogf(AV_DEBUG_INFO, "display surface size %ix%i", mode->width, mode->height);
 
 	avLog(AV_DEBUG_CREATE, "initialized display surface");
 
@@ -193,7 +340,7 @@ const char** displaySurfaceEnumerateExtensions(AvInstance instance, uint* count)
 void onWindowResize(GLFWwindow* glfwWindow, int width, int height) {
 	Window window = (Window)glfwGetWindowUserPointer(glfwWindow);
 
-	window->status |= DEVICE_STATUS_RESIZED;
+	window->status |= DEVICE_STATUS_RESIZED | DEVICE_STATUS_DAMAGED;
 
 	if (width == 0 || height == 0) {
 		window->status |= DEVICE_STATUS_INOPERABLE;
@@ -208,6 +355,12 @@ void onWindowResize(GLFWwindow* glfwWindow, int width, int height) {
 	}
 }
 
+// the system lost the window content, when it was uncovered for example
+void onWindowRefresh(GLFWwindow* glfwWindow) {
+	Window window = (Window)glfwGetWindowUserPointer(glfwWindow);
+	window->status |= DEVICE_STATUS_DAMAGED;
+}
+
 void onWindowCloseRequest(GLFWwindow* glfwWindow) {
 	Window window = (Window)glfwGetWindowUserPointer(glfwWindow);
 
@@ -267,6 +420,7 @@ AvResult displaySurfaceCreateWindow(AvInstance instance, WindowCreateInfo window
 
 	glfwSetWindowCloseCallback((*window)->window, onWindowCloseRequest);
 	glfwSetFramebufferSizeCallback((*window)->window, onWindowResize);
+	glfwSetWindowRefreshCallback((*window)->window, onWindowRefresh);
 
 	if (windowCreateInfo.properties.resizable && !windowCreateInfo.onWindowResize) {
 		avAssert(AV_UNSPECIFIED_CALLBACK, AV_SUCCESS, "window is resizable, but no resize callback is specified");
@@ -290,7 +444,7 @@ AvResult displaySurfaceCreateWindow(AvInstance instance, WindowCreateInfo window
 		windowProperties->size.height = height;
 	}
 
-	VkResult result = glfwCreateWindowSurface(instance->renderInstance->instance, (*window)->window, NULL, &((*window)->surface));
+	VkResult result = glfwCreateWindowSurface(instance->renderInstance->instance, (*window)->window, vulkanAllocator, &((*window)->surface));
 	if (result) {
 		avAssert(AV_NO_SUPPORT, AV_SUCCESS, "failed to create window surface");
 	}
@@ -303,8 +457,19 @@ void windowUpdateEvents(Window window) {
 	glfwPollEvents();
 }
 
+void windowWaitEvents(Window window, uint64 timeout) {
+	// glfw only accepts positive timeouts
+	if (timeout == 0) {
+		glfwPollEvents();
+	} else if (timeout == UINT64_MAX) {
+		glfwWaitEvents();
+	} else {
+		glfwWaitEventsTimeout((double)timeout / 1000000.0);
+	}
+}
+
 void displaySurfaceDestroyWindow(AvInstance instance, Window window) {
-	vkDestroySurfaceKHR(instance->renderInstance->instance, window->surface, nullptr);
+	vkDestroySurfaceKHR(instance->renderInstance->instance, window->surface, vulkanAllocator);
 	avFree(window);
 }
 
@@ -399,7 +564,8 @@ void renderInstanceCreate(AvInstance instance, RenderInstanceCreateInfo info) {
 	// instance creation
 	VkApplicationInfo appInfo = { 0 };
 	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-	appInfo.apiVersion = VK_API_VERSION_1_0;
+	// 1.1 for the memory budget query and 1.3 for dynamic rendering, devices with older versions still work without them
+	appInfo.apiVersion = VK_API_VERSION_1_3;
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
 	appInfo.pEngineName = "AlpineValleyUIengine";
 	appInfo.pApplicationName = info.projectInfo.pProjectName;
@@ -428,7 +594,7 @@ void renderInstanceCreate(AvInstance instance, RenderInstanceCreateInfo info) {
 	instanceInfo.ppEnabledExtensionNames = requiredExtensions;
 
 	VkResult result;
-	result = vkCreateInstance(&instanceInfo, NULL, &instance->renderInstance->instance);
+	result = vkCreateInstance(&instanceInfo, vulkanAllocator, &instance->renderInstance->instance);
 	if (result != VK_SUCCESS) {
 		avAssert(AV_CREATION_ERROR, AV_SUCCESS, "creating the vulkan instance");
 	}
@@ -440,7 +606,7 @@ void renderInstanceCreate(AvInstance instance, RenderInstanceCreateInfo info) {
 		VkDebugUtilsMessengerCreateInfoEXT debugInfo;
 		populateDebugMessengerCreateInfo(&debugInfo);
 		instance->renderInstance->debugMessenger = avAllocate(sizeof(VkDebugUtilsMessengerEXT), 1, "allocating memeory for debug messenger");
-		result = createDebugUtilsMessengerEXT(instance->renderInstance->instance, &debugInfo, NULL, instance->renderInstance->debugMessenger);
+		result = createDebugUtilsMessengerEXT(instance->renderInstance->instance, &debugInfo, vulkanAllocator, instance->renderInstance->debugMessenger);
 		if (result != VK_SUCCESS) {
 			avAssert(AV_CREATION_ERROR, AV_SUCCESS, "creating the validation logger");
 		}
@@ -456,12 +622,12 @@ void renderInstanceDestroy(AvInstance instance) {
 	}
 
 	if (instance->renderInstance->debugMessenger) {
-		destroyDebugUtilsMessengerEXT(instance->renderInstance->instance, *(instance->renderInstance->debugMessenger), NULL);
+		destroyDebugUtilsMessengerEXT(instance->renderInstance->instance, *(instance->renderInstance->debugMessenger), vulkanAllocator);
 		avFree(instance->renderInstance->debugMessenger);
 		avLog(AV_DEBUG_DESTROY, "destroyed validation logger");
 	}
 
-	vkDestroyInstance(instance->renderInstance->instance, NULL);
+	vkDestroyInstance(instance->renderInstance->instance, vulkanAllocator);
 	avLog(AV_DEBUG_DESTROY, "destroyed vulkan instance");
 
 	avFree(instance->renderInstance);
@@ -483,6 +649,10 @@ DeviceStatus windowGetStatus(Window window) {
 	return window->status;
 }
 
+void windowClearStatus(Window window, DeviceStatus status) {
+	window->status &= ~status;
+}
+
 bool renderInstanceCheckValidationSupport() {
 	uint32 layerCount;
 	vkEnumerateInstanceLayerProperties(&layerCount, NULL);
@@ -548,6 +718,34 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, Window window) {
 }
 
 
+bool deviceSupportsExtension(VkPhysicalDevice device, const char* extension) {
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+	VkExtensionProperties* availableExtensions = avAllocate(sizeof(VkExtensionProperties), extensionCount, "enumerating device extension properties");
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions);
+
+	bool found = false;
+	for (uint i = 0; i < extensionCount; i++) {
+		if (strcmp(extension, availableExtensions[i].extensionName) == 0) {
+			found = true;
+			break;
+		}
+	}
+	avFree(availableExtensions);
+	return found;
+}
+
+bool deviceSupportsDynamicRenderingFeature(VkPhysicalDevice device) {
+	VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures = { 0 };
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+	VkPhysicalDeviceFeatures2 features = { 0 };
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &dynamicRenderingFeatures;
+	vkGetPhysicalDeviceFeatures2(device, &features);
+	return dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+}
+
 bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
 	uint32_t extensionCount;
 	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
@@ -702,6 +900,8 @@ VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR capabilities, Window
 
 void renderDeviceCreate(AvInstance instance, RenderDeviceCreateInfo createInfo, RenderDevice* pDevice) {
 	Window window = createInfo.window;
+	bool vulkan11 = false;
+	bool vulkan13 = false;
 
 	*pDevice = avAllocate(sizeof(RenderDevice_T), 1, "allocating render instance");
 	(*pDevice)->instance = instance->renderInstance;
@@ -724,10 +924,7 @@ void renderDeviceCreate(AvInstance instance, RenderDeviceCreateInfo createInfo,
 		VkPhysicalDeviceProperties deviceProperties;
 		vkGetPhysicalDeviceProperties(device, &deviceProperties);
 
-		const char* deviceName = deviceProperties.deviceName;
-		char msg[256 + (sizeof("found device ") / sizeof(char))] = { 0 };
-		sprintf(msg, "found device %s", deviceName);
-		avLog(AV_DEBUG_INFO, msg);
+		avLogf(AV_DEBUG_INFO, "found device %s", deviceProperties.deviceName);
 
 		uint score = scoreDevice(device, window);
 		if (score > bestScore) {
@@ -743,10 +940,10 @@ void renderDeviceCreate(AvInstance instance, RenderDeviceCreateInfo createInfo,
 	} else {
 		VkPhysicalDeviceProperties deviceProperties;
 		vkGetPhysicalDeviceProperties((*pDevice)->physicalDevice, &deviceProperties);
-		const char* deviceName = deviceProperties.deviceName;
-		char msg[256 + (sizeof("selected device ") / sizeof(char))] = { 0 };
-		sprintf(msg, "selected device  %s", deviceName);
-		avLog(AV_DEBUG_INFO, msg);
+		avLogf(AV_DEBUG_INFO, "selected device  %s", deviceProperties.deviceName);
+		vulkan11 = deviceProperties.apiVersion >= VK_API_VERSION_1_1;
+		vulkan13 = deviceProperties.apiVersion >= VK_API_VERSION_1_3;
+		(*pDevice)->nonCoherentAtomSize = deviceProperties.limits.nonCoherentAtomSize ? deviceProperties.limits.nonCoherentAtomSize : 1;
 	}
 	avLog(AV_DEBUG_SUCCESS, "found physical device");
 
@@ -777,8 +974,42 @@ void renderDeviceCreate(AvInstance instance, RenderDeviceCreateInfo createInfo,
 	deviceCreateInfo.queueCreateInfoCount = queueCount;
 	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
 
-	deviceCreateInfo.enabledExtensionCount = deviceExtensionCount;
-	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions;
+	// optional extensions are enabled after the required ones
+	const char** enabledExtensions = avAllocate(sizeof(const char*), deviceExtensionCount + 4, "allocating enabled device extensions");
+	uint enabledExtensionCount = 0;
+	for (uint i = 0; i < deviceExtensionCount; i++) {
+		enabledExtensions[enabledExtensionCount++] = deviceExtensions[i];
+	}
+	bool memoryBudgetEnabled = vulkan11 && deviceSupportsExtension((*pDevice)->physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (memoryBudgetEnabled) {
+		enabledExtensions[enabledExtensionCount++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+	}
+
+	// dynamic rendering is core in 1.3, before that it is an extension that depends on two more
+	bool dynamicRenderingExtension = false;
+	bool dynamicRendering = false;
+	if (vulkan13 && !createInfo.disableDynamicRendering) {
+		dynamicRendering = deviceSupportsDynamicRenderingFeature((*pDevice)->physicalDevice);
+	} else if (vulkan11 && !createInfo.disableDynamicRendering &&
+		deviceSupportsExtension((*pDevice)->physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) &&
+		deviceSupportsExtension((*pDevice)->physicalDevice, VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME) &&
+		deviceSupportsExtension((*pDevice)->physicalDevice, VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME)) {
+		dynamicRenderingExtension = deviceSupportsDynamicRenderingFeature((*pDevice)->physicalDevice);
+		dynamicRendering = dynamicRenderingExtension;
+	}
+	if (dynamicRenderingExtension) {
+		enabledExtensions[enabledExtensionCount++] = VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME;
+		enabledExtensions[enabledExtensionCount++] = VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME;
+		enabledExtensions[enabledExtensionCount++] = VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME;
+	}
+	VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures = { 0 };
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+	dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+	if (dynamicRendering) {
+		deviceCreateInfo.pNext = &dynamicRenderingFeatures;
+	}
+	deviceCreateInfo.enabledExtensionCount = enabledExtensionCount;
+	deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions;
 
 	if (instance->renderInstance->debugMessenger) {
 		deviceCreateInfo.enabledLayerCount = validationLayerCount;
@@ -787,7 +1018,8 @@ void renderDeviceCreate(AvInstance instance, RenderDeviceCreateInfo createInfo,
 		deviceCreateInfo.enabledLayerCount = 0;
 	}
 	VkResult result;
-	result = vkCreateDevice((*pDevice)->physicalDevice, &deviceCreateInfo, nullptr, &(*pDevice)->device);
+	result = vkCreateDevice((*pDevice)->physicalDevice, &deviceCreateInfo, vulkanAllocator, &(*pDevice)->device);
+	avFree(enabledExtensions);
 	if (result != VK_SUCCESS) {
 		avAssert(AV_CREATION_ERROR, AV_SUCCESS, "creating the vulkan logical device");
 	}
@@ -796,16 +1028,38 @@ void renderDeviceCreate(AvInstance instance, RenderDeviceCreateInfo createInfo,
 	vkGetDeviceQueue((*pDevice)->device, indices.graphicsFamily, 0, &(*pDevice)->graphicsQueue);
 	vkGetDeviceQueue((*pDevice)->device, indices.presentFamily, 0, &(*pDevice)->presentQueue);
 
+	if (dynamicRendering) {
+		(*pDevice)->cmdBeginRendering = (PFN_vkCmdBeginRendering)vkGetDeviceProcAddr((*pDevice)->device, dynamicRenderingExtension ? "vkCmdBeginRenderingKHR" : "vkCmdBeginRendering");
+		(*pDevice)->cmdEndRendering = (PFN_vkCmdEndRendering)vkGetDeviceProcAddr((*pDevice)->device, dynamicRenderingExtension ? "vkCmdEndRenderingKHR" : "vkCmdEndRendering");
+		dynamicRendering = (*pDevice)->cmdBeginRendering && (*pDevice)->cmdEndRendering;
+	}
+	(*pDevice)->dynamicRendering = dynamicRendering;
+	avLogf(AV_DEBUG_INFO, "rendering with %s", dynamicRendering ? (dynamicRenderingExtension ? "VK_KHR_dynamic_rendering" : "vulkan 1.3 dynamic rendering") : "a render pass");
+
+	GpuAllocatorCreateInfo allocatorInfo = { 0 };
+	allocatorInfo.physicalDevice = (*pDevice)->physicalDevice;
+	allocatorInfo.device = (*pDevice)->device;
+	allocatorInfo.allocationCallbacks = vulkanAllocator;
+	allocatorInfo.memoryBudgetEnabled = memoryBudgetEnabled;
+	allocatorInfo.vulkan11 = vulkan11;
+	gpuAllocatorCreate(allocatorInfo, &(*pDevice)->memoryAllocator);
+
+	// loaded before the first pipeline is created, so the driver can skip compiling the shaders
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties((*pDevice)->physicalDevice, &deviceProperties);
+	pipelineCacheCreate((*pDevice)->device, &deviceProperties, vulkanAllocator, createInfo.pipelineCachePath, &(*pDevice)->pipelineCache);
 }
 
-void frameCreateSwapchainResources(RenderDevice device, uint frameIndex, VkImage* images, Frame* frame) {
-	frame->image = images[frameIndex];
+void swapchainImageCreateResources(RenderDevice device, VkImage image, SwapchainImage* swapchainImage) {
+	Window window = device->window;
+	swapchainImage->image = image;
+	swapchainImage->inFlight = VK_NULL_HANDLE;
 
 	VkImageViewCreateInfo imageViewInfo = { 0 };
 	imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	imageViewInfo.image = frame->image;
+	imageViewInfo.image = swapchainImage->image;
 	imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	imageViewInfo.format = *(frame->format);
+	imageViewInfo.format = window->frameFormat;
 	imageViewInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
 	imageViewInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
 	imageViewInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -815,48 +1069,68 @@ void frameCreateSwapchainResources(RenderDevice device, uint frameIndex, VkImage
 	imageViewInfo.subresourceRange.levelCount = 1;
 	imageViewInfo.subresourceRange.baseArrayLayer = 0;
 	imageViewInfo.subresourceRange.layerCount = 1;
-	if (vkCreateImageView(device->device, &imageViewInfo, nullptr, &frame->imageView) != VK_SUCCESS) {
+	if (vkCreateImageView(device->device, &imageViewInfo, vulkanAllocator, &swapchainImage->imageView) != VK_SUCCESS) {
 		avAssert(AV_CREATION_ERROR, AV_SUCCESS, "failed to create view in to the swapchain image");
 	}
-	avLog(AV_DEBUG_CREATE, "created image view in frame");
+	avLog(AV_DEBUG_CREATE, "created swapchain image view");
 
-	VkFramebufferCreateInfo framebufferInfo = { 0 };
-	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	framebufferInfo.renderPass = device->window->renderPass;
-	framebufferInfo.attachmentCount = 1;
-	framebufferInfo.pAttachments = &frame->imageView;
-	framebufferInfo.width = frame->extent->width;
-	framebufferInfo.height = frame->extent->height;
-	framebufferInfo.layers = 1;
+	// dynamic rendering renders to the image view, so resizing creates no framebuffers
+	swapchainImage->framebuffer = VK_NULL_HANDLE;
+	if (!device->dynamicRendering) {
+		VkFramebufferCreateInfo framebufferInfo = { 0 };
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = window->renderPass;
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &swapchainImage->imageView;
+		framebufferInfo.width = window->frameExtent.width;
+		framebufferInfo.height = window->frameExtent.height;
+		framebufferInfo.layers = 1;
+
+		checkCreation(
+			vkCreateFramebuffer(device->device, &framebufferInfo, vulkanAllocator, &swapchainImage->framebuffer),
+			"creating framebuffer"
+		);
+		avLog(AV_DEBUG_CREATE, "created framebuffer");
+	}
+
+	VkSemaphoreCreateInfo semaphoreCreateInfo = { 0 };
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreCreateInfo.flags = 0;
+	semaphoreCreateInfo.pNext = nullptr;
 
 	checkCreation(
-		vkCreateFramebuffer(device->device, &framebufferInfo, nullptr, &frame->framebuffer),
-		"creating framebuffer"
+		vkCreateSemaphore(device->device, &semaphoreCreateInfo, vulkanAllocator, &swapchainImage->renderFinished),
+		"creating render finished semaphore"
 	);
-	avLog(AV_DEBUG_CREATE, "created framebuffer");
+	avLog(AV_DEBUG_CREATE, "created render finished semaphore");
 }
 
-void frameDestroySwapchainResources(RenderDevice device, Frame frame) {
-	vkDestroyImageView(device->device, frame.imageView, nullptr);
-	avLog(AV_DEBUG_DESTROY, "destroyed image view in frame");
+void swapchainImageDestroyResources(RenderDevice device, SwapchainImage swapchainImage) {
+	vkDestroyImageView(device->device, swapchainImage.imageView, vulkanAllocator);
+	avLog(AV_DEBUG_DESTROY, "destroyed swapchain image view");
 
-	vkDestroyFramebuffer(device->device, frame.framebuffer, nullptr);
-	avLog(AV_DEBUG_DESTROY, "destroyed framebuffer");
-}
+	if (swapchainImage.framebuffer != VK_NULL_HANDLE) {
+		vkDestroyFramebuffer(device->device, swapchainImage.framebuffer, vulkanAllocator);
+		avLog(AV_DEBUG_DESTROY, "destroyed framebuffer");
+	}
 
-void createSwapchain(RenderDevice device) {
+	vkDestroySemaphore(device->device, swapchainImage.renderFinished, vulkanAllocator);
+	avLog(AV_DEBUG_DESTROY, "destroyed render finished semaphore");
+}
 
-	uint imageCount = device->window->frameCount;
+// oldSwapchain lets the implementation reuse its resources, it is retired by the call
+void createSwapchain(RenderDevice device, VkSwapchainKHR oldSwapchain) {
+	Window window = device->window;
 
 	uint32 queueFamilyIndices[] = { device->queueFamilyIndices.graphicsFamily, device->queueFamilyIndices.presentFamily };
 
 	VkSwapchainCreateInfoKHR swapchainInfo = { 0 };
 	swapchainInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-	swapchainInfo.surface = device->window->surface;
-	swapchainInfo.minImageCount = imageCount;
-	swapchainInfo.imageFormat = device->window->frameFormat;
-	swapchainInfo.imageColorSpace = device->window->frameColorspace;
-	swapchainInfo.imageExtent = device->window->frameExtent;
+	swapchainInfo.surface = window->surface;
+	swapchainInfo.minImageCount = window->minImageCount;
+	swapchainInfo.imageFormat = window->frameFormat;
+	swapchainInfo.imageColorSpace = window->frameColorspace;
+	swapchainInfo.imageExtent = window->frameExtent;
 	swapchainInfo.imageArrayLayers = 1;
 	swapchainInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 	if (device->queueFamilyIndices.graphicsFamily != device->queueFamilyIndices.presentFamily) {
@@ -868,53 +1142,236 @@ void createSwapchain(RenderDevice device) {
 		swapchainInfo.queueFamilyIndexCount = 0;
 		swapchainInfo.pQueueFamilyIndices = nullptr;
 	}
-	swapchainInfo.preTransform = device->window->frameTransform;
+	swapchainInfo.preTransform = window->frameTransform;
 	swapchainInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-	swapchainInfo.presentMode = device->window->framePresentMode;
+	swapchainInfo.presentMode = window->framePresentMode;
 	swapchainInfo.clipped = VK_TRUE;
-	swapchainInfo.oldSwapchain = VK_NULL_HANDLE;
-	VkResult result = vkCreateSwapchainKHR(device->device, &swapchainInfo, nullptr, &device->window->swapchain);
+	swapchainInfo.oldSwapchain = oldSwapchain;
+	VkResult result = vkCreateSwapchainKHR(device->device, &swapchainInfo, vulkanAllocator, &window->swapchain);
 	if (result != VK_SUCCESS) {
 		avAssert(AV_CREATION_ERROR, 0, "creating swapchain");
 	}
 	avLog(AV_DEBUG_CREATE, "created swapchain");
 
-	vkGetSwapchainImagesKHR(device->device, device->window->swapchain, &imageCount, nullptr);
+	// the implementation may create more images than requested
+	uint imageCount = 0;
+	vkGetSwapchainImagesKHR(device->device, window->swapchain, &imageCount, nullptr);
 	VkImage* swapChainImages = avAllocate(sizeof(VkImage), imageCount, "allocating for swapchain image enumeration");
-	vkGetSwapchainImagesKHR(device->device, device->window->swapchain, &imageCount, swapChainImages);
+	vkGetSwapchainImagesKHR(device->device, window->swapchain, &imageCount, swapChainImages);
 
-	for (uint i = 0; i < device->window->frameCount; i++) {
-		frameCreateSwapchainResources(device, i, swapChainImages, &device->window->frames[i]);
+	window->imageCount = imageCount;
+	window->images = avAllocate(sizeof(SwapchainImage), imageCount, "allocating swapchain images");
+	for (uint i = 0; i < imageCount; i++) {
+		swapchainImageCreateResources(device, swapChainImages[i], &window->images[i]);
 	}
 
 	avFree(swapChainImages);
+}
 
+void destroyRetiredSwapchain(RenderDevice device, RetiredSwapchain* retired) {
+	// the frame fences don't cover the presents waiting on the render finished semaphores,
+	// destroying the swapchain first ends them before the semaphores are destroyed
+	vkDestroySwapchainKHR(device->device, retired->swapchain, vulkanAllocator);
+	avLog(AV_DEBUG_DESTROY, "destroyed retired swapchain");
+	for (uint i = 0; i < retired->imageCount; i++) {
+		swapchainImageDestroyResources(device, retired->images[i]);
+	}
+	avFree(retired->images);
+	avFree(retired);
+}
 
+// called once the fence of the frame was waited on
+void releaseRetiredSwapchains(RenderDevice device) {
+	RetiredSwapchain** link = &device->window->retiredSwapchains;
+	while (*link) {
+		RetiredSwapchain* retired = *link;
+		if (--retired->framesLeft == 0) {
+			*link = retired->next;
+			destroyRetiredSwapchain(device, retired);
+		} else {
+			link = &retired->next;
+		}
+	}
 }
 
+// only safe once the device is idle
 void cleanupSwapChain(RenderDevice device) {
-	for (uint i = 0; i < device->window->frameCount; i++) {
-		frameDestroySwapchainResources(device, device->window->frames[i]);
+	Window window = device->window;
+	while (window->retiredSwapchains) {
+		RetiredSwapchain* retired = window->retiredSwapchains;
+		window->retiredSwapchains = retired->next;
+		destroyRetiredSwapchain(device, retired);
+	}
+
+	for (uint i = 0; i < window->imageCount; i++) {
+		swapchainImageDestroyResources(device, window->images[i]);
 	}
+	avFree(window->images);
+	window->images = nullptr;
+	window->imageCount = 0;
 
-	vkDestroySwapchainKHR(device->device, device->window->swapchain, nullptr);
+	vkDestroySwapchainKHR(device->device, window->swapchain, vulkanAllocator);
+	window->swapchain = VK_NULL_HANDLE;
 }
 
+// replaces the swapchain without waiting for the frames in flight, the old one is retired until they are done
 void recreateSwapchain(RenderDevice device) {
-	avLog(AV_SWAPCHAIN_RECREATION, "recreating swapchain");
+	Window window = device->window;
 
-	vkDeviceWaitIdle(device->device);
-	cleanupSwapChain(device);
-	createSwapchain(device);
+	// the extent changes with the window, the transform when the display is rotated
+	VkSurfaceCapabilitiesKHR capabilities;
+	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device->physicalDevice, window->surface, &capabilities);
+	VkExtent2D extent = chooseSwapExtent(capabilities, window);
+	if (extent.width == 0 || extent.height == 0) {
+		// minimized, recreated once the window has a size again
+		return;
+	}
+	avLogf(AV_SWAPCHAIN_RECREATION, "recreating swapchain with %ux%u", extent.width, extent.height);
+	window->frameExtent = extent;
+	window->frameTransform = capabilities.currentTransform;
+
+	RetiredSwapchain* retired = avAllocate(sizeof(RetiredSwapchain), 1, "retiring swapchain");
+	retired->swapchain = window->swapchain;
+	retired->imageCount = window->imageCount;
+	retired->images = window->images;
+	retired->framesLeft = MAX_FRAMES_IN_FLIGHT;
+	retired->next = window->retiredSwapchains;
+	window->retiredSwapchains = retired;
+	window->images = nullptr;
+	window->imageCount = 0;
+
+	createSwapchain(device, retired->swapchain);
+	window->status &= ~DEVICE_STATUS_RESIZED;
+}
 
+void frameRingCreate(RenderDevice device, uint64 partitionSize, FrameRing* ring) {
+	// partitions start at offsets that are valid for every kind of data and for flushing
+	uint64 alignment = device->nonCoherentAtomSize > 256 ? device->nonCoherentAtomSize : 256;
+	partitionSize = (partitionSize + alignment - 1) & ~(alignment - 1);
+
+	VkBufferCreateInfo bufferInfo = { 0 };
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = partitionSize * MAX_FRAMES_IN_FLIGHT;
+	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	// dynamic memory is device local and host visible where possible, which is the case on unified
+	// memory devices, so nothing is ever staged. Otherwise the gpu reads the data over the bus.
+	// the memory stays mapped for the lifetime of the ring
+	GpuAllocationCreateInfo allocationInfo = { 0 };
+	allocationInfo.usage = GPU_MEMORY_USAGE_DYNAMIC;
+	if (gpuCreateBuffer(device->memoryAllocator, &bufferInfo, &allocationInfo, &ring->buffer, &ring->allocation) != AV_SUCCESS) {
+		avAssert(AV_CREATION_ERROR, AV_SUCCESS, "creating frame ring buffer");
+	}
+	ring->data = ring->allocation.data;
+	ring->partitionSize = partitionSize;
+	ring->partitionOffset = 0;
+	ring->used = 0;
+	ring->highWaterMark = 0;
+	avLogf(AV_DEBUG_CREATE, "created frame ring buffer with %llu bytes per frame", (unsigned long long)partitionSize);
 }
 
-void frameCreateResources(RenderDevice device, Window window, uint frameIndex, Frame* frame) {
+void frameRingDestroy(RenderDevice device, FrameRing* ring) {
+	gpuDestroyBuffer(device->memoryAllocator, ring->buffer, &ring->allocation);
+	ring->buffer = VK_NULL_HANDLE;
+	ring->data = nullptr;
+	avLog(AV_DEBUG_DESTROY, "destroyed frame ring buffer");
+}
 
-	frame->extent = &window->frameExtent;
-	frame->format = &window->frameFormat;
-	frame->commandPool = &device->commandPool;
-	frame->pCommandBuffer = &window->commandBuffers[frameIndex];
+// called once the fence of the frame was waited on, its partition is no longer read by the gpu
+void frameRingBeginFrame(RenderDevice device, uint frameIndex) {
+	FrameRing* ring = &device->frameRing;
+	ring->partitionOffset = ring->partitionSize * frameIndex;
+	ring->used = 0;
+
+	RetiredFrameRing** link = &device->retiredFrameRings;
+	while (*link) {
+		RetiredFrameRing* retired = *link;
+		if (--retired->framesLeft == 0) {
+			*link = retired->next;
+			frameRingDestroy(device, &retired->ring);
+			avFree(retired);
+		} else {
+			link = &retired->next;
+		}
+	}
+}
+
+// replaces the ring by one with partitions of at least minPartitionSize, allocations made earlier in the frame stay valid
+void frameRingGrow(RenderDevice device, uint64 minPartitionSize) {
+	FrameRing* ring = &device->frameRing;
+	// frameRingFlush only sees the new ring, the allocations made so far are flushed here
+	gpuFlush(device->memoryAllocator, &ring->allocation, ring->partitionOffset, ring->used);
+
+	RetiredFrameRing* retired = avAllocate(sizeof(RetiredFrameRing), 1, "retiring frame ring buffer");
+	retired->ring = *ring;
+	retired->framesLeft = MAX_FRAMES_IN_FLIGHT;
+	retired->next = device->retiredFrameRings;
+	device->retiredFrameRings = retired;
+
+	uint64 partitionSize = ring->partitionSize * 2;
+	while (partitionSize < minPartitionSize) {
+		partitionSize *= 2;
+	}
+	uint frameIndex = (uint)(ring->partitionOffset / ring->partitionSize);
+	uint64 highWaterMark = ring->highWaterMark;
+	avLogf(AV_OUT_OF_BOUNDS, "frame ring buffer partition of %llu bytes exceeded, growing", (unsigned long long)ring->partitionSize);
+
+	frameRingCreate(device, partitionSize, ring);
+	ring->partitionOffset = ring->partitionSize * frameIndex;
+	ring->highWaterMark = highWaterMark;
+}
+
+// returns memory that stays valid until the frame has finished rendering, alignment has to be a power of two.
+// the memory has to be written before the next allocation, which may replace the ring and flush it
+FrameRingAllocation frameRingAllocate(RenderDevice device, uint64 size, uint64 alignment) {
+	FrameRing* ring = &device->frameRing;
+	uint64 offset = (ring->used + alignment - 1) & ~(alignment - 1);
+	if (offset + size > ring->partitionSize) {
+		frameRingGrow(device, size + alignment);
+		offset = 0;
+	}
+	ring->used = offset + size;
+	if (ring->used > ring->highWaterMark) {
+		ring->highWaterMark = ring->used;
+	}
+
+	FrameRingAllocation allocation;
+	allocation.buffer = ring->buffer;
+	allocation.offset = ring->partitionOffset + offset;
+	allocation.data = ring->data + allocation.offset;
+	return allocation;
+}
+
+// makes the writes of the frame visible to the gpu, nothing to do with coherent memory
+void frameRingFlush(RenderDevice device) {
+	FrameRing* ring = &device->frameRing;
+	gpuFlush(device->memoryAllocator, &ring->allocation, ring->partitionOffset, ring->used);
+}
+
+void frameCreateResources(RenderDevice device, Frame* frame) {
+
+	// one pool per frame, so all of its commands are released with a single reset
+	VkCommandPoolCreateInfo poolInfo = { 0 };
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	poolInfo.queueFamilyIndex = device->queueFamilyIndices.graphicsFamily;
+	checkCreation(
+		vkCreateCommandPool(device->device, &poolInfo, vulkanAllocator, &frame->commandPool),
+		"creating frame command pool"
+	);
+	avLog(AV_DEBUG_CREATE, "created frame command pool");
+
+	VkCommandBufferAllocateInfo allocInfo = { 0 };
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.commandPool = frame->commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	checkCreation(
+		vkAllocateCommandBuffers(device->device, &allocInfo, &frame->commandBuffer),
+		"allocating frame command buffer"
+	);
+	avLog(AV_DEBUG_CREATE, "allocated frame command buffer");
 
 	VkSemaphoreCreateInfo semaphoreCreateInfo = { 0 };
 	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -922,40 +1379,34 @@ void frameCreateResources(RenderDevice device, Window window, uint frameIndex, F
 	semaphoreCreateInfo.pNext = nullptr;
 
 	checkCreation(
-		vkCreateSemaphore(device->device, &semaphoreCreateInfo, nullptr, &frame->imageAvailable),
+		vkCreateSemaphore(device->device, &semaphoreCreateInfo, vulkanAllocator, &frame->imageAvailable),
 		"creating image available semaphore"
 	);
 	avLog(AV_DEBUG_CREATE, "created image available semaphore");
 
-	checkCreation(
-		vkCreateSemaphore(device->device, &semaphoreCreateInfo, nullptr, &frame->renderFinished),
-		"creating render finished semaphore"
-	);
-	avLog(AV_DEBUG_CREATE, "created render finished semaphore");
-
 	VkFenceCreateInfo fenceCreateInfo = { 0 };
 	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 	fenceCreateInfo.pNext = nullptr;
 
 	checkCreation(
-		vkCreateFence(device->device, &fenceCreateInfo, nullptr, &frame->inFlight),
+		vkCreateFence(device->device, &fenceCreateInfo, vulkanAllocator, &frame->inFlight),
 		"creating in flight fence"
 	);
 	avLog(AV_DEBUG_CREATE, "created in flight fence");
 }
 
-void frameDestroyResources(RenderDevice device, Window window, Frame frame) {
+void frameDestroyResources(RenderDevice device, Frame frame) {
 
-	vkDestroySemaphore(device->device, frame.imageAvailable, nullptr);
+	vkDestroySemaphore(device->device, frame.imageAvailable, vulkanAllocator);
 	avLog(AV_DEBUG_DESTROY, "destroyed image available semaphore");
 
-	vkDestroySemaphore(device->device, frame.renderFinished, nullptr);
-	avLog(AV_DEBUG_DESTROY, "destroyed render finished semaphore");
-
-	vkDestroyFence(device->device, frame.inFlight, nullptr);
+	vkDestroyFence(device->device, frame.inFlight, vulkanAllocator);
 	avLog(AV_DEBUG_DESTROY, "destroyed in flight fence");
 
+	// also frees the command buffer
+	vkDestroyCommandPool(device->device, frame.commandPool, vulkanAllocator);
+	avLog(AV_DEBUG_DESTROY, "destroyed frame command pool");
 }
 
 
@@ -978,78 +1429,66 @@ void renderDeviceCreateRenderResources(RenderDevice device) {
 	window->frameFormat = surfaceFormat.format;
 	window->frameColorspace = surfaceFormat.colorSpace;
 	window->frameTransform = swapChainSupport.capabilities.currentTransform;
-	window->frameCount = imageCount;
-	window->frames = avAllocate(sizeof(Frame), window->frameCount, "allocating frame data");
-
-	VkCommandPoolCreateInfo poolInfo = { 0 };
-	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	poolInfo.queueFamilyIndex = device->queueFamilyIndices.graphicsFamily;
-	if (vkCreateCommandPool(device->device, &poolInfo, nullptr, &device->commandPool) != VK_SUCCESS) {
-		avAssert(AV_CREATION_ERROR, 0, "failed to create command pool");
-	}
-	avLog(AV_DEBUG_CREATE, "created command pool");
-
-	VkCommandBufferAllocateInfo allocInfo = { 0 };
-	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	allocInfo.commandPool = device->commandPool;
-	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandBufferCount = imageCount;
-	window->commandBuffers = avAllocate(sizeof(VkCommandBuffer), imageCount, "allocating command buffers");
-	if (vkAllocateCommandBuffers(device->device, &allocInfo, window->commandBuffers) != VK_SUCCESS) {
-		avAssert(AV_CREATION_ERROR, 0, "failed to allocate commandbuffers");
+	window->framePresentMode = presentMode;
+	window->minImageCount = imageCount;
+
+	// the render pass is only needed without dynamic rendering, which describes the attachments when recording
+	window->renderPass = VK_NULL_HANDLE;
+	if (!device->dynamicRendering) {
+		VkAttachmentDescription colorAttachmentDescription = { 0 };
+		colorAttachmentDescription.format = window->frameFormat;
+		colorAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		colorAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		colorAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		colorAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+		VkAttachmentReference colorAttachmentReference = { 0 };
+		colorAttachmentReference.attachment = 0;
+		colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass = { 0 };
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorAttachmentReference;
+
+		VkSubpassDependency dependency = { 0 };
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.srcAccessMask = 0;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo = { 0 };
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.pNext = nullptr;
+		renderPassInfo.flags = 0;
+		renderPassInfo.attachmentCount = 1;
+		renderPassInfo.pAttachments = &colorAttachmentDescription;
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = 1;
+		renderPassInfo.pDependencies = &dependency;
+
+		if (vkCreateRenderPass(device->device, &renderPassInfo, vulkanAllocator, &(window->renderPass)) != VK_SUCCESS) {
+			avAssert(AV_CREATION_ERROR, AV_SUCCESS, "creating renderpass");
+		}
+		avLog(AV_DEBUG_CREATE, "created renderpass");
 	}
-	avLog(AV_DEBUG_CREATE, "allocated command commandbuffers");
 
-	// renderpass 
-	VkAttachmentDescription colorAttachmentDescription = { 0 };
-	colorAttachmentDescription.format = window->frameFormat;
-	colorAttachmentDescription.samples = VK_SAMPLE_COUNT_1_BIT;
-	colorAttachmentDescription.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	colorAttachmentDescription.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	colorAttachmentDescription.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	colorAttachmentDescription.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachmentDescription.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentDescription.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-	VkAttachmentReference colorAttachmentReference = { 0 };
-	colorAttachmentReference.attachment = 0;
-	colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkSubpassDescription subpass = { 0 };
-	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpass.colorAttachmentCount = 1;
-	subpass.pColorAttachments = &colorAttachmentReference;
-
-	VkSubpassDependency dependency = { 0 };
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.srcAccessMask = 0;
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	VkRenderPassCreateInfo renderPassInfo = { 0 };
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	renderPassInfo.pNext = nullptr;
-	renderPassInfo.flags = 0;
-	renderPassInfo.attachmentCount = 1;
-	renderPassInfo.pAttachments = &colorAttachmentDescription;
-	renderPassInfo.subpassCount = 1;
-	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &dependency;
-
-	if (vkCreateRenderPass(device->device, &renderPassInfo, nullptr, &(window->renderPass)) != VK_SUCCESS) {
-		avAssert(AV_CREATION_ERROR, AV_SUCCESS, "creating renderpass");
+	for (uint i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		frameCreateResources(device, &window->frames[i]);
 	}
-	avLog(AV_DEBUG_CREATE, "created renderpass");
+	window->frameIndex = 0;
 
-	for (uint i = 0; i < device->window->frameCount; i++) {
-		frameCreateResources(device, device->window, i, &device->window->frames[i]);
-	}
+	frameRingCreate(device, FRAME_RING_PARTITION_SIZE_DEFAULT, &device->frameRing);
+	device->retiredFrameRings = nullptr;
 
-	createSwapchain(device);
+	window->retiredSwapchains = nullptr;
+	createSwapchain(device, VK_NULL_HANDLE);
 
 }
 
@@ -1063,7 +1502,7 @@ VkShaderModule createShaderModule(const size_t codeSize, const char* codeText, R
 
 	VkShaderModule shaderModule;
 
-	if (vkCreateShaderModule(device->device, &shaderModuleCreateInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+	if (vkCreateShaderModule(device->device, &shaderModuleCreateInfo, vulkanAllocator, &shaderModule) != VK_SUCCESS) {
 		avAssert(AV_CREATION_ERROR, AV_SUCCESS, msg);
 	}
 	avLog(AV_DEBUG_CREATE, "created shader module");
@@ -1077,12 +1516,18 @@ void renderDeviceCreatePipelines(RenderDevice device, uint createInfoCount, Pipe
 	Window window = device->window;
 
 
+	// the viewport size in pixels, rectangles are positioned in pixels
+	VkPushConstantRange renderPushConstantRange = { 0 };
+	renderPushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	renderPushConstantRange.offset = 0;
+	renderPushConstantRange.size = sizeof(float) * 2;
+
 	VkPipelineLayoutCreateInfo renderPipelineLayoutCreateInfo = { 0 };
 	renderPipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	renderPipelineLayoutCreateInfo.setLayoutCount = 0; // Optional
 	renderPipelineLayoutCreateInfo.pSetLayouts = nullptr; // Optional
-	renderPipelineLayoutCreateInfo.pushConstantRangeCount = 0; // Optional
-	renderPipelineLayoutCreateInfo.pPushConstantRanges = nullptr; // Optional
+	renderPipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+	renderPipelineLayoutCreateInfo.pPushConstantRanges = &renderPushConstantRange;
 
 	VkPipelineLayoutCreateInfo fontPipelineLayoutCreateInfo = { 0 };
 	fontPipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -1092,17 +1537,44 @@ void renderDeviceCreatePipelines(RenderDevice device, uint createInfoCount, Pipe
 	fontPipelineLayoutCreateInfo.pPushConstantRanges = nullptr; // Optional
 
 	checkCreation(
-		vkCreatePipelineLayout(device->device, &renderPipelineLayoutCreateInfo, nullptr, &device->renderPipeline.layout),
+		vkCreatePipelineLayout(device->device, &renderPipelineLayoutCreateInfo, vulkanAllocator, &device->renderPipeline.layout),
 		"creating render pipeline layout"
 	);
 	avLog(AV_DEBUG_CREATE, "created render pipeline layout");
 
 	checkCreation(
-		vkCreatePipelineLayout(device->device, &fontPipelineLayoutCreateInfo, nullptr, &device->fontPipeline.layout),
+		vkCreatePipelineLayout(device->device, &fontPipelineLayoutCreateInfo, vulkanAllocator, &device->fontPipeline.layout),
 		"creating font pipeline layout"
 	);
 	avLog(AV_DEBUG_CREATE, "created font pipeline layout");
 
+	// rectangles are read per instance straight from the queued AvRect array, the corners come from the vertex index
+	VkVertexInputBindingDescription rectBinding = { 0 };
+	rectBinding.binding = 0;
+	rectBinding.stride = sizeof(AvRect);
+	rectBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	VkVertexInputAttributeDescription rectAttributes[3] = { 0 };
+	rectAttributes[0].location = 0;
+	rectAttributes[0].binding = 0;
+	rectAttributes[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	rectAttributes[0].offset = offsetof(AvRect, x);
+	rectAttributes[1].location = 1;
+	rectAttributes[1].binding = 0;
+	rectAttributes[1].format = VK_FORMAT_R8G8B8A8_UNORM;
+	rectAttributes[1].offset = offsetof(AvRect, color);
+	rectAttributes[2].location = 2;
+	rectAttributes[2].binding = 0;
+	rectAttributes[2].format = VK_FORMAT_R32_SFLOAT;
+	rectAttributes[2].offset = offsetof(AvRect, cornerRadius);
+
+	VkPipelineVertexInputStateCreateInfo rectVertexInputInfo = { 0 };
+	rectVertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+	rectVertexInputInfo.vertexBindingDescriptionCount = 1;
+	rectVertexInputInfo.pVertexBindingDescriptions = &rectBinding;
+	rectVertexInputInfo.vertexAttributeDescriptionCount = sizeof(rectAttributes) / sizeof(VkVertexInputAttributeDescription);
+	rectVertexInputInfo.pVertexAttributeDescriptions = rectAttributes;
+
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo = { 0 };
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputInfo.vertexBindingDescriptionCount = 0;
@@ -1110,6 +1582,11 @@ void renderDeviceCreatePipelines(RenderDevice device, uint createInfoCount, Pipe
 	vertexInputInfo.vertexAttributeDescriptionCount = 0;
 	vertexInputInfo.pVertexAttributeDescriptions = nullptr; // Optional
 
+	VkPipelineInputAssemblyStateCreateInfo rectInputAssembly = { 0 };
+	rectInputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+	rectInputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+	rectInputAssembly.primitiveRestartEnable = VK_FALSE;
+
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly = { 0 };
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -1225,8 +1702,8 @@ void renderDeviceCreatePipelines(RenderDevice device, uint createInfoCount, Pipe
 	renderPipelineInfo.stageCount = sizeof(renderShaderStages) / sizeof(VkPipelineShaderStageCreateInfo);
 	renderPipelineInfo.pStages = renderShaderStages;
 
-	renderPipelineInfo.pVertexInputState = &vertexInputInfo;
-	renderPipelineInfo.pInputAssemblyState = &inputAssembly;
+	renderPipelineInfo.pVertexInputState = &rectVertexInputInfo;
+	renderPipelineInfo.pInputAssemblyState = &rectInputAssembly;
 	renderPipelineInfo.pViewportState = &viewportState;
 	renderPipelineInfo.pRasterizationState = &rasterizer;
 	renderPipelineInfo.pMultisampleState = &multisampling;
@@ -1264,25 +1741,37 @@ void renderDeviceCreatePipelines(RenderDevice device, uint createInfoCount, Pipe
 	fontPipelineInfo.basePipelineIndex = 0;
 	fontPipelineInfo.flags = VK_PIPELINE_CREATE_DERIVATIVE_BIT;
 
+	// with dynamic rendering the pipelines name the attachment formats instead of a render pass
+	VkPipelineRenderingCreateInfo pipelineRenderingInfo = { 0 };
+	pipelineRenderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	pipelineRenderingInfo.colorAttachmentCount = 1;
+	pipelineRenderingInfo.pColorAttachmentFormats = &window->frameFormat;
+	if (device->dynamicRendering) {
+		renderPipelineInfo.pNext = &pipelineRenderingInfo;
+		fontPipelineInfo.pNext = &pipelineRenderingInfo;
+	}
+
 	VkPipeline pipelines[] = { VK_NULL_HANDLE, VK_NULL_HANDLE };
 	VkGraphicsPipelineCreateInfo pipelineCreateInfos[] = { renderPipelineInfo, fontPipelineInfo };
 	uint pipelineCreateInfoCount = sizeof(pipelineCreateInfos) / sizeof(VkGraphicsPipelineCreateInfo);
 
 
+	uint64 pipelineStart = getLogTimestamp();
 	checkCreation(
-		vkCreateGraphicsPipelines(device->device, VK_NULL_HANDLE, pipelineCreateInfoCount, pipelineCreateInfos, nullptr, pipelines),
+		vkCreateGraphicsPipelines(device->device, device->pipelineCache.cache, pipelineCreateInfoCount, pipelineCreateInfos, vulkanAllocator, pipelines),
 		"creating render pipelines"
 	);
 	avLog(AV_DEBUG_CREATE, "created pipelines");
+	avLogf(AV_TIME, "compiled %u pipelines in %.2fms with %s pipeline cache", pipelineCreateInfoCount, (double)(getLogTimestamp() - pipelineStart) / 1000.0, device->pipelineCache.loaded ? "a loaded" : "an empty");
 
 	device->renderPipeline.pipeline = pipelines[0];
 	device->fontPipeline.pipeline = pipelines[1];
 
 
-	vkDestroyShaderModule(device->device, basicShaderVertModule, nullptr);
-	vkDestroyShaderModule(device->device, basicShaderFragModule, nullptr);
-	vkDestroyShaderModule(device->device, fontShaderVertModule, nullptr);
-	vkDestroyShaderModule(device->device, fontShaderFragModule, nullptr);
+	vkDestroyShaderModule(device->device, basicShaderVertModule, vulkanAllocator);
+	vkDestroyShaderModule(device->device, basicShaderFragModule, vulkanAllocator);
+	vkDestroyShaderModule(device->device, fontShaderVertModule, vulkanAllocator);
+	vkDestroyShaderModule(device->device, fontShaderFragModule, vulkanAllocator);
 }
 
 void renderDeviceWaitIdle(RenderDevice device) {
@@ -1290,65 +1779,185 @@ void renderDeviceWaitIdle(RenderDevice device) {
 }
 
 AvResult renderDeviceAquireNextFrame(RenderDevice device) {
-	uint frameIndex = device->window->frameIndex;
-	vkWaitForFences(device->device, 1, &device->window->frames[frameIndex].inFlight, VK_TRUE, UINT64_MAX);
+	Window window = device->window;
+	Frame* frame = &window->frames[window->frameIndex];
+
+	// only waits for the frame that used this context MAX_FRAMES_IN_FLIGHT frames ago
+	vkWaitForFences(device->device, 1, &frame->inFlight, VK_TRUE, UINT64_MAX);
 
 	VkResult result = vkAcquireNextImageKHR(
 		device->device,
-		device->window->swapchain,
+		window->swapchain,
 		UINT64_MAX,
-		device->window->frames[frameIndex].imageAvailable,
+		frame->imageAvailable,
 		VK_NULL_HANDLE,
-		&device->window->nextFrameIndex
+		&window->imageIndex
 	);
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+		// nothing was acquired, so the frame is skipped and its fence stays signaled
 		recreateSwapchain(device);
-		return AV_SUCCESS;
+		return AV_SWAPCHAIN_RECREATION;
 	} else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
 		avAssert(AV_SWAPCHAIN_ERROR, AV_SUCCESS, "failed to aquire swapchain image");
 	}
 
-	vkResetFences(device->device, 1, &device->window->frames[frameIndex].inFlight);
+	// the image can still be in use by an older frame when images are acquired out of order
+	SwapchainImage* image = &window->images[window->imageIndex];
+	if (image->inFlight != VK_NULL_HANDLE && image->inFlight != frame->inFlight) {
+		vkWaitForFences(device->device, 1, &image->inFlight, VK_TRUE, UINT64_MAX);
+	}
+	image->inFlight = frame->inFlight;
+
+	vkResetFences(device->device, 1, &frame->inFlight);
+	vkResetCommandPool(device->device, frame->commandPool, 0);
+	// begins only for frames that are submitted, so every call follows the wait of another frame's fence
+	frameRingBeginFrame(device, window->frameIndex);
+	releaseRetiredSwapchains(device);
 
 	return AV_SUCCESS;
 }
 
-AvResult renderDeviceRecordRenderCommands(RenderDevice device, RenderCommandsInfo commands) {
-	uint imageIndex = device->window->frameIndex;
-	VkCommandBuffer commandBuffer = *(device->window->frames[imageIndex].pCommandBuffer);
+// clip rectangles are applied as scissors, clamped to the frame
+VkRect2D getClipScissor(VkExtent2D extent, const RenderCommandsInfo* commands, uint clipIndex) {
+	VkRect2D scissor = { 0 };
+	scissor.extent = extent;
+	if (clipIndex == 0 || clipIndex > commands->clipRectCount) {
+		return scissor;
+	}
+	const AvClipRect* clip = &commands->clipRects[clipIndex - 1];
+	long long left = clamp((long long)clip->x, 0, (long long)extent.width);
+	long long top = clamp((long long)clip->y, 0, (long long)extent.height);
+	long long right = clamp((long long)clip->x + clip->width, left, (long long)extent.width);
+	long long bottom = clamp((long long)clip->y + clip->height, top, (long long)extent.height);
+	scissor.offset.x = (int)left;
+	scissor.offset.y = (int)top;
+	scissor.extent.width = (uint)(right - left);
+	scissor.extent.height = (uint)(bottom - top);
+	return scissor;
+}
 
-	vkResetCommandBuffer(commandBuffer, 0);
+void recordRects(RenderDevice device, VkCommandBuffer commandBuffer, const RenderCommandsInfo* commands) {
+	Window window = device->window;
+
+	uint64 size = sizeof(AvRect) * (uint64)commands->rectCount;
+	FrameRingAllocation instances = frameRingAllocate(device, size, sizeof(float));
+	memcpy(instances.data, commands->rects, size);
+
+	float viewportSize[2] = { (float)window->frameExtent.width, (float)window->frameExtent.height };
+	vkCmdPushConstants(commandBuffer, device->renderPipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(viewportSize), viewportSize);
+
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &instances.buffer, &instances.offset);
+
+	// one instanced draw per run of rectangles with the same clip rectangle, the draw order is kept
+	uint first = 0;
+	while (first < commands->rectCount) {
+		uint clipIndex = commands->rects[first].clipIndex;
+		uint end = first + 1;
+		while (end < commands->rectCount && commands->rects[end].clipIndex == clipIndex) {
+			end++;
+		}
+		VkRect2D scissor = getClipScissor(window->frameExtent, commands, clipIndex);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		vkCmdDraw(commandBuffer, 4, end - first, 0, first);
+		first = end;
+	}
+}
+
+// transitions the swapchain image to an attachment, what the render pass and its subpass dependency do otherwise
+void beginDynamicRendering(RenderDevice device, VkCommandBuffer commandBuffer, VkClearValue clearColor) {
+	Window window = device->window;
+	SwapchainImage* image = &window->images[window->imageIndex];
+
+	VkImageMemoryBarrier barrier = { 0 };
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image->image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 1;
+	// the color attachment stage is where the submission waits for the image to be acquired
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	VkRenderingAttachmentInfo colorAttachment = { 0 };
+	colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	colorAttachment.imageView = image->imageView;
+	colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.clearValue = clearColor;
+
+	VkRenderingInfo renderingInfo = { 0 };
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderingInfo.renderArea.extent = window->frameExtent;
+	renderingInfo.layerCount = 1;
+	renderingInfo.colorAttachmentCount = 1;
+	renderingInfo.pColorAttachments = &colorAttachment;
+	device->cmdBeginRendering(commandBuffer, &renderingInfo);
+}
+
+// transitions the swapchain image for presentation
+void endDynamicRendering(RenderDevice device, VkCommandBuffer commandBuffer) {
+	Window window = device->window;
+	device->cmdEndRendering(commandBuffer);
+
+	VkImageMemoryBarrier barrier = { 0 };
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = window->images[window->imageIndex].image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+AvResult renderDeviceRecordRenderCommands(RenderDevice device, RenderCommandsInfo commands) {
+	Window window = device->window;
+	Frame* frame = &window->frames[window->frameIndex];
+	VkCommandBuffer commandBuffer = frame->commandBuffer;
 
 	VkCommandBufferBeginInfo beginInfo = { 0 };
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	beginInfo.flags = 0; // Optional
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 	beginInfo.pInheritanceInfo = nullptr; // Optional
 
 	if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
 		avAssert(AV_RENDER_COMMAND_ERROR, AV_SUCCESS, "command recording begin failed");
 	}
 
-	VkRenderPassBeginInfo renderPassInfo = { 0 };
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = device->window->renderPass;
-	renderPassInfo.framebuffer = device->window->frames[device->window->nextFrameIndex].framebuffer;
-	renderPassInfo.renderArea.offset.x = 0;
-	renderPassInfo.renderArea.offset.y = 0;
-	renderPassInfo.renderArea.extent = device->window->frameExtent;
-
 	VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
-	renderPassInfo.clearValueCount = 1;
-	renderPassInfo.pClearValues = &clearColor;
-
-	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	if (device->dynamicRendering) {
+		beginDynamicRendering(device, commandBuffer, clearColor);
+	} else {
+		VkRenderPassBeginInfo renderPassInfo = { 0 };
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = window->renderPass;
+		renderPassInfo.framebuffer = window->images[window->imageIndex].framebuffer;
+		renderPassInfo.renderArea.offset.x = 0;
+		renderPassInfo.renderArea.offset.y = 0;
+		renderPassInfo.renderArea.extent = window->frameExtent;
+		renderPassInfo.clearValueCount = 1;
+		renderPassInfo.pClearValues = &clearColor;
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
 	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, device->renderPipeline.pipeline);
 
 	VkViewport viewport = { 0 };
 	viewport.x = 0.0f;
 	viewport.y = 0.0f;
-	viewport.width = device->window->frameExtent.width;
-	viewport.height = device->window->frameExtent.height;
+	viewport.width = window->frameExtent.width;
+	viewport.height = window->frameExtent.height;
 	viewport.minDepth = 0.0f;
 	viewport.maxDepth = 1.0f;
 	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
@@ -1356,12 +1965,18 @@ AvResult renderDeviceRecordRenderCommands(RenderDevice device, RenderCommandsInf
 	VkRect2D scissor = { 0 };
 	scissor.offset.x = 0;
 	scissor.offset.y = 0;
-	scissor.extent = device->window->frameExtent;
+	scissor.extent = window->frameExtent;
 	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+	if (commands.rectCount) {
+		recordRects(device, commandBuffer, &commands);
+	}
 
-	vkCmdEndRenderPass(commandBuffer);
+	if (device->dynamicRendering) {
+		endDynamicRendering(device, commandBuffer);
+	} else {
+		vkCmdEndRenderPass(commandBuffer);
+	}
 
 	if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 		avAssert(AV_RENDER_COMMAND_ERROR, AV_SUCCESS, "failed command buffer recording");
@@ -1370,66 +1985,67 @@ AvResult renderDeviceRecordRenderCommands(RenderDevice device, RenderCommandsInf
 }
 
 AvResult renderDeviceRenderFrame(RenderDevice device) {
+	Window window = device->window;
+	Frame* frame = &window->frames[window->frameIndex];
 
-	uint imageIndex = device->window->frameIndex;
+	frameRingFlush(device);
 
 	VkSubmitInfo submitInfo = { 0 };
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-	VkSemaphore waitSemaphores[] = { device->window->frames[imageIndex].imageAvailable };
+	VkSemaphore waitSemaphores[] = { frame->imageAvailable };
 	VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
 	submitInfo.waitSemaphoreCount = 1;
 	submitInfo.pWaitSemaphores = waitSemaphores;
 	submitInfo.pWaitDstStageMask = waitStages;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = device->window->frames[imageIndex].pCommandBuffer;
+	submitInfo.pCommandBuffers = &frame->commandBuffer;
 
-	VkSemaphore signalSemaphores[] = { device->window->frames[imageIndex].renderFinished };
+	VkSemaphore signalSemaphores[] = { window->images[window->imageIndex].renderFinished };
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = signalSemaphores;
 
-	if (vkQueueSubmit(device->graphicsQueue, 1, &submitInfo, device->window->frames[imageIndex].inFlight) != VK_SUCCESS) {
+	if (vkQueueSubmit(device->graphicsQueue, 1, &submitInfo, frame->inFlight) != VK_SUCCESS) {
 		avAssert(AV_RENDER_ERROR, AV_SUCCESS, "failed render submission");
 	}
 	return AV_SUCCESS;
 }
 
 AvResult renderDevicePresent(RenderDevice device) {
-
-	uint imageIndex = device->window->frameIndex;
+	Window window = device->window;
 
 	VkPresentInfoKHR presentInfo = { 0 };
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
 	presentInfo.waitSemaphoreCount = 1;
-	VkSemaphore signalSemaphores[] = { device->window->frames[imageIndex].renderFinished };
+	VkSemaphore signalSemaphores[] = { window->images[window->imageIndex].renderFinished };
 	presentInfo.pWaitSemaphores = signalSemaphores;
 
-	VkSwapchainKHR swapChains[] = { device->window->swapchain };
+	VkSwapchainKHR swapChains[] = { window->swapchain };
 	presentInfo.swapchainCount = 1;
 	presentInfo.pSwapchains = swapChains;
 
-	presentInfo.pImageIndices = &device->window->nextFrameIndex;
+	presentInfo.pImageIndices = &window->imageIndex;
+
+	// the next frame records with the next context, while this one may still be rendering
+	window->frameIndex = (window->frameIndex + 1) % MAX_FRAMES_IN_FLIGHT;
 
 	VkResult result = vkQueuePresentKHR(device->presentQueue, &presentInfo);
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || device->window->status & DEVICE_STATUS_RESIZED) {
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window->status & DEVICE_STATUS_RESIZED) {
 		recreateSwapchain(device);
-		device->window->status &= ~DEVICE_STATUS_RESIZED;
 	} else if (result != VK_SUCCESS) {
 		avAssert(AV_PRESENT_ERROR, AV_SUCCESS, "failed to present");
 	}
 
-	device->window->frameIndex = device->window->nextFrameIndex;
-
 	return AV_SUCCESS;
 }
 
 void renderDeviceDestroyPipelines(RenderDevice device) {
 
-	vkDestroyPipeline(device->device, device->renderPipeline.pipeline, nullptr);
-	vkDestroyPipeline(device->device, device->fontPipeline.pipeline, nullptr);
-	vkDestroyPipelineLayout(device->device, device->renderPipeline.layout, nullptr);
-	vkDestroyPipelineLayout(device->device, device->fontPipeline.layout, nullptr);
+	vkDestroyPipeline(device->device, device->renderPipeline.pipeline, vulkanAllocator);
+	vkDestroyPipeline(device->device, device->fontPipeline.pipeline, vulkanAllocator);
+	vkDestroyPipelineLayout(device->device, device->renderPipeline.layout, vulkanAllocator);
+	vkDestroyPipelineLayout(device->device, device->fontPipeline.layout, vulkanAllocator);
 
 }
 
@@ -1438,25 +2054,36 @@ void renderDeviceDestroyRenderResources(RenderDevice device) {
 
 	cleanupSwapChain(device);
 
-	vkDestroyRenderPass(device->device, window->renderPass, nullptr);
-	avLog(AV_DEBUG_DESTROY, "destroyed renderpass");
-
-	for (uint i = 0; i < window->frameCount; i++) {
-		frameDestroyResources(device, window, window->frames[i]);
+	if (window->renderPass != VK_NULL_HANDLE) {
+		vkDestroyRenderPass(device->device, window->renderPass, vulkanAllocator);
+		avLog(AV_DEBUG_DESTROY, "destroyed renderpass");
 	}
 
-	vkDestroyCommandPool(device->device, device->commandPool, nullptr);
-	avLog(AV_DEBUG_DESTROY, "destoyed command pool");
-
-	avFree(window->frames);
-
+	for (uint i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		frameDestroyResources(device, window->frames[i]);
+	}
 
+	while (device->retiredFrameRings) {
+		RetiredFrameRing* retired = device->retiredFrameRings;
+		device->retiredFrameRings = retired->next;
+		frameRingDestroy(device, &retired->ring);
+		avFree(retired);
+	}
+	avLogf(AV_DEBUG_INFO, "frame ring buffer used at most %llu bytes in a frame", (unsigned long long)device->frameRing.highWaterMark);
+	frameRingDestroy(device, &device->frameRing);
 }
 
 void renderDeviceDestroy(RenderDevice device) {
 
+	gpuAllocatorLogStats(device->memoryAllocator);
+	gpuAllocatorDestroy(device->memoryAllocator);
+
+	VkPhysicalDeviceProperties deviceProperties;
+	vkGetPhysicalDeviceProperties(device->physicalDevice, &deviceProperties);
+	pipelineCacheSave(device->device, &deviceProperties, &device->pipelineCache);
+	pipelineCacheDestroy(device->device, vulkanAllocator, &device->pipelineCache);
 
-	vkDestroyDevice(device->device, nullptr);
+	vkDestroyDevice(device->device, vulkanAllocator);
 	avLog(AV_DEBUG_DESTROY, "destroyed render device");
 
 	avFree(device);
@@ -0,0 +1,793 @@
+#include "vulkanMemory.h"
+#include <string.h>
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_renderer"
+
+typedef struct GpuBlock {
+	VkDeviceMemory memory;
+	VkDeviceSize size;
+	// mapped for the lifetime of the block, nullptr when the memory is not host visible
+	byte* data;
+	struct GpuPool_T* pool;
+	struct GpuBlock* next;
+	uint32 allocationCount;
+	VkDeviceSize allocationBytes;
+
+	// buddy pools keep one bit per node that is free, order 0 holds the smallest nodes
+	uint32 orderCount;
+	uint64* freeBits;
+	uint64 orderWordOffsets[GPU_MEMORY_MAX_ORDER_COUNT];
+	uint64 freeCounts[GPU_MEMORY_MAX_ORDER_COUNT];
+	// no free node of an order lies before this word
+	uint64 firstFreeWords[GPU_MEMORY_MAX_ORDER_COUNT];
+
+	// linear pools
+	VkDeviceSize linearOffset;
+	GpuResourceKind lastKind;
+} GpuBlock;
+
+typedef struct GpuPool_T {
+	GpuPoolType type;
+	uint32 memoryType;
+	// size of every block of a custom pool, the largest block size of a default pool
+	VkDeviceSize blockSize;
+	bool custom;
+	uint32 blockCount;
+	GpuBlock* blocks;
+	// linear pools move on to the next block once this one is full
+	GpuBlock* currentBlock;
+	struct GpuPool_T* next;
+} GpuPool_T;
+
+typedef struct GpuHeap {
+	VkDeviceSize preferredBlockSize;
+	uint32 blockCount;
+	VkDeviceSize blockBytes;
+	uint32 allocationCount;
+	VkDeviceSize allocationBytes;
+	VkDeviceSize budget;
+	VkDeviceSize usage;
+} GpuHeap;
+
+typedef struct GpuAllocator_T {
+	VkPhysicalDevice physicalDevice;
+	VkDevice device;
+	const VkAllocationCallbacks* allocationCallbacks;
+	bool memoryBudgetEnabled;
+	bool vulkan11;
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	VkDeviceSize bufferImageGranularity;
+	VkDeviceSize nonCoherentAtomSize;
+	uint32 maxMemoryAllocationCount;
+	uint32 memoryObjectCount;
+	// buffers and optimal images only need separate pools when a buddy node can share a granularity page with another
+	bool separateKinds;
+
+	GpuHeap heaps[VK_MAX_MEMORY_HEAPS];
+	GpuPool_T defaultPools[VK_MAX_MEMORY_TYPES][GPU_RESOURCE_KIND_COUNT];
+	GpuPool customPools;
+} GpuAllocator_T;
+
+static inline VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static inline VkDeviceSize powerOfTwoCeil(VkDeviceSize value) {
+	return value <= 1 ? 1 : 1ull << (64 - __builtin_clzll(value - 1));
+}
+
+static inline VkDeviceSize powerOfTwoFloor(VkDeviceSize value) {
+	return value == 0 ? 0 : 1ull << (63 - __builtin_clzll(value));
+}
+
+static inline uint32 log2Exact(VkDeviceSize value) {
+	return (uint32)__builtin_ctzll(value);
+}
+
+static inline GpuHeap* getHeap(GpuAllocator allocator, uint32 memoryType) {
+	return &allocator->heaps[allocator->memoryProperties.memoryTypes[memoryType].heapIndex];
+}
+
+static inline bool isHostVisible(GpuAllocator allocator, uint32 memoryType) {
+	return (allocator->memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+static inline bool isCoherent(GpuAllocator allocator, uint32 memoryType) {
+	return (allocator->memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+static void getUsageFlags(GpuMemoryUsage usage, VkMemoryPropertyFlags* required, VkMemoryPropertyFlags* preferred, VkMemoryPropertyFlags* avoided) {
+	switch (usage) {
+	case GPU_MEMORY_USAGE_GPU_ONLY:
+		*required = 0;
+		*preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		*avoided = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		break;
+	case GPU_MEMORY_USAGE_UPLOAD:
+		// the small device local and host visible heap of discrete gpus is left to dynamic data
+		*required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		*preferred = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		*avoided = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		break;
+	case GPU_MEMORY_USAGE_DYNAMIC:
+		*required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		*preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		*avoided = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+		break;
+	case GPU_MEMORY_USAGE_READBACK:
+		*required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		*preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		*avoided = 0;
+		break;
+	}
+}
+
+// picks the type with the most preferred and the fewest avoided properties, lazily allocated memory is only meant for transient attachments
+static bool selectMemoryType(GpuAllocator allocator, uint32 typeBits, GpuMemoryUsage usage, uint32* typeIndex) {
+	VkMemoryPropertyFlags required, preferred, avoided;
+	getUsageFlags(usage, &required, &preferred, &avoided);
+
+	int bestScore = -1000;
+	bool found = false;
+	for (uint32 i = 0; i < allocator->memoryProperties.memoryTypeCount; i++) {
+		VkMemoryPropertyFlags flags = allocator->memoryProperties.memoryTypes[i].propertyFlags;
+		if (!(typeBits & (1u << i)) || (flags & required) != required || (flags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+			continue;
+		}
+		int score = __builtin_popcount(flags & preferred) - __builtin_popcount(flags & avoided);
+		if (score > bestScore) {
+			bestScore = score;
+			*typeIndex = i;
+			found = true;
+		}
+	}
+	return found;
+}
+
+static void updateBudget(GpuAllocator allocator) {
+	if (allocator->memoryBudgetEnabled) {
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = { 0 };
+		budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		VkPhysicalDeviceMemoryProperties2 properties = { 0 };
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		properties.pNext = &budget;
+		vkGetPhysicalDeviceMemoryProperties2(allocator->physicalDevice, &properties);
+		for (uint32 i = 0; i < allocator->memoryProperties.memoryHeapCount; i++) {
+			allocator->heaps[i].budget = budget.heapBudget[i];
+			allocator->heaps[i].usage = budget.heapUsage[i];
+		}
+		return;
+	}
+	for (uint32 i = 0; i < allocator->memoryProperties.memoryHeapCount; i++) {
+		allocator->heaps[i].budget = allocator->memoryProperties.memoryHeaps[i].size / 100 * GPU_MEMORY_ESTIMATED_BUDGET;
+		allocator->heaps[i].usage = allocator->heaps[i].blockBytes;
+	}
+}
+
+static bool isWithinBudget(GpuAllocator allocator, uint32 memoryType, VkDeviceSize size) {
+	updateBudget(allocator);
+	GpuHeap* heap = getHeap(allocator, memoryType);
+	return heap->usage + size <= heap->budget;
+}
+
+static VkResult allocateDeviceMemory(GpuAllocator allocator, uint32 memoryType, VkDeviceSize size, VkImage dedicatedImage, VkBuffer dedicatedBuffer, VkDeviceMemory* memory, void** data) {
+	if (allocator->memoryObjectCount >= allocator->maxMemoryAllocationCount) {
+		avLogf(AV_OUT_OF_BOUNDS, "reached the limit of %u device memory allocations", allocator->maxMemoryAllocationCount);
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+	}
+
+	VkMemoryAllocateInfo allocInfo = { 0 };
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = size;
+	allocInfo.memoryTypeIndex = memoryType;
+	VkMemoryDedicatedAllocateInfo dedicatedInfo = { 0 };
+	if (allocator->vulkan11 && (dedicatedImage || dedicatedBuffer)) {
+		// lets the driver place the resource the way it would for a resource of its own
+		dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+		dedicatedInfo.image = dedicatedImage;
+		dedicatedInfo.buffer = dedicatedBuffer;
+		allocInfo.pNext = &dedicatedInfo;
+	}
+	VkResult result = vkAllocateMemory(allocator->device, &allocInfo, allocator->allocationCallbacks, memory);
+	if (result != VK_SUCCESS) {
+		return result;
+	}
+
+	*data = nullptr;
+	if (isHostVisible(allocator, memoryType)) {
+		result = vkMapMemory(allocator->device, *memory, 0, VK_WHOLE_SIZE, 0, data);
+		if (result != VK_SUCCESS) {
+			vkFreeMemory(allocator->device, *memory, allocator->allocationCallbacks);
+			return result;
+		}
+	}
+
+	GpuHeap* heap = getHeap(allocator, memoryType);
+	heap->blockCount++;
+	heap->blockBytes += size;
+	allocator->memoryObjectCount++;
+	return VK_SUCCESS;
+}
+
+static void freeDeviceMemory(GpuAllocator allocator, uint32 memoryType, VkDeviceMemory memory, VkDeviceSize size) {
+	// freeing implicitly unmaps
+	vkFreeMemory(allocator->device, memory, allocator->allocationCallbacks);
+	GpuHeap* heap = getHeap(allocator, memoryType);
+	heap->blockCount--;
+	heap->blockBytes -= size;
+	allocator->memoryObjectCount--;
+}
+
+static inline uint64 getNodeCount(const GpuBlock* block, uint32 order) {
+	return 1ull << (block->orderCount - 1 - order);
+}
+
+static inline bool buddyIsFree(const GpuBlock* block, uint32 order, uint64 index) {
+	return (block->freeBits[block->orderWordOffsets[order] + (index >> 6)] >> (index & 63)) & 1;
+}
+
+static inline void buddySetFree(GpuBlock* block, uint32 order, uint64 index) {
+	block->freeBits[block->orderWordOffsets[order] + (index >> 6)] |= 1ull << (index & 63);
+	block->freeCounts[order]++;
+	if ((index >> 6) < block->firstFreeWords[order]) {
+		block->firstFreeWords[order] = index >> 6;
+	}
+}
+
+static inline void buddyClearFree(GpuBlock* block, uint32 order, uint64 index) {
+	block->freeBits[block->orderWordOffsets[order] + (index >> 6)] &= ~(1ull << (index & 63));
+	block->freeCounts[order]--;
+}
+
+// takes the lowest free node of the smallest order that has one and splits it down to order
+static bool buddyAllocate(GpuBlock* block, uint32 order, VkDeviceSize* offset) {
+	uint32 from = order;
+	while (from < block->orderCount && block->freeCounts[from] == 0) {
+		from++;
+	}
+	if (from == block->orderCount) {
+		return false;
+	}
+
+	const uint64* bits = block->freeBits + block->orderWordOffsets[from];
+	uint64 word = block->firstFreeWords[from];
+	while (bits[word] == 0) {
+		word++;
+	}
+	block->firstFreeWords[from] = word;
+	uint64 index = word * 64 + (uint64)__builtin_ctzll(bits[word]);
+	buddyClearFree(block, from, index);
+
+	while (from > order) {
+		from--;
+		index *= 2;
+		buddySetFree(block, from, index + 1);
+	}
+	*offset = index * ((VkDeviceSize)GPU_MEMORY_MIN_NODE_SIZE << order);
+	return true;
+}
+
+// merges the node with its buddy for as long as the buddy is free as well
+static void buddyFree(GpuBlock* block, uint32 order, VkDeviceSize offset) {
+	uint64 index = offset / ((VkDeviceSize)GPU_MEMORY_MIN_NODE_SIZE << order);
+	while (order + 1 < block->orderCount && buddyIsFree(block, order, index ^ 1)) {
+		buddyClearFree(block, order, index ^ 1);
+		index >>= 1;
+		order++;
+	}
+	buddySetFree(block, order, index);
+}
+
+static GpuBlock* blockCreate(GpuAllocator allocator, GpuPool pool, VkDeviceSize size) {
+	VkDeviceMemory memory;
+	void* data;
+	if (allocateDeviceMemory(allocator, pool->memoryType, size, VK_NULL_HANDLE, VK_NULL_HANDLE, &memory, &data) != VK_SUCCESS) {
+		return nullptr;
+	}
+
+	GpuBlock* block = avAllocate(sizeof(GpuBlock), 1, "allocating gpu memory block");
+	block->memory = memory;
+	block->size = size;
+	block->data = data;
+	block->pool = pool;
+
+	if (pool->type == GPU_POOL_TYPE_BUDDY) {
+		// buddy blocks are a power of two, every order gets its own words so they can be scanned a word at a time
+		block->orderCount = log2Exact(size / GPU_MEMORY_MIN_NODE_SIZE) + 1;
+		uint64 wordCount = 0;
+		for (uint32 order = 0; order < block->orderCount; order++) {
+			block->orderWordOffsets[order] = wordCount;
+			wordCount += (getNodeCount(block, order) + 63) / 64;
+		}
+		block->freeBits = avAllocate(sizeof(uint64), wordCount, "allocating gpu memory block free nodes");
+		buddySetFree(block, block->orderCount - 1, 0);
+	}
+
+	// appended, so the oldest blocks are filled first and newer ones can run empty and be released
+	GpuBlock** link = &pool->blocks;
+	while (*link) {
+		link = &(*link)->next;
+	}
+	*link = block;
+	pool->blockCount++;
+	avLogf(AV_DEBUG_CREATE, "allocated gpu memory block of %llu bytes in memory type %u", (unsigned long long)size, pool->memoryType);
+	return block;
+}
+
+static void blockDestroy(GpuAllocator allocator, GpuPool pool, GpuBlock* block) {
+	GpuBlock** link = &pool->blocks;
+	while (*link != block) {
+		link = &(*link)->next;
+	}
+	*link = block->next;
+	if (pool->currentBlock == block) {
+		pool->currentBlock = pool->blocks;
+	}
+	pool->blockCount--;
+
+	freeDeviceMemory(allocator, pool->memoryType, block->memory, block->size);
+	if (block->freeBits) {
+		avFree(block->freeBits);
+	}
+	avFree(block);
+}
+
+// one empty block is kept per pool, so allocating and freeing around a block boundary does not allocate device memory every time
+static void releaseEmptyBlock(GpuAllocator allocator, GpuPool pool, GpuBlock* block) {
+	for (GpuBlock* other = pool->blocks; other; other = other->next) {
+		if (other != block && other->allocationCount == 0) {
+			blockDestroy(allocator, pool, block);
+			return;
+		}
+	}
+}
+
+static void fillAllocation(GpuAllocator allocator, GpuBlock* block, VkDeviceSize offset, VkDeviceSize size, uint32 order, GpuAllocation* allocation) {
+	allocation->memory = block->memory;
+	allocation->offset = offset;
+	allocation->size = size;
+	allocation->data = block->data ? block->data + offset : nullptr;
+	allocation->memoryType = block->pool->memoryType;
+	allocation->coherent = isCoherent(allocator, block->pool->memoryType);
+	allocation->block = block;
+	allocation->order = order;
+	block->allocationCount++;
+	block->allocationBytes += size;
+}
+
+static bool buddyPoolAllocate(GpuAllocator allocator, GpuPool pool, VkDeviceSize size, VkDeviceSize alignment, uint32 flags, GpuAllocation* allocation) {
+	// nodes are aligned to their size, so a node that fits size and alignment satisfies both
+	VkDeviceSize nodeSize = powerOfTwoCeil(size > alignment ? size : alignment);
+	if (nodeSize < GPU_MEMORY_MIN_NODE_SIZE) {
+		nodeSize = GPU_MEMORY_MIN_NODE_SIZE;
+	}
+	uint32 order = log2Exact(nodeSize / GPU_MEMORY_MIN_NODE_SIZE);
+
+	VkDeviceSize offset;
+	for (GpuBlock* block = pool->blocks; block; block = block->next) {
+		if (order < block->orderCount && buddyAllocate(block, order, &offset)) {
+			fillAllocation(allocator, block, offset, size, order, allocation);
+			return true;
+		}
+	}
+
+	// default pools start with an eighth of the block size and double with every block
+	VkDeviceSize blockSize = pool->blockSize;
+	if (!pool->custom) {
+		blockSize = pool->blockSize / 8;
+		for (uint32 i = 0; i < pool->blockCount && blockSize < pool->blockSize; i++) {
+			blockSize *= 2;
+		}
+	}
+	if (blockSize < nodeSize) {
+		if (pool->custom) {
+			return false;
+		}
+		blockSize = nodeSize;
+	}
+	if ((flags & GPU_ALLOCATION_WITHIN_BUDGET) && !isWithinBudget(allocator, pool->memoryType, blockSize)) {
+		return false;
+	}
+
+	GpuBlock* block = blockCreate(allocator, pool, blockSize);
+	// when the heap is nearly full smaller blocks may still fit
+	while (block == nullptr && !pool->custom && blockSize / 2 >= nodeSize) {
+		blockSize /= 2;
+		block = blockCreate(allocator, pool, blockSize);
+	}
+	if (block == nullptr || !buddyAllocate(block, order, &offset)) {
+		return false;
+	}
+	fillAllocation(allocator, block, offset, size, order, allocation);
+	return true;
+}
+
+static bool linearBlockAllocate(GpuAllocator allocator, GpuBlock* block, VkDeviceSize size, VkDeviceSize alignment, GpuResourceKind kind, GpuAllocation* allocation) {
+	VkDeviceSize offset = alignUp(block->linearOffset, alignment);
+	// a resource of another kind must not share a page with the previous one
+	if (block->linearOffset && block->lastKind != kind) {
+		offset = alignUp(offset, allocator->bufferImageGranularity);
+	}
+	if (offset + size > block->size) {
+		return false;
+	}
+	block->linearOffset = offset + size;
+	block->lastKind = kind;
+	fillAllocation(allocator, block, offset, size, 0, allocation);
+	return true;
+}
+
+static bool linearPoolAllocate(GpuAllocator allocator, GpuPool pool, VkDeviceSize size, VkDeviceSize alignment, GpuResourceKind kind, uint32 flags, GpuAllocation* allocation) {
+	for (GpuBlock* block = pool->currentBlock; block; block = block->next) {
+		if (linearBlockAllocate(allocator, block, size, alignment, kind, allocation)) {
+			pool->currentBlock = block;
+			return true;
+		}
+	}
+
+	VkDeviceSize blockSize = pool->blockSize > size ? pool->blockSize : alignUp(size, GPU_MEMORY_MIN_NODE_SIZE);
+	if ((flags & GPU_ALLOCATION_WITHIN_BUDGET) && !isWithinBudget(allocator, pool->memoryType, blockSize)) {
+		return false;
+	}
+	GpuBlock* block = blockCreate(allocator, pool, blockSize);
+	if (block == nullptr || !linearBlockAllocate(allocator, block, size, alignment, kind, allocation)) {
+		return false;
+	}
+	pool->currentBlock = block;
+	return true;
+}
+
+static bool allocateFromPool(GpuAllocator allocator, GpuPool pool, const VkMemoryRequirements* requirements, GpuResourceKind kind, uint32 flags, GpuAllocation* allocation) {
+	VkDeviceSize alignment = requirements->alignment ? requirements->alignment : 1;
+	// flushed ranges are widened to whole atoms, which must not reach in to another allocation
+	if (!isCoherent(allocator, pool->memoryType) && isHostVisible(allocator, pool->memoryType) && alignment < allocator->nonCoherentAtomSize) {
+		alignment = allocator->nonCoherentAtomSize;
+	}
+	if (pool->type == GPU_POOL_TYPE_LINEAR) {
+		return linearPoolAllocate(allocator, pool, requirements->size, alignment, kind, flags, allocation);
+	}
+	// custom buddy pools hold both kinds, a node aligned to the granularity is at least as large and covers whole pages
+	if (pool->custom && allocator->separateKinds && alignment < allocator->bufferImageGranularity) {
+		alignment = allocator->bufferImageGranularity;
+	}
+	return buddyPoolAllocate(allocator, pool, requirements->size, alignment, flags, allocation);
+}
+
+static bool dedicatedAllocate(GpuAllocator allocator, uint32 memoryType, VkDeviceSize size, uint32 flags, VkImage image, VkBuffer buffer, GpuAllocation* allocation) {
+	if ((flags & GPU_ALLOCATION_WITHIN_BUDGET) && !isWithinBudget(allocator, memoryType, size)) {
+		return false;
+	}
+	void* data;
+	if (allocateDeviceMemory(allocator, memoryType, size, image, buffer, &allocation->memory, &data) != VK_SUCCESS) {
+		return false;
+	}
+	allocation->offset = 0;
+	allocation->size = size;
+	allocation->data = data;
+	allocation->memoryType = memoryType;
+	allocation->coherent = isCoherent(allocator, memoryType);
+	allocation->block = nullptr;
+	allocation->order = 0;
+	return true;
+}
+
+static void trackGpuAllocation(GpuAllocator allocator, const GpuAllocation* allocation) {
+	GpuHeap* heap = getHeap(allocator, allocation->memoryType);
+	heap->allocationCount++;
+	heap->allocationBytes += allocation->size;
+}
+
+static AvResult allocateMemory(GpuAllocator allocator, const VkMemoryRequirements* requirements, GpuResourceKind kind, const GpuAllocationCreateInfo* createInfo, VkImage image, VkBuffer buffer, GpuAllocation* allocation) {
+	memset(allocation, 0, sizeof(GpuAllocation));
+
+	GpuPool pool = createInfo->pool;
+	if (pool) {
+		if (!(requirements->memoryTypeBits & (1u << pool->memoryType))) {
+			avLog(AV_INVALID_ARGUMENTS, "resource can not be placed in the memory type of the pool");
+			return AV_INVALID_ARGUMENTS;
+		}
+		if (!allocateFromPool(allocator, pool, requirements, kind, createInfo->flags, allocation)) {
+			avLogf(AV_MEMORY_ERROR, "gpu memory pool can not fit %llu bytes", (unsigned long long)requirements->size);
+			return AV_MEMORY_ERROR;
+		}
+		trackGpuAllocation(allocator, allocation);
+		return AV_SUCCESS;
+	}
+
+	// when a type is out of memory the next best one is tried
+	uint32 typeBits = requirements->memoryTypeBits;
+	uint32 memoryType;
+	while (selectMemoryType(allocator, typeBits, createInfo->usage, &memoryType)) {
+		GpuHeap* heap = getHeap(allocator, memoryType);
+		bool dedicated = (createInfo->flags & GPU_ALLOCATION_DEDICATED) || requirements->size > heap->preferredBlockSize / 2;
+		GpuPool defaultPool = &allocator->defaultPools[memoryType][allocator->separateKinds ? kind : GPU_RESOURCE_LINEAR];
+		if ((!dedicated && allocateFromPool(allocator, defaultPool, requirements, kind, createInfo->flags, allocation))
+			|| dedicatedAllocate(allocator, memoryType, requirements->size, createInfo->flags, image, buffer, allocation)) {
+			trackGpuAllocation(allocator, allocation);
+			return AV_SUCCESS;
+		}
+		typeBits &= ~(1u << memoryType);
+	}
+	avLogf(AV_MEMORY_ERROR, "out of gpu memory allocating %llu bytes", (unsigned long long)requirements->size);
+	return AV_MEMORY_ERROR;
+}
+
+void gpuAllocatorCreate(GpuAllocatorCreateInfo createInfo, GpuAllocator* pAllocator) {
+	GpuAllocator allocator = avAllocate(sizeof(GpuAllocator_T), 1, "allocating gpu memory allocator");
+	allocator->physicalDevice = createInfo.physicalDevice;
+	allocator->device = createInfo.device;
+	allocator->allocationCallbacks = createInfo.allocationCallbacks;
+	allocator->memoryBudgetEnabled = createInfo.memoryBudgetEnabled;
+	allocator->vulkan11 = createInfo.vulkan11;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(createInfo.physicalDevice, &properties);
+	allocator->bufferImageGranularity = properties.limits.bufferImageGranularity ? properties.limits.bufferImageGranularity : 1;
+	allocator->nonCoherentAtomSize = properties.limits.nonCoherentAtomSize ? properties.limits.nonCoherentAtomSize : 1;
+	allocator->maxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount ? properties.limits.maxMemoryAllocationCount : 4096;
+	allocator->separateKinds = allocator->bufferImageGranularity > GPU_MEMORY_MIN_NODE_SIZE;
+
+	vkGetPhysicalDeviceMemoryProperties(createInfo.physicalDevice, &allocator->memoryProperties);
+
+	// small heaps get blocks of an eighth of their size so a single block can not take all of it
+	VkDeviceSize preferredBlockSize = createInfo.preferredBlockSize ? powerOfTwoFloor(createInfo.preferredBlockSize) : GPU_MEMORY_BLOCK_SIZE_DEFAULT;
+	for (uint32 i = 0; i < allocator->memoryProperties.memoryHeapCount; i++) {
+		VkDeviceSize blockSize = powerOfTwoFloor(allocator->memoryProperties.memoryHeaps[i].size / 8);
+		if (blockSize > preferredBlockSize) {
+			blockSize = preferredBlockSize;
+		}
+		if (blockSize < GPU_MEMORY_MIN_NODE_SIZE * 8) {
+			blockSize = GPU_MEMORY_MIN_NODE_SIZE * 8;
+		}
+		allocator->heaps[i].preferredBlockSize = blockSize;
+	}
+	for (uint32 type = 0; type < allocator->memoryProperties.memoryTypeCount; type++) {
+		for (uint32 kind = 0; kind < GPU_RESOURCE_KIND_COUNT; kind++) {
+			GpuPool pool = &allocator->defaultPools[type][kind];
+			pool->type = GPU_POOL_TYPE_BUDDY;
+			pool->memoryType = type;
+			pool->blockSize = getHeap(allocator, type)->preferredBlockSize;
+		}
+	}
+	updateBudget(allocator);
+
+	*pAllocator = allocator;
+	avLogf(AV_DEBUG_CREATE, "created gpu memory allocator, memory budget %s", allocator->memoryBudgetEnabled ? "reported by the device" : "estimated");
+}
+
+static void poolReleaseBlocks(GpuAllocator allocator, GpuPool pool) {
+	while (pool->blocks) {
+		blockDestroy(allocator, pool, pool->blocks);
+	}
+}
+
+void gpuAllocatorDestroy(GpuAllocator allocator) {
+	uint32 leakedCount = 0;
+	VkDeviceSize leakedBytes = 0;
+	for (uint32 i = 0; i < allocator->memoryProperties.memoryHeapCount; i++) {
+		leakedCount += allocator->heaps[i].allocationCount;
+		leakedBytes += allocator->heaps[i].allocationBytes;
+	}
+	if (leakedCount) {
+		avLogf(AV_MEMORY_LEAK, "%u gpu allocations with %llu bytes were not freed", leakedCount, (unsigned long long)leakedBytes);
+	}
+
+	while (allocator->customPools) {
+		gpuPoolDestroy(allocator, allocator->customPools);
+	}
+	for (uint32 type = 0; type < allocator->memoryProperties.memoryTypeCount; type++) {
+		for (uint32 kind = 0; kind < GPU_RESOURCE_KIND_COUNT; kind++) {
+			poolReleaseBlocks(allocator, &allocator->defaultPools[type][kind]);
+		}
+	}
+	avFree(allocator);
+	avLog(AV_DEBUG_DESTROY, "destroyed gpu memory allocator");
+}
+
+AvResult gpuAllocateMemory(GpuAllocator allocator, const VkMemoryRequirements* requirements, GpuResourceKind kind, const GpuAllocationCreateInfo* createInfo, GpuAllocation* allocation) {
+	return allocateMemory(allocator, requirements, kind, createInfo, VK_NULL_HANDLE, VK_NULL_HANDLE, allocation);
+}
+
+void gpuFreeMemory(GpuAllocator allocator, GpuAllocation* allocation) {
+	if (allocation->memory == VK_NULL_HANDLE) {
+		return;
+	}
+	GpuHeap* heap = getHeap(allocator, allocation->memoryType);
+	heap->allocationCount--;
+	heap->allocationBytes -= allocation->size;
+
+	GpuBlock* block = allocation->block;
+	if (block == nullptr) {
+		freeDeviceMemory(allocator, allocation->memoryType, allocation->memory, allocation->size);
+	} else {
+		GpuPool pool = block->pool;
+		block->allocationCount--;
+		block->allocationBytes -= allocation->size;
+		if (pool->type == GPU_POOL_TYPE_BUDDY) {
+			buddyFree(block, allocation->order, allocation->offset);
+			if (block->allocationCount == 0) {
+				releaseEmptyBlock(allocator, pool, block);
+			}
+		} else if (block->allocationCount == 0) {
+			// space of linear pools is otherwise only reclaimed by gpuPoolReset
+			block->linearOffset = 0;
+		}
+	}
+	memset(allocation, 0, sizeof(GpuAllocation));
+}
+
+AvResult gpuCreateBuffer(GpuAllocator allocator, const VkBufferCreateInfo* bufferInfo, const GpuAllocationCreateInfo* createInfo, VkBuffer* buffer, GpuAllocation* allocation) {
+	if (vkCreateBuffer(allocator->device, bufferInfo, allocator->allocationCallbacks, buffer) != VK_SUCCESS) {
+		avLog(AV_CREATION_ERROR, "creating buffer");
+		return AV_CREATION_ERROR;
+	}
+	VkMemoryRequirements requirements;
+	vkGetBufferMemoryRequirements(allocator->device, *buffer, &requirements);
+
+	AvResult result = allocateMemory(allocator, &requirements, GPU_RESOURCE_LINEAR, createInfo, VK_NULL_HANDLE, *buffer, allocation);
+	if (result == AV_SUCCESS && vkBindBufferMemory(allocator->device, *buffer, allocation->memory, allocation->offset) != VK_SUCCESS) {
+		avLog(AV_CREATION_ERROR, "binding buffer memory");
+		gpuFreeMemory(allocator, allocation);
+		result = AV_CREATION_ERROR;
+	}
+	if (result != AV_SUCCESS) {
+		vkDestroyBuffer(allocator->device, *buffer, allocator->allocationCallbacks);
+		*buffer = VK_NULL_HANDLE;
+	}
+	return result;
+}
+
+void gpuDestroyBuffer(GpuAllocator allocator, VkBuffer buffer, GpuAllocation* allocation) {
+	vkDestroyBuffer(allocator->device, buffer, allocator->allocationCallbacks);
+	gpuFreeMemory(allocator, allocation);
+}
+
+AvResult gpuCreateImage(GpuAllocator allocator, const VkImageCreateInfo* imageInfo, const GpuAllocationCreateInfo* createInfo, VkImage* image, GpuAllocation* allocation) {
+	if (vkCreateImage(allocator->device, imageInfo, allocator->allocationCallbacks, image) != VK_SUCCESS) {
+		avLog(AV_CREATION_ERROR, "creating image");
+		return AV_CREATION_ERROR;
+	}
+	VkMemoryRequirements requirements;
+	vkGetImageMemoryRequirements(allocator->device, *image, &requirements);
+
+	GpuResourceKind kind = imageInfo->tiling == VK_IMAGE_TILING_OPTIMAL ? GPU_RESOURCE_OPTIMAL : GPU_RESOURCE_LINEAR;
+	AvResult result = allocateMemory(allocator, &requirements, kind, createInfo, *image, VK_NULL_HANDLE, allocation);
+	if (result == AV_SUCCESS && vkBindImageMemory(allocator->device, *image, allocation->memory, allocation->offset) != VK_SUCCESS) {
+		avLog(AV_CREATION_ERROR, "binding image memory");
+		gpuFreeMemory(allocator, allocation);
+		result = AV_CREATION_ERROR;
+	}
+	if (result != AV_SUCCESS) {
+		vkDestroyImage(allocator->device, *image, allocator->allocationCallbacks);
+		*image = VK_NULL_HANDLE;
+	}
+	return result;
+}
+
+void gpuDestroyImage(GpuAllocator allocator, VkImage image, GpuAllocation* allocation) {
+	vkDestroyImage(allocator->device, image, allocator->allocationCallbacks);
+	gpuFreeMemory(allocator, allocation);
+}
+
+// widens the range to whole atoms without reaching past the end of the device memory
+static VkMappedMemoryRange getMappedRange(GpuAllocator allocator, const GpuAllocation* allocation, VkDeviceSize offset, VkDeviceSize size) {
+	VkDeviceSize atom = allocator->nonCoherentAtomSize;
+	VkDeviceSize memorySize = allocation->block ? allocation->block->size : allocation->size;
+	if (size == VK_WHOLE_SIZE) {
+		size = allocation->size - offset;
+	}
+	VkDeviceSize begin = (allocation->offset + offset) / atom * atom;
+	VkDeviceSize end = alignUp(allocation->offset + offset + size, atom);
+	if (end > memorySize) {
+		end = memorySize;
+	}
+
+	VkMappedMemoryRange range = { 0 };
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.memory = allocation->memory;
+	range.offset = begin;
+	range.size = end - begin;
+	return range;
+}
+
+void gpuFlush(GpuAllocator allocator, const GpuAllocation* allocation, VkDeviceSize offset, VkDeviceSize size) {
+	if (allocation->coherent || size == 0) {
+		return;
+	}
+	VkMappedMemoryRange range = getMappedRange(allocator, allocation, offset, size);
+	vkFlushMappedMemoryRanges(allocator->device, 1, &range);
+}
+
+void gpuInvalidate(GpuAllocator allocator, const GpuAllocation* allocation, VkDeviceSize offset, VkDeviceSize size) {
+	if (allocation->coherent || size == 0) {
+		return;
+	}
+	VkMappedMemoryRange range = getMappedRange(allocator, allocation, offset, size);
+	vkInvalidateMappedMemoryRanges(allocator->device, 1, &range);
+}
+
+AvResult gpuPoolCreate(GpuAllocator allocator, GpuPoolCreateInfo createInfo, GpuPool* pPool) {
+	uint32 memoryType;
+	if (!selectMemoryType(allocator, createInfo.memoryTypeBits, createInfo.usage, &memoryType)) {
+		avLog(AV_NO_SUPPORT, "no memory type for gpu memory pool");
+		return AV_NO_SUPPORT;
+	}
+	GpuPool pool = avAllocate(sizeof(GpuPool_T), 1, "allocating gpu memory pool");
+	pool->type = createInfo.type;
+	pool->memoryType = memoryType;
+	pool->custom = true;
+	pool->blockSize = createInfo.blockSize ? createInfo.blockSize : getHeap(allocator, memoryType)->preferredBlockSize;
+	if (pool->type == GPU_POOL_TYPE_BUDDY) {
+		pool->blockSize = powerOfTwoCeil(pool->blockSize);
+		if (pool->blockSize < GPU_MEMORY_MIN_NODE_SIZE) {
+			pool->blockSize = GPU_MEMORY_MIN_NODE_SIZE;
+		}
+	}
+	pool->next = allocator->customPools;
+	allocator->customPools = pool;
+	*pPool = pool;
+	avLogf(AV_DEBUG_CREATE, "created %s gpu memory pool in memory type %u", pool->type == GPU_POOL_TYPE_LINEAR ? "linear" : "buddy", memoryType);
+	return AV_SUCCESS;
+}
+
+void gpuPoolDestroy(GpuAllocator allocator, GpuPool pool) {
+	GpuPool* link = &allocator->customPools;
+	while (*link != pool) {
+		link = &(*link)->next;
+	}
+	*link = pool->next;
+	poolReleaseBlocks(allocator, pool);
+	avFree(pool);
+	avLog(AV_DEBUG_DESTROY, "destroyed gpu memory pool");
+}
+
+void gpuPoolReset(GpuAllocator allocator, GpuPool pool) {
+	if (pool->type != GPU_POOL_TYPE_LINEAR) {
+		avLog(AV_INVALID_ARGUMENTS, "only linear gpu memory pools can be reset");
+		return;
+	}
+	uint32 allocationCount = 0;
+	VkDeviceSize allocationBytes = 0;
+	for (GpuBlock* block = pool->blocks; block; block = block->next) {
+		allocationCount += block->allocationCount;
+		allocationBytes += block->allocationBytes;
+		block->allocationCount = 0;
+		block->allocationBytes = 0;
+		block->linearOffset = 0;
+	}
+	pool->currentBlock = pool->blocks;
+
+	GpuHeap* heap = getHeap(allocator, pool->memoryType);
+	heap->allocationCount -= allocationCount;
+	heap->allocationBytes -= allocationBytes;
+}
+
+uint32 gpuAllocatorGetHeapStats(GpuAllocator allocator, GpuHeapStats stats[VK_MAX_MEMORY_HEAPS]) {
+	updateBudget(allocator);
+	for (uint32 i = 0; i < allocator->memoryProperties.memoryHeapCount; i++) {
+		const GpuHeap* heap = &allocator->heaps[i];
+		GpuHeapStats* heapStats = &stats[i];
+		heapStats->size = allocator->memoryProperties.memoryHeaps[i].size;
+		heapStats->deviceLocal = (allocator->memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+		heapStats->budget = heap->budget;
+		heapStats->usage = heap->usage;
+		heapStats->blockCount = heap->blockCount;
+		heapStats->blockBytes = heap->blockBytes;
+		heapStats->allocationCount = heap->allocationCount;
+		heapStats->allocationBytes = heap->allocationBytes;
+	}
+	return allocator->memoryProperties.memoryHeapCount;
+}
+
+void gpuAllocatorLogStats(GpuAllocator allocator) {
+	GpuHeapStats stats[VK_MAX_MEMORY_HEAPS];
+	uint32 heapCount = gpuAllocatorGetHeapStats(allocator, stats);
+	for (uint32 i = 0; i < heapCount; i++) {
+		const GpuHeapStats* heap = &stats[i];
+		avLogf(AV_DEBUG_INFO, "gpu heap %u%s: %u allocations with %llu bytes in %u blocks with %llu bytes, usage %llu of %llu budget",
+			i, heap->deviceLocal ? " (device local)" : "", heap->allocationCount, (unsigned long long)heap->allocationBytes, heap->blockCount,
+			(unsigned long long)heap->blockBytes, (unsigned long long)heap->usage, (unsigned long long)heap->budget);
+	}
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include "../../core.h"
+#include <vulkan/vulkan.h>
+
+// Device memory allocator for buffers and images.
+//
+// Resources are sub-allocated from large blocks of device memory instead of
+// getting a vkAllocateMemory each, which would run in to
+// maxMemoryAllocationCount and fragment device memory. The default pools use a
+// buddy allocator per block, so freed ranges merge with their neighbours right
+// away. Linear pools are created explicitly for data that is released all at
+// once, they only bump a pointer and are reset as a whole. Resources larger
+// than half a block, or created with GPU_ALLOCATION_DEDICATED, get their own
+// device memory.
+//
+// The memory type is chosen by what the resource is used for, when a type
+// runs out of memory the next best type is tried. Host visible blocks are
+// mapped once for their whole lifetime. Buffers and images with optimal tiling
+// never share a page of bufferImageGranularity, they are kept in separate
+// pools when the granularity exceeds the smallest buddy node. Custom buddy
+// pools hold both kinds and align every node to the granularity instead.
+//
+// Heap usage is reported per heap, with the budget of VK_EXT_memory_budget
+// when the device supports it. The allocator is not thread safe, it is used
+// from the render thread only.
+
+#define GPU_MEMORY_BLOCK_SIZE_DEFAULT (64ull * 1024 * 1024)
+// smallest buddy node, every sub-allocation is aligned to at least this
+#define GPU_MEMORY_MIN_NODE_SIZE 256
+#define GPU_MEMORY_MAX_ORDER_COUNT 32
+// without VK_EXT_memory_budget this share of a heap is assumed to be available, in percent
+#define GPU_MEMORY_ESTIMATED_BUDGET 80
+
+typedef struct GpuAllocator_T* GpuAllocator;
+typedef struct GpuPool_T* GpuPool;
+
+typedef enum GpuMemoryUsage {
+	// only accessed by the gpu, images and static geometry
+	GPU_MEMORY_USAGE_GPU_ONLY,
+	// written by the cpu once and copied to gpu only memory
+	GPU_MEMORY_USAGE_UPLOAD,
+	// written by the cpu every frame and read by the gpu directly, device local memory is preferred
+	GPU_MEMORY_USAGE_DYNAMIC,
+	// written by the gpu and read by the cpu
+	GPU_MEMORY_USAGE_READBACK,
+} GpuMemoryUsage;
+
+typedef enum GpuResourceKind {
+	// buffers and images with linear tiling
+	GPU_RESOURCE_LINEAR,
+	// images with optimal tiling
+	GPU_RESOURCE_OPTIMAL,
+	GPU_RESOURCE_KIND_COUNT,
+} GpuResourceKind;
+
+typedef enum GpuAllocationFlagBits {
+	// gets its own device memory instead of being sub-allocated
+	GPU_ALLOCATION_DEDICATED = 1 << 0,
+	// fails with AV_MEMORY_ERROR instead of allocating new device memory beyond the budget of the heap
+	GPU_ALLOCATION_WITHIN_BUDGET = 1 << 1,
+} GpuAllocationFlagBits;
+
+typedef enum GpuPoolType {
+	GPU_POOL_TYPE_BUDDY,
+	// allocations are only released by gpuPoolReset
+	GPU_POOL_TYPE_LINEAR,
+} GpuPoolType;
+
+typedef struct GpuAllocatorCreateInfo {
+	VkPhysicalDevice physicalDevice;
+	VkDevice device;
+	const VkAllocationCallbacks* allocationCallbacks;
+	// VK_EXT_memory_budget was enabled on the device
+	bool memoryBudgetEnabled;
+	// vulkan 1.1 is supported by the instance and the device
+	bool vulkan11;
+	// upper limit of the block size of the default pools, 0 selects GPU_MEMORY_BLOCK_SIZE_DEFAULT
+	VkDeviceSize preferredBlockSize;
+} GpuAllocatorCreateInfo;
+
+typedef struct GpuAllocationCreateInfo {
+	GpuMemoryUsage usage;
+	uint32 flags;
+	// nullptr allocates from the default pools
+	GpuPool pool;
+} GpuAllocationCreateInfo;
+
+typedef struct GpuPoolCreateInfo {
+	GpuPoolType type;
+	GpuMemoryUsage usage;
+	// memory types the resources of the pool accept, taken from their memory requirements
+	uint32 memoryTypeBits;
+	// size of every block of the pool, 0 selects the preferred block size of the heap
+	VkDeviceSize blockSize;
+} GpuPoolCreateInfo;
+
+typedef struct GpuAllocation {
+	VkDeviceMemory memory;
+	VkDeviceSize offset;
+	VkDeviceSize size;
+	// mapped address of offset, nullptr when the memory is not host visible
+	void* data;
+	uint32 memoryType;
+	bool coherent;
+	// block the allocation was taken from, nullptr for dedicated allocations
+	struct GpuBlock* block;
+	uint32 order;
+} GpuAllocation;
+
+typedef struct GpuHeapStats {
+	VkDeviceSize size;
+	bool deviceLocal;
+	// what the process may use of the heap, estimated without VK_EXT_memory_budget
+	VkDeviceSize budget;
+	// what the process uses of the heap, only the memory of this allocator without VK_EXT_memory_budget
+	VkDeviceSize usage;
+	// device memory allocated by this allocator, dedicated allocations included
+	uint32 blockCount;
+	VkDeviceSize blockBytes;
+	// sub-allocations and dedicated allocations handed out
+	uint32 allocationCount;
+	VkDeviceSize allocationBytes;
+} GpuHeapStats;
+
+void gpuAllocatorCreate(GpuAllocatorCreateInfo createInfo, GpuAllocator* allocator);
+
+/// <summary>
+/// releases all device memory, allocations that were not freed are reported
+/// </summary>
+void gpuAllocatorDestroy(GpuAllocator allocator);
+
+/// <summary>
+/// allocates memory for a resource with the given requirements, returns AV_MEMORY_ERROR when no memory type could satisfy it
+/// </summary>
+AvResult gpuAllocateMemory(GpuAllocator allocator, const VkMemoryRequirements* requirements, GpuResourceKind kind, const GpuAllocationCreateInfo* createInfo, GpuAllocation* allocation);
+
+void gpuFreeMemory(GpuAllocator allocator, GpuAllocation* allocation);
+
+/// <summary>
+/// creates a buffer and binds it to newly allocated memory
+/// </summary>
+AvResult gpuCreateBuffer(GpuAllocator allocator, const VkBufferCreateInfo* bufferInfo, const GpuAllocationCreateInfo* createInfo, VkBuffer* buffer, GpuAllocation* allocation);
+void gpuDestroyBuffer(GpuAllocator allocator, VkBuffer buffer, GpuAllocation* allocation);
+
+/// <summary>
+/// creates an image and binds it to newly allocated memory, large images get dedicated memory
+/// </summary>
+AvResult gpuCreateImage(GpuAllocator allocator, const VkImageCreateInfo* imageInfo, const GpuAllocationCreateInfo* createInfo, VkImage* image, GpuAllocation* allocation);
+void gpuDestroyImage(GpuAllocator allocator, VkImage image, GpuAllocation* allocation);
+
+/// <summary>
+/// makes host writes to a range of the allocation visible to the gpu, does nothing for coherent memory. size may be VK_WHOLE_SIZE
+/// </summary>
+void gpuFlush(GpuAllocator allocator, const GpuAllocation* allocation, VkDeviceSize offset, VkDeviceSize size);
+
+/// <summary>
+/// makes gpu writes to a range of the allocation visible to the host, does nothing for coherent memory. size may be VK_WHOLE_SIZE
+/// </summary>
+void gpuInvalidate(GpuAllocator allocator, const GpuAllocation* allocation, VkDeviceSize offset, VkDeviceSize size);
+
+/// <summary>
+/// creates a pool with its own blocks, returns AV_NO_SUPPORT when no memory type fits the usage and memoryTypeBits
+/// </summary>
+AvResult gpuPoolCreate(GpuAllocator allocator, GpuPoolCreateInfo createInfo, GpuPool* pool);
+void gpuPoolDestroy(GpuAllocator allocator, GpuPool pool);
+
+/// <summary>
+/// releases every allocation of a linear pool at once, the blocks are kept for reuse
+/// </summary>
+void gpuPoolReset(GpuAllocator allocator, GpuPool pool);
+
+/// <summary>
+/// fills one entry per memory heap, returns the number of heaps
+/// </summary>
+uint32 gpuAllocatorGetHeapStats(GpuAllocator allocator, GpuHeapStats stats[VK_MAX_MEMORY_HEAPS]);
+
+void gpuAllocatorLogStats(GpuAllocator allocator);
@@ -0,0 +1,214 @@
+#if !defined(_POSIX_C_SOURCE) && !defined(_WIN32)
+// fileno, fsync
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "vulkanPipelineCache.h"
+#include "../../util/hash.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#undef AV_LOG_CATEGORY
+#define AV_LOG_CATEGORY "avixel_renderer"
+
+// larger files are not from this renderer, they are rejected before allocating
+#define PIPELINE_CACHE_MAX_DATA_SIZE (256ull * 1024 * 1024)
+#define PIPELINE_CACHE_TEMP_SUFFIX ".tmp"
+
+// checks the header vulkan puts in front of the data against the device
+static bool vulkanHeaderMatches(const byte* data, uint64 size, const VkPhysicalDeviceProperties* properties) {
+	if (size < PIPELINE_CACHE_VULKAN_HEADER_SIZE) {
+		return false;
+	}
+	uint32 headerSize;
+	uint32 headerVersion;
+	uint32 vendorID;
+	uint32 deviceID;
+	memcpy(&headerSize, data, sizeof(uint32));
+	memcpy(&headerVersion, data + 4, sizeof(uint32));
+	memcpy(&vendorID, data + 8, sizeof(uint32));
+	memcpy(&deviceID, data + 12, sizeof(uint32));
+	return headerSize >= PIPELINE_CACHE_VULKAN_HEADER_SIZE && headerSize <= size &&
+		headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		vendorID == properties->vendorID &&
+		deviceID == properties->deviceID &&
+		memcmp(data + 16, properties->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+// returns the cache data of the opened file, nullptr when it was not written for this device
+static byte* readCacheData(FILE* file, const char* path, const VkPhysicalDeviceProperties* properties, uint64* dataSize) {
+	PipelineCacheFileHeader header = { 0 };
+	if (fread(&header, sizeof(PipelineCacheFileHeader), 1, file) != 1 ||
+		memcmp(header.magic, PIPELINE_CACHE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+		header.version != PIPELINE_CACHE_FILE_VERSION ||
+		header.dataSize == 0 || header.dataSize > PIPELINE_CACHE_MAX_DATA_SIZE) {
+		avLogf(AV_UNABLE_TO_PARSE, "%s is not a pipeline cache of this version, starting with an empty cache", path);
+		return nullptr;
+	}
+	if (header.driverVersion != properties->driverVersion) {
+		avLogf(AV_DEBUG_INFO, "pipeline cache %s was written by another driver version, starting with an empty cache", path);
+		return nullptr;
+	}
+
+	byte* data = avAllocate(1, header.dataSize, "allocating pipeline cache data");
+	if (fread(data, 1, header.dataSize, file) != header.dataSize || hashBytes(data, header.dataSize) != header.dataHash) {
+		avLogf(AV_UNABLE_TO_PARSE, "pipeline cache %s is truncated or corrupted, starting with an empty cache", path);
+		avFree(data);
+		return nullptr;
+	}
+	if (!vulkanHeaderMatches(data, header.dataSize, properties)) {
+		avLogf(AV_DEBUG_INFO, "pipeline cache %s was written for another device, starting with an empty cache", path);
+		avFree(data);
+		return nullptr;
+	}
+	*dataSize = header.dataSize;
+	return data;
+}
+
+static byte* readCacheFile(const char* path, const VkPhysicalDeviceProperties* properties, uint64* dataSize) {
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		avLogf(AV_DEBUG_INFO, "no pipeline cache at %s, starting with an empty cache", path);
+		return nullptr;
+	}
+	byte* data = readCacheData(file, path, properties, dataSize);
+	fclose(file);
+	return data;
+}
+
+void pipelineCacheCreate(VkDevice device, const VkPhysicalDeviceProperties* properties, const VkAllocationCallbacks* allocationCallbacks, const char* path, PipelineCache* cache) {
+	memset(cache, 0, sizeof(PipelineCache));
+
+	uint64 dataSize = 0;
+	byte* data = nullptr;
+	if (path) {
+		uint64 pathLength = strlen(path);
+		cache->path = avAllocate(1, pathLength + 1, "allocating pipeline cache path");
+		memcpy(cache->path, path, pathLength + 1);
+		data = readCacheFile(path, properties, &dataSize);
+	}
+
+	VkPipelineCacheCreateInfo createInfo = { 0 };
+	createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	createInfo.initialDataSize = data ? dataSize : 0;
+	createInfo.pInitialData = data;
+	VkResult result = vkCreatePipelineCache(device, &createInfo, allocationCallbacks, &cache->cache);
+	if (result != VK_SUCCESS && data) {
+		// the driver may still refuse data that passed the header checks
+		avLog(AV_UNABLE_TO_PARSE, "pipeline cache data was refused by the driver, starting with an empty cache");
+		avFree(data);
+		data = nullptr;
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(device, &createInfo, allocationCallbacks, &cache->cache);
+	}
+	if (result != VK_SUCCESS) {
+		avLog(AV_CREATION_ERROR, "failed to create pipeline cache, compiling pipelines without one");
+		cache->cache = VK_NULL_HANDLE;
+	}
+
+	if (data) {
+		cache->loaded = true;
+		cache->loadedSize = dataSize;
+		cache->loadedHash = hashBytes(data, dataSize);
+		avLogf(AV_DEBUG_CREATE, "created pipeline cache with %llu bytes from %s", (unsigned long long)dataSize, path);
+		avFree(data);
+	} else {
+		avLog(AV_DEBUG_CREATE, "created empty pipeline cache");
+	}
+}
+
+// makes the written file durable before it replaces the old one
+static bool flushCacheFile(FILE* file) {
+	if (fflush(file) != 0) {
+		return false;
+	}
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+static bool replaceCacheFile(const char* tempPath, const char* path) {
+#ifdef _WIN32
+	// rename does not replace existing files on windows
+	return MoveFileExA(tempPath, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return rename(tempPath, path) == 0;
+#endif
+}
+
+AvResult pipelineCacheSave(VkDevice device, const VkPhysicalDeviceProperties* properties, PipelineCache* cache) {
+	if (cache->path == nullptr || cache->cache == VK_NULL_HANDLE) {
+		return AV_SUCCESS;
+	}
+
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(device, cache->cache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+		avLog(AV_IO_ERROR, "failed to query the pipeline cache size");
+		return AV_IO_ERROR;
+	}
+	byte* data = avAllocate(1, dataSize, "allocating pipeline cache data");
+	if (vkGetPipelineCacheData(device, cache->cache, &dataSize, data) != VK_SUCCESS) {
+		avLog(AV_IO_ERROR, "failed to get the pipeline cache data");
+		avFree(data);
+		return AV_IO_ERROR;
+	}
+
+	PipelineCacheFileHeader header = { 0 };
+	memcpy(header.magic, PIPELINE_CACHE_FILE_MAGIC, sizeof(header.magic));
+	header.version = PIPELINE_CACHE_FILE_VERSION;
+	header.driverVersion = properties->driverVersion;
+	header.dataSize = dataSize;
+	header.dataHash = hashBytes(data, dataSize);
+	if (cache->loaded && header.dataSize == cache->loadedSize && header.dataHash == cache->loadedHash) {
+		avLog(AV_DEBUG_INFO, "pipeline cache unchanged, not written");
+		avFree(data);
+		return AV_SUCCESS;
+	}
+
+	uint64 pathLength = strlen(cache->path);
+	char* tempPath = avAllocate(1, pathLength + sizeof(PIPELINE_CACHE_TEMP_SUFFIX), "allocating pipeline cache path");
+	memcpy(tempPath, cache->path, pathLength);
+	memcpy(tempPath + pathLength, PIPELINE_CACHE_TEMP_SUFFIX, sizeof(PIPELINE_CACHE_TEMP_SUFFIX));
+
+	AvResult result = AV_SUCCESS;
+	FILE* file = fopen(tempPath, "wb");
+	if (file == nullptr) {
+		avLogf(AV_IO_ERROR, "failed to open pipeline cache file %s", tempPath);
+		result = AV_IO_ERROR;
+	} else {
+		bool written = fwrite(&header, sizeof(PipelineCacheFileHeader), 1, file) == 1 &&
+			fwrite(data, 1, dataSize, file) == dataSize &&
+			flushCacheFile(file);
+		written = fclose(file) == 0 && written;
+		if (!written || !replaceCacheFile(tempPath, cache->path)) {
+			avLogf(AV_IO_ERROR, "failed to write pipeline cache file %s", cache->path);
+			remove(tempPath);
+			result = AV_IO_ERROR;
+		} else {
+			avLogf(AV_DEBUG_SUCCESS, "wrote %llu bytes of pipeline cache to %s", (unsigned long long)dataSize, cache->path);
+		}
+	}
+
+	avFree(tempPath);
+	avFree(data);
+	return result;
+}
+
+void pipelineCacheDestroy(VkDevice device, const VkAllocationCallbacks* allocationCallbacks, PipelineCache* cache) {
+	if (cache->cache != VK_NULL_HANDLE) {
+		vkDestroyPipelineCache(device, cache->cache, allocationCallbacks);
+		avLog(AV_DEBUG_DESTROY, "destroyed pipeline cache");
+	}
+	if (cache->path) {
+		avFree(cache->path);
+	}
+	memset(cache, 0, sizeof(PipelineCache));
+}
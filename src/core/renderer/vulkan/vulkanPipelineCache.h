@@ -0,0 +1,56 @@
+#pragma once
+#include "../../core.h"
+#include <vulkan/vulkan.h>
+
+// Pipeline cache that is kept on disk between runs.
+//
+// Compiling the shaders of the pipelines is a large part of the startup time
+// on embedded gpus, with the cache of the previous run the driver can skip it.
+// The file starts with a PipelineCacheFileHeader followed by the data of
+// vkGetPipelineCacheData. The data is only handed to the driver when the file
+// is complete and the vulkan header matches the vendor, device and cache uuid
+// of the physical device, otherwise the cache starts empty and the file is
+// replaced at shutdown.
+//
+// The file is written to a temporary file next to it and renamed over the old
+// one, so a crash or power loss while saving never leaves a truncated cache
+// behind. Nothing is written when the cache did not change.
+//
+// Values are stored in the byte order of the machine that wrote the cache.
+
+#define PIPELINE_CACHE_FILE_MAGIC "AVPCACHE"
+#define PIPELINE_CACHE_FILE_VERSION 1
+// size of the header vulkan puts in front of the cache data, version one
+#define PIPELINE_CACHE_VULKAN_HEADER_SIZE (16 + VK_UUID_SIZE)
+
+typedef struct PipelineCacheFileHeader {
+	char magic[8];
+	uint32 version;
+	// drivers don't always change the cache uuid when they are updated
+	uint32 driverVersion;
+	uint64 dataSize;
+	uint64 dataHash;
+} PipelineCacheFileHeader;
+
+typedef struct PipelineCache {
+	VkPipelineCache cache;
+	// owned copy of the file path, nullptr keeps the cache in memory only
+	char* path;
+	// the data of the file was accepted
+	bool loaded;
+	// size and hash of the loaded data, to skip writing an unchanged cache
+	uint64 loadedSize;
+	uint64 loadedHash;
+} PipelineCache;
+
+/// <summary>
+/// creates the pipeline cache with the data of the file at path when it was written for the same device and driver, otherwise the cache starts empty. path may be nullptr
+/// </summary>
+void pipelineCacheCreate(VkDevice device, const VkPhysicalDeviceProperties* properties, const VkAllocationCallbacks* allocationCallbacks, const char* path, PipelineCache* cache);
+
+/// <summary>
+/// writes the cache to its file when it changed, returns AV_IO_ERROR when the file could not be replaced
+/// </summary>
+AvResult pipelineCacheSave(VkDevice device, const VkPhysicalDeviceProperties* properties, PipelineCache* cache);
+
+void pipelineCacheDestroy(VkDevice device, const VkAllocationCallbacks* allocationCallbacks, PipelineCache* cache);
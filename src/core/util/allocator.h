@@ -0,0 +1,14 @@
+#pragma once
+#include "../core.h"
+
+// Minimal allocator interface for containers that should be able to run on
+// arenas or other custom memory sources instead of the general purpose heap.
+// Returned memory is uninitialized.
+typedef struct Allocator {
+	void* (*allocate)(uint64 size, void* userData);
+	void (*free)(void* data, void* userData);
+	void* userData;
+} Allocator;
+
+// routes to avAllocate and avFree
+extern const Allocator defaultAllocator;
@@ -0,0 +1,43 @@
+#pragma once
+#include "../core.h"
+
+#include <string.h>
+
+// Fast non-cryptographic hashing. Do not use these where an attacker controls
+// the input and collisions matter.
+
+#define HASH_MULTIPLIER 0x9E3779B97F4A7C15ULL
+
+// 64 bit finalizer (murmur3 fmix64)
+static inline uint64 hashUint64(uint64 value) {
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdULL;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ULL;
+	value ^= value >> 33;
+	return value;
+}
+
+static inline uint64 hashBytes(const void* data, uint64 size) {
+	const byte* bytes = (const byte*)data;
+	uint64 hash = HASH_MULTIPLIER ^ size;
+
+	while (size >= 8) {
+		uint64 value;
+		memcpy(&value, bytes, 8);
+		hash = (hash ^ hashUint64(value)) * HASH_MULTIPLIER;
+		bytes += 8;
+		size -= 8;
+	}
+	if (size) {
+		uint64 value = 0;
+		memcpy(&value, bytes, size);
+		hash = (hash ^ hashUint64(value)) * HASH_MULTIPLIER;
+	}
+
+	return hashUint64(hash);
+}
+
+static inline uint64 hashString(const char* str) {
+	return hashBytes(str, strlen(str));
+}
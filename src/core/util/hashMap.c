@@ -0,0 +1,364 @@
+#include "hashMap.h"
+
+#include <memory.h>
+#include <string.h>
+
+#define HASH_MAP_MIN_CAPACITY 8
+// grow once the map would become more than 7/8 full
+#define HASH_MAP_LOAD_NUMERATOR 7
+#define HASH_MAP_LOAD_DENOMINATOR 8
+#define HASH_MAP_EMPTY 0
+#define HASH_MAP_NOT_FOUND ((uint64)-1)
+#define HASH_MAP_ALIGNMENT 16
+
+typedef struct HashMap_T {
+	uint64 count;
+	uint64 capacity;
+	uint keySize;
+	uint valueSize;
+	HashMapHashFunction hash;
+	HashMapEqualsFunction equals;
+	// keys are hashed and compared as raw bytes, which is done inline
+	bool rawKeys;
+	Allocator allocator;
+
+	// 32 bit fingerprint of the hash for every slot, HASH_MAP_EMPTY marks an empty slot.
+	// Most mismatches are rejected on the fingerprint without touching the key
+	uint32* fingerprints;
+	byte* keys;
+	byte* values;
+
+	// scratch space used to carry entries while they are displaced (2 keys and 2 values)
+	byte* swap;
+} HashMap_T;
+
+static uint64 hashMapHashBytes(const void* key, uint64 keySize) {
+	return hashBytes(key, keySize);
+}
+
+static bool hashMapEqualsBytes(const void* keyA, const void* keyB, uint64 keySize) {
+	return memcmp(keyA, keyB, keySize) == 0;
+}
+
+uint64 hashMapHashString(const void* key, uint64 keySize) {
+	return hashString(*(const char* const*)key);
+}
+
+bool hashMapEqualsString(const void* keyA, const void* keyB, uint64 keySize) {
+	return strcmp(*(const char* const*)keyA, *(const char* const*)keyB) == 0;
+}
+
+static inline uint64 hashMapHashKey(const void* key, HashMap map) {
+	if (map->rawKeys) {
+		// integer and pointer keys
+		if (map->keySize == sizeof(uint64)) {
+			uint64 value;
+			memcpy(&value, key, sizeof(uint64));
+			return hashUint64(value);
+		}
+		return hashBytes(key, map->keySize);
+	}
+	return map->hash(key, map->keySize);
+}
+
+static inline bool hashMapKeyEquals(const void* keyA, const void* keyB, HashMap map) {
+	if (map->rawKeys) {
+		if (map->keySize == sizeof(uint64)) {
+			uint64 valueA, valueB;
+			memcpy(&valueA, keyA, sizeof(uint64));
+			memcpy(&valueB, keyB, sizeof(uint64));
+			return valueA == valueB;
+		}
+		return memcmp(keyA, keyB, map->keySize) == 0;
+	}
+	return map->equals(keyA, keyB, map->keySize);
+}
+
+static inline uint64 alignUp(uint64 value, uint64 alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static inline uint32 hashMapFingerprint(uint64 hash) {
+	uint32 fingerprint = (uint32)(hash ^ (hash >> 32));
+	return fingerprint == HASH_MAP_EMPTY ? 1 : fingerprint;
+}
+
+static inline byte* hashMapKeyAt(uint64 slot, HashMap map) {
+	return map->keys + slot * map->keySize;
+}
+
+static inline byte* hashMapValueAt(uint64 slot, HashMap map) {
+	return map->values + slot * map->valueSize;
+}
+
+// distance of the entry in slot from the slot it would ideally occupy
+static inline uint64 hashMapProbeDistance(uint32 fingerprint, uint64 slot, HashMap map) {
+	uint64 mask = map->capacity - 1;
+	return (slot - (fingerprint & mask)) & mask;
+}
+
+static void hashMapAllocateSlots(uint64 capacity, HashMap map) {
+	uint64 keyOffset = alignUp(capacity * sizeof(uint32), HASH_MAP_ALIGNMENT);
+	uint64 valueOffset = alignUp(keyOffset + capacity * map->keySize, HASH_MAP_ALIGNMENT);
+	uint64 size = valueOffset + capacity * map->valueSize;
+
+	byte* block = map->allocator.allocate(size, map->allocator.userData);
+	if (!block) {
+		avAssert(AV_MEMORY_ERROR, AV_SUCCESS, "allocating hash map slots");
+		return;
+	}
+	memset(block, 0, capacity * sizeof(uint32));
+
+	map->fingerprints = (uint32*)block;
+	map->keys = block + keyOffset;
+	map->values = block + valueOffset;
+	map->capacity = capacity;
+}
+
+// places an entry that is known not to be in the map yet
+static void* hashMapPlace(uint32 fingerprint, const void* key, const void* value, HashMap map) {
+	uint64 mask = map->capacity - 1;
+	uint64 slot = fingerprint & mask;
+	uint64 distance = 0;
+	void* placed = nullptr;
+
+	byte* carryKey = map->swap;
+	byte* carryValue = carryKey + map->keySize;
+	byte* tempKey = carryValue + map->valueSize;
+	byte* tempValue = tempKey + map->keySize;
+
+	memcpy(carryKey, key, map->keySize);
+	if (value) {
+		memcpy(carryValue, value, map->valueSize);
+	} else {
+		memset(carryValue, 0, map->valueSize);
+	}
+	uint32 carryFingerprint = fingerprint;
+
+	while (true) {
+		uint32 stored = map->fingerprints[slot];
+
+		if (stored == HASH_MAP_EMPTY) {
+			map->fingerprints[slot] = carryFingerprint;
+			memcpy(hashMapKeyAt(slot, map), carryKey, map->keySize);
+			memcpy(hashMapValueAt(slot, map), carryValue, map->valueSize);
+			return placed ? placed : hashMapValueAt(slot, map);
+		}
+
+		// take the slot from entries that are closer to their ideal position
+		uint64 storedDistance = hashMapProbeDistance(stored, slot, map);
+		if (storedDistance < distance) {
+			memcpy(tempKey, hashMapKeyAt(slot, map), map->keySize);
+			memcpy(tempValue, hashMapValueAt(slot, map), map->valueSize);
+			memcpy(hashMapKeyAt(slot, map), carryKey, map->keySize);
+			memcpy(hashMapValueAt(slot, map), carryValue, map->valueSize);
+			memcpy(carryKey, tempKey, map->keySize);
+			memcpy(carryValue, tempValue, map->valueSize);
+
+			map->fingerprints[slot] = carryFingerprint;
+			carryFingerprint = stored;
+
+			if (!placed) {
+				placed = hashMapValueAt(slot, map);
+			}
+			distance = storedDistance;
+		}
+
+		slot = (slot + 1) & mask;
+		distance++;
+	}
+}
+
+static uint64 hashMapFind(uint32 fingerprint, const void* key, HashMap map) {
+	if (map->count == 0) {
+		return HASH_MAP_NOT_FOUND;
+	}
+
+	uint64 mask = map->capacity - 1;
+	uint64 slot = fingerprint & mask;
+	uint64 distance = 0;
+
+	while (true) {
+		uint32 stored = map->fingerprints[slot];
+		if (stored == HASH_MAP_EMPTY) {
+			return HASH_MAP_NOT_FOUND;
+		}
+		// robin hood invariant: the key would have been placed before this entry
+		if (hashMapProbeDistance(stored, slot, map) < distance) {
+			return HASH_MAP_NOT_FOUND;
+		}
+		if (stored == fingerprint && hashMapKeyEquals(key, hashMapKeyAt(slot, map), map)) {
+			return slot;
+		}
+		slot = (slot + 1) & mask;
+		distance++;
+	}
+}
+
+void hashMapCreate(HashMapCreateInfo createInfo, HashMap* map) {
+
+	if (createInfo.keySize == 0) {
+		avAssert(AV_INVALID_SIZE, AV_SUCCESS, "hash map key size must not be 0");
+	}
+
+	Allocator allocator = createInfo.allocator ? *createInfo.allocator : defaultAllocator;
+
+	uint64 swapSize = 2 * ((uint64)createInfo.keySize + createInfo.valueSize);
+	uint64 size = alignUp(sizeof(HashMap_T), HASH_MAP_ALIGNMENT) + swapSize;
+	*map = allocator.allocate(size, allocator.userData);
+	if (!*map) {
+		avAssert(AV_MEMORY_ERROR, AV_SUCCESS, "allocating hash map");
+		return;
+	}
+	memset(*map, 0, sizeof(HashMap_T));
+
+	(*map)->keySize = createInfo.keySize;
+	(*map)->valueSize = createInfo.valueSize;
+	(*map)->hash = createInfo.hash ? createInfo.hash : hashMapHashBytes;
+	(*map)->equals = createInfo.equals ? createInfo.equals : hashMapEqualsBytes;
+	(*map)->rawKeys = !createInfo.hash && !createInfo.equals;
+	(*map)->allocator = allocator;
+	(*map)->swap = (byte*)(*map) + alignUp(sizeof(HashMap_T), HASH_MAP_ALIGNMENT);
+
+	if (createInfo.initialCapacity) {
+		hashMapReserve(createInfo.initialCapacity, *map);
+	}
+}
+
+void hashMapDestroy(HashMap map) {
+	Allocator allocator = map->allocator;
+	if (map->fingerprints) {
+		allocator.free(map->fingerprints, allocator.userData);
+	}
+	allocator.free(map, allocator.userData);
+}
+
+void* hashMapInsert(const void* key, const void* value, HashMap map) {
+	uint32 fingerprint = hashMapFingerprint(hashMapHashKey(key, map));
+
+	uint64 slot = hashMapFind(fingerprint, key, map);
+	if (slot != HASH_MAP_NOT_FOUND) {
+		void* storedValue = hashMapValueAt(slot, map);
+		if (value) {
+			memcpy(storedValue, value, map->valueSize);
+		}
+		return storedValue;
+	}
+
+	if ((map->count + 1) * HASH_MAP_LOAD_DENOMINATOR > map->capacity * HASH_MAP_LOAD_NUMERATOR) {
+		hashMapRehash(map->capacity ? map->capacity * 2 : HASH_MAP_MIN_CAPACITY, map);
+	}
+
+	map->count++;
+	return hashMapPlace(fingerprint, key, value, map);
+}
+
+void* hashMapGet(const void* key, HashMap map) {
+	uint32 fingerprint = hashMapFingerprint(hashMapHashKey(key, map));
+	uint64 slot = hashMapFind(fingerprint, key, map);
+	if (slot == HASH_MAP_NOT_FOUND) {
+		return nullptr;
+	}
+	return hashMapValueAt(slot, map);
+}
+
+bool hashMapContains(const void* key, HashMap map) {
+	return hashMapGet(key, map) != nullptr;
+}
+
+bool hashMapRemove(const void* key, HashMap map) {
+	uint32 fingerprint = hashMapFingerprint(hashMapHashKey(key, map));
+	uint64 slot = hashMapFind(fingerprint, key, map);
+	if (slot == HASH_MAP_NOT_FOUND) {
+		return false;
+	}
+
+	// shift the following entries back until one is found that is in its ideal slot
+	uint64 mask = map->capacity - 1;
+	uint64 next = (slot + 1) & mask;
+	while (true) {
+		uint32 stored = map->fingerprints[next];
+		if (stored == HASH_MAP_EMPTY || hashMapProbeDistance(stored, next, map) == 0) {
+			break;
+		}
+		map->fingerprints[slot] = stored;
+		memcpy(hashMapKeyAt(slot, map), hashMapKeyAt(next, map), map->keySize);
+		memcpy(hashMapValueAt(slot, map), hashMapValueAt(next, map), map->valueSize);
+		slot = next;
+		next = (next + 1) & mask;
+	}
+	map->fingerprints[slot] = HASH_MAP_EMPTY;
+	map->count--;
+
+	return true;
+}
+
+uint64 hashMapGetSize(HashMap map) {
+	return map->count;
+}
+
+uint64 hashMapGetCapacity(HashMap map) {
+	return map->capacity;
+}
+
+void hashMapReserve(uint64 count, HashMap map) {
+	uint64 required = (count * HASH_MAP_LOAD_DENOMINATOR + HASH_MAP_LOAD_NUMERATOR - 1) / HASH_MAP_LOAD_NUMERATOR;
+	if (required > map->capacity) {
+		hashMapRehash(required, map);
+	}
+}
+
+void hashMapRehash(uint64 capacity, HashMap map) {
+
+	// the capacity is a power of two that still fits all entries
+	uint64 minimum = (map->count * HASH_MAP_LOAD_DENOMINATOR + HASH_MAP_LOAD_NUMERATOR - 1) / HASH_MAP_LOAD_NUMERATOR;
+	if (capacity < minimum) {
+		capacity = minimum;
+	}
+	uint64 newCapacity = HASH_MAP_MIN_CAPACITY;
+	while (newCapacity < capacity) {
+		newCapacity *= 2;
+	}
+
+	uint64 oldCapacity = map->capacity;
+	uint32* oldFingerprints = map->fingerprints;
+	byte* oldKeys = map->keys;
+	byte* oldValues = map->values;
+
+	hashMapAllocateSlots(newCapacity, map);
+
+	// the stored fingerprints determine the position, so keys are not hashed again
+	for (uint64 i = 0; i < oldCapacity; i++) {
+		if (oldFingerprints[i] != HASH_MAP_EMPTY) {
+			hashMapPlace(oldFingerprints[i], oldKeys + i * map->keySize, oldValues + i * map->valueSize, map);
+		}
+	}
+
+	if (oldFingerprints) {
+		map->allocator.free(oldFingerprints, map->allocator.userData);
+	}
+}
+
+void hashMapClear(HashMap map) {
+	if (map->fingerprints) {
+		memset(map->fingerprints, 0, map->capacity * sizeof(uint32));
+	}
+	map->count = 0;
+}
+
+bool hashMapIterate(uint64* iterator, const void** key, void** value, HashMap map) {
+	for (; *iterator < map->capacity; (*iterator)++) {
+		uint64 slot = *iterator;
+		if (map->fingerprints[slot] != HASH_MAP_EMPTY) {
+			if (key) {
+				*key = hashMapKeyAt(slot, map);
+			}
+			if (value) {
+				*value = hashMapValueAt(slot, map);
+			}
+			(*iterator)++;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include "../core.h"
+#include "allocator.h"
+#include "hash.h"
+
+// Open addressing hash map using robin hood probing with backward shift
+// deletion. Keys and values are stored by value, like in DynamicArray.
+
+typedef struct HashMap_T* HashMap;
+
+typedef uint64 (*HashMapHashFunction)(const void* key, uint64 keySize);
+typedef bool (*HashMapEqualsFunction)(const void* keyA, const void* keyB, uint64 keySize);
+
+typedef struct HashMapCreateInfo {
+	uint keySize;
+	uint valueSize;
+	// hashes the raw key bytes when not specified
+	HashMapHashFunction hash;
+	// compares the raw key bytes when not specified
+	HashMapEqualsFunction equals;
+	// uses avAllocate and avFree when not specified
+	const Allocator* allocator;
+	uint64 initialCapacity;
+} HashMapCreateInfo;
+
+// hash and equals functions for keys of type const char*
+uint64 hashMapHashString(const void* key, uint64 keySize);
+bool hashMapEqualsString(const void* keyA, const void* keyB, uint64 keySize);
+
+void hashMapCreate(HashMapCreateInfo createInfo, HashMap* map);
+void hashMapDestroy(HashMap map);
+
+/// <summary>
+/// inserts or overwrites the value for key and returns a pointer to the stored value.
+/// WARNING: the pointer is invalidated by any other insertion or removal
+/// </summary>
+void* hashMapInsert(const void* key, const void* value, HashMap map);
+
+/// <summary>
+/// returns a pointer to the value stored for key or nullptr when it is not present
+/// </summary>
+void* hashMapGet(const void* key, HashMap map);
+bool hashMapContains(const void* key, HashMap map);
+bool hashMapRemove(const void* key, HashMap map);
+
+uint64 hashMapGetSize(HashMap map);
+uint64 hashMapGetCapacity(HashMap map);
+
+/// <summary>
+/// make sure count entries fit without growing the map
+/// </summary>
+void hashMapReserve(uint64 count, HashMap map);
+
+/// <summary>
+/// rebuild the map with at least the given capacity, can be used to shrink the map
+/// </summary>
+void hashMapRehash(uint64 capacity, HashMap map);
+
+void hashMapClear(HashMap map);
+
+/// <summary>
+/// iterate over all entries, start with *iterator = 0. Returns false when done.
+/// The map must not be modified during iteration
+/// </summary>
+bool hashMapIterate(uint64* iterator, const void** key, void** value, HashMap map);
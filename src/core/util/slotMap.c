@@ -0,0 +1,174 @@
+#include "slotMap.h"
+
+#include <memory.h>
+
+#define SLOT_MAP_MIN_CAPACITY 8
+#define SLOT_MAP_NO_FREE_SLOT ((uint32)-1)
+
+typedef struct Slot {
+	// position in the dense array while in use, next free slot otherwise
+	uint32 index;
+	uint32 generation;
+} Slot;
+
+typedef struct SlotMap_T {
+	uint dataSize;
+
+	uint32 count;
+	uint32 capacity;
+	byte* data;
+	uint32* denseToSlot;
+
+	uint32 slotCount;
+	uint32 slotCapacity;
+	Slot* slots;
+	uint32 freeSlot;
+} SlotMap_T;
+
+void slotMapCreate(uint dataSize, SlotMap* slotMap) {
+
+	if (dataSize == 0) {
+		avAssert(AV_INVALID_SIZE, AV_SUCCESS, "specified data size must not be 0");
+	}
+
+	*slotMap = avAllocate(sizeof(SlotMap_T), 1, "allocating slot map");
+	(*slotMap)->dataSize = dataSize;
+	(*slotMap)->freeSlot = SLOT_MAP_NO_FREE_SLOT;
+}
+
+void slotMapDestroy(SlotMap slotMap) {
+	avFree(slotMap->data);
+	avFree(slotMap->denseToSlot);
+	avFree(slotMap->slots);
+	avFree(slotMap);
+}
+
+void slotMapReserve(uint count, SlotMap slotMap) {
+	if (count <= slotMap->capacity) {
+		return;
+	}
+
+	uint32 capacity = slotMap->capacity * 2;
+	if (capacity < SLOT_MAP_MIN_CAPACITY) {
+		capacity = SLOT_MAP_MIN_CAPACITY;
+	}
+	if (capacity < count) {
+		capacity = count;
+	}
+
+	slotMap->data = avReallocate(slotMap->data, slotMap->dataSize, capacity, "increasing slot map data");
+	slotMap->denseToSlot = avReallocate(slotMap->denseToSlot, sizeof(uint32), capacity, "increasing slot map dense indices");
+	slotMap->capacity = capacity;
+
+	// there are never more slots than the most elements ever stored at once
+	slotMap->slots = avReallocate(slotMap->slots, sizeof(Slot), capacity, "increasing slot map slots");
+	slotMap->slotCapacity = capacity;
+}
+
+SlotMapHandle slotMapInsert(const void* data, SlotMap slotMap) {
+	if (slotMap->count == slotMap->capacity) {
+		slotMapReserve(slotMap->count + 1, slotMap);
+	}
+
+	uint32 slotIndex;
+	if (slotMap->freeSlot != SLOT_MAP_NO_FREE_SLOT) {
+		slotIndex = slotMap->freeSlot;
+		slotMap->freeSlot = slotMap->slots[slotIndex].index;
+	} else {
+		slotIndex = slotMap->slotCount++;
+		slotMap->slots[slotIndex].generation = 1;
+	}
+
+	uint32 denseIndex = slotMap->count++;
+	Slot* slot = &slotMap->slots[slotIndex];
+	slot->index = denseIndex;
+	slotMap->denseToSlot[denseIndex] = slotIndex;
+
+	byte* element = slotMap->data + (uint64)denseIndex * slotMap->dataSize;
+	if (data) {
+		memcpy(element, data, slotMap->dataSize);
+	} else {
+		memset(element, 0, slotMap->dataSize);
+	}
+
+	SlotMapHandle handle = { .index = slotIndex, .generation = slot->generation };
+	return handle;
+}
+
+static inline Slot* slotMapGetSlot(SlotMapHandle handle, SlotMap slotMap) {
+	if (handle.index >= slotMap->slotCount) {
+		return nullptr;
+	}
+	Slot* slot = &slotMap->slots[handle.index];
+	if (slot->generation != handle.generation) {
+		return nullptr;
+	}
+	return slot;
+}
+
+bool slotMapRemove(SlotMapHandle handle, SlotMap slotMap) {
+	Slot* slot = slotMapGetSlot(handle, slotMap);
+	if (!slot) {
+		return false;
+	}
+
+	// move the last element into the hole
+	uint32 denseIndex = slot->index;
+	uint32 lastIndex = --slotMap->count;
+	if (denseIndex != lastIndex) {
+		memcpy(
+			slotMap->data + (uint64)denseIndex * slotMap->dataSize,
+			slotMap->data + (uint64)lastIndex * slotMap->dataSize,
+			slotMap->dataSize
+		);
+		uint32 movedSlot = slotMap->denseToSlot[lastIndex];
+		slotMap->denseToSlot[denseIndex] = movedSlot;
+		slotMap->slots[movedSlot].index = denseIndex;
+	}
+
+	// invalidate outstanding handles and put the slot on the free list
+	slot->generation++;
+	if (slot->generation == 0) {
+		slot->generation = 1;
+	}
+	slot->index = slotMap->freeSlot;
+	slotMap->freeSlot = handle.index;
+
+	return true;
+}
+
+void* slotMapGet(SlotMapHandle handle, SlotMap slotMap) {
+	Slot* slot = slotMapGetSlot(handle, slotMap);
+	if (!slot) {
+		return nullptr;
+	}
+	return slotMap->data + (uint64)slot->index * slotMap->dataSize;
+}
+
+bool slotMapContains(SlotMapHandle handle, SlotMap slotMap) {
+	return slotMapGetSlot(handle, slotMap) != nullptr;
+}
+
+uint slotMapGetSize(SlotMap slotMap) {
+	return slotMap->count;
+}
+
+void* slotMapGetData(SlotMap slotMap) {
+	return slotMap->data;
+}
+
+SlotMapHandle slotMapGetHandle(uint denseIndex, SlotMap slotMap) {
+	if (denseIndex >= slotMap->count) {
+		avAssert(AV_OUT_OF_BOUNDS, 0, "accessing slot map out of bounds");
+		return SLOT_MAP_HANDLE_NULL;
+	}
+	uint32 slotIndex = slotMap->denseToSlot[denseIndex];
+	SlotMapHandle handle = { .index = slotIndex, .generation = slotMap->slots[slotIndex].generation };
+	return handle;
+}
+
+void slotMapClear(SlotMap slotMap) {
+	while (slotMap->count) {
+		slotMapRemove(slotMapGetHandle(slotMap->count - 1, slotMap), slotMap);
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "../core.h"
+
+// Generational slot map.
+//
+// Elements are stored densely packed, so iterating all live elements is a
+// linear scan without holes. They are addressed through handles made of a
+// slot index and a generation. Removing an element bumps the generation of
+// its slot, which makes every outstanding handle to it stale instead of
+// letting it silently point to whatever reuses the slot.
+
+typedef struct SlotMapHandle {
+	uint32 index;
+	uint32 generation;
+} SlotMapHandle;
+
+// generations start at 1, so a zero initialized handle is never valid
+#define SLOT_MAP_HANDLE_NULL ((SlotMapHandle){ 0, 0 })
+
+static inline bool slotMapHandleEquals(SlotMapHandle a, SlotMapHandle b) {
+	return a.index == b.index && a.generation == b.generation;
+}
+
+static inline bool slotMapHandleIsNull(SlotMapHandle handle) {
+	return handle.generation == 0;
+}
+
+typedef struct SlotMap_T* SlotMap;
+
+void slotMapCreate(uint dataSize, SlotMap* slotMap);
+void slotMapDestroy(SlotMap slotMap);
+
+/// <summary>
+/// copies data into the map (zero initialized when data is nullptr) and returns its handle
+/// </summary>
+SlotMapHandle slotMapInsert(const void* data, SlotMap slotMap);
+
+/// <summary>
+/// removes the element by moving the last element in its place. Returns false for stale handles
+/// </summary>
+bool slotMapRemove(SlotMapHandle handle, SlotMap slotMap);
+
+/// <summary>
+/// returns nullptr for stale handles.
+/// WARNING: the pointer is invalidated by any insertion or removal
+/// </summary>
+void* slotMapGet(SlotMapHandle handle, SlotMap slotMap);
+bool slotMapContains(SlotMapHandle handle, SlotMap slotMap);
+
+uint slotMapGetSize(SlotMap slotMap);
+
+/// <summary>
+/// densely packed elements, slotMapGetSize elements long
+/// </summary>
+void* slotMapGetData(SlotMap slotMap);
+
+/// <summary>
+/// handle of the element at the given position in the dense array
+/// </summary>
+SlotMapHandle slotMapGetHandle(uint denseIndex, SlotMap slotMap);
+
+void slotMapReserve(uint count, SlotMap slotMap);
+
+/// <summary>
+/// removes all elements, invalidating every handle
+/// </summary>
+void slotMapClear(SlotMap slotMap);
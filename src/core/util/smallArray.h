@@ -0,0 +1,130 @@
+#pragma once
+#include "../core.h"
+#include "typedArray.h"
+#include "../memory/poolAllocator.h"
+
+#include <memory.h>
+
+// Small buffer optimized array.
+//
+// AV_DEFINE_SMALL_ARRAY(name, type, inlineCount) generates an array that
+// stores the first inlineCount elements inside the struct itself and only
+// moves to the heap once it overflows. Short lists, like the children of most
+// syntax and component nodes, therefore never allocate.
+//
+// The inline storage is addressed through the struct and not through a stored
+// pointer, so the array may be copied by value as long as only one copy is
+// used (and destroyed) afterwards.
+//
+// Spilled storage comes from the pool allocator, so lists that keep growing
+// and shrinking (like the children of components) reuse blocks instead of
+// going through the heap.
+
+#define AV_DEFINE_SMALL_ARRAY(name, type, inlineCount)												\
+typedef struct name {																				\
+	uint count;																						\
+	uint allocatedCount;																			\
+	type* heap;																						\
+	type inlineData[inlineCount];																	\
+} name;																								\
+																									\
+static inline void name##Create(name* array) {														\
+	array->count = 0;																				\
+	array->allocatedCount = 0;																		\
+	array->heap = nullptr;																			\
+}																									\
+																									\
+static inline void name##Destroy(name* array) {													\
+	if (array->heap) {																				\
+		poolFree(array->heap, sizeof(type) * array->allocatedCount);								\
+	}																								\
+	array->heap = nullptr;																			\
+	array->count = 0;																				\
+	array->allocatedCount = 0;																		\
+}																									\
+																									\
+static inline type* name##Data(name* array) {														\
+	return array->heap ? array->heap : array->inlineData;											\
+}																									\
+																									\
+static inline uint name##GetCapacity(const name* array) {											\
+	return array->heap ? array->allocatedCount : (inlineCount);										\
+}																									\
+																									\
+static inline bool name##IsInline(const name* array) {												\
+	return array->heap == nullptr;																	\
+}																									\
+																									\
+static inline void name##Spill_(uint count, name* array) {											\
+	uint allocatedCount = name##GetCapacity(array) * 2;												\
+	if (allocatedCount < count) {																	\
+		allocatedCount = count;																		\
+	}																								\
+	type* heap = poolAllocate(sizeof(type) * allocatedCount);										\
+	memcpy(heap, name##Data(array), sizeof(type) * array->count);									\
+	if (array->heap) {																				\
+		poolFree(array->heap, sizeof(type) * array->allocatedCount);								\
+	}																								\
+	array->heap = heap;																				\
+	array->allocatedCount = allocatedCount;															\
+}																									\
+																									\
+static inline void name##Reserve(uint count, name* array) {										\
+	if (count > name##GetCapacity(array)) {															\
+		name##Spill_(count, array);																	\
+	}																								\
+}																									\
+																									\
+static inline void name##Add(type data, name* array) {												\
+	if (array->count == name##GetCapacity(array)) {													\
+		name##Spill_(array->count + 1, array);														\
+	}																								\
+	name##Data(array)[array->count++] = data;														\
+}																									\
+																									\
+static inline uint name##GetSize(const name* array) {												\
+	return array->count;																			\
+}																									\
+																									\
+static inline type name##Get(uint index, name* array) {											\
+	if (!AV_ARRAY_INDEX_VALID(index, array)) {														\
+		avAssert(AV_OUT_OF_BOUNDS, 0, "accessing " #name " out of bounds");							\
+		type empty = { 0 };																			\
+		return empty;																				\
+	}																								\
+	return name##Data(array)[index];																\
+}																									\
+																									\
+static inline void name##Set(type data, uint index, name* array) {									\
+	if (!AV_ARRAY_INDEX_VALID(index, array)) {														\
+		avAssert(AV_OUT_OF_BOUNDS, 0, "writing " #name " out of bounds");							\
+		return;																						\
+	}																								\
+	name##Data(array)[index] = data;																\
+}																									\
+																									\
+/* removes the entry at index keeping the order of the remaining entries */							\
+static inline void name##Remove(uint index, name* array) {											\
+	if (!AV_ARRAY_INDEX_VALID(index, array)) {														\
+		avAssert(AV_OUT_OF_BOUNDS, 0, "removing from " #name " out of bounds");						\
+		return;																						\
+	}																								\
+	type* data = name##Data(array);																	\
+	memmove(data + index, data + index + 1, sizeof(type) * (array->count - index - 1));			\
+	array->count--;																					\
+}																									\
+																									\
+/* removes the entry at index by moving the last entry in its place */								\
+static inline void name##RemoveSwap(uint index, name* array) {										\
+	if (!AV_ARRAY_INDEX_VALID(index, array)) {														\
+		avAssert(AV_OUT_OF_BOUNDS, 0, "removing from " #name " out of bounds");						\
+		return;																						\
+	}																								\
+	type* data = name##Data(array);																	\
+	data[index] = data[--array->count];																\
+}																									\
+																									\
+/* removes all entries but keeps the allocation */													\
+static inline void name##Clear(name* array) {														\
+	array->count = 0;																				\
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "../core.h"
+
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+// Backoff for the spin locks of the core.
+//
+// A waiting thread pauses exponentially longer between attempts, so it does not
+// keep the cache line of the lock busy, and once that gets long it yields its
+// time slice instead, so a holder that was preempted or is doing a longer
+// operation can finish.
+
+// spins of the backoff before the thread yields its time slice instead
+#define SPIN_WAIT_MAX_SPINS 64
+
+// tells the cpu the thread is spinning, so it stops speculating ahead and leaves the core to its sibling
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+	_mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+/// <summary>
+/// waits before the next attempt to take a lock, spins has to start at 1 for every lock attempt
+/// </summary>
+static inline void spinWait(uint* spins) {
+	if (*spins <= SPIN_WAIT_MAX_SPINS) {
+		for (uint i = 0; i < *spins; i++) {
+			cpuRelax();
+		}
+		*spins <<= 1;
+	} else {
+		sched_yield();
+	}
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "../core.h"
+
+#include <memory.h>
+
+// Type specialized counterpart of DynamicArray.
+//
+// AV_DEFINE_ARRAY(Token) generates a TokenArray struct together with a set of
+// static inline functions (TokenArrayAdd, TokenArrayGet, ...). Because the
+// element type is known at compile time every access compiles down to a plain
+// load or store instead of a call and a memcpy of a runtime size.
+//
+// Bounds checking is enabled by default in debug builds and can be controlled
+// explicitly by defining AV_ARRAY_BOUNDS_CHECK to 0 or 1 before inclusion.
+
+#ifndef AV_ARRAY_BOUNDS_CHECK
+#ifdef NDEBUG
+#define AV_ARRAY_BOUNDS_CHECK 0
+#else
+#define AV_ARRAY_BOUNDS_CHECK 1
+#endif
+#endif
+
+#define AV_ARRAY_MIN_ALLOCATION 8
+
+#if AV_ARRAY_BOUNDS_CHECK
+#define AV_ARRAY_INDEX_VALID(index, array) ((index) < (array)->count)
+#else
+#define AV_ARRAY_INDEX_VALID(index, array) true
+#endif
+
+#define AV_DEFINE_ARRAY(type)																		\
+typedef struct type##Array {																		\
+	uint64 count;																					\
+	uint64 allocatedCount;																			\
+	type* data;																						\
+} type##Array;																						\
+																									\
+static inline void type##ArrayCreate(type##Array* array) {											\
+	array->count = 0;																				\
+	array->allocatedCount = 0;																		\
+	array->data = nullptr;																			\
+}																									\
+																									\
+static inline void type##ArrayDestroy(type##Array* array) {										\
+	if (array->data) {																				\
+		avFree(array->data);																		\
+	}																								\
+	array->data = nullptr;																			\
+	array->count = 0;																				\
+	array->allocatedCount = 0;																		\
+}																									\
+																									\
+static inline void type##ArrayReserve(uint64 count, type##Array* array) {							\
+	if (count <= array->allocatedCount) {															\
+		return;																						\
+	}																								\
+	uint64 allocatedCount = array->allocatedCount * 2;												\
+	if (allocatedCount < AV_ARRAY_MIN_ALLOCATION) {													\
+		allocatedCount = AV_ARRAY_MIN_ALLOCATION;													\
+	}																								\
+	if (allocatedCount < count) {																	\
+		allocatedCount = count;																		\
+	}																								\
+	array->data = avReallocate(array->data, sizeof(type), allocatedCount, "increasing size of " #type " array"); \
+	array->allocatedCount = allocatedCount;															\
+}																									\
+																									\
+static inline void type##ArrayAdd(type data, type##Array* array) {									\
+	if (array->count == array->allocatedCount) {													\
+		type##ArrayReserve(array->count + 1, array);												\
+	}																								\
+	array->data[array->count++] = data;																\
+}																									\
+																									\
+static inline void type##ArrayAddRange(const type* data, uint count, type##Array* array) {			\
+	type##ArrayReserve(array->count + count, array);												\
+	memcpy(array->data + array->count, data, sizeof(type) * count);									\
+	array->count += count;																			\
+}																									\
+																									\
+static inline uint type##ArrayGetSize(const type##Array* array) {									\
+	return (uint)array->count;																		\
+}																									\
+																									\
+/* WARNING: the pointer is invalidated by any call that adds elements */							\
+static inline type* type##ArrayGetPtr(uint index, type##Array* array) {							\
+	if (!AV_ARRAY_INDEX_VALID(index, array)) {														\
+		avAssert(AV_OUT_OF_BOUNDS, 0, "accessing " #type " array out of bounds");					\
+		return nullptr;																				\
+	}																								\
+	return array->data + index;																		\
+}																									\
+																									\
+static inline type type##ArrayGet(uint index, const type##Array* array) {							\
+	if (!AV_ARRAY_INDEX_VALID(index, array)) {														\
+		avAssert(AV_OUT_OF_BOUNDS, 0, "accessing " #type " array out of bounds");					\
+		type empty = { 0 };																			\
+		return empty;																				\
+	}																								\
+	return array->data[index];																		\
+}																									\
+																									\
+static inline void type##ArraySet(type data, uint index, type##Array* array) {						\
+	if (!AV_ARRAY_INDEX_VALID(index, array)) {														\
+		avAssert(AV_OUT_OF_BOUNDS, 0, "writing " #type " array out of bounds");						\
+		return;																						\
+	}																								\
+	array->data[index] = data;																		\
+}																									\
+																									\
+/* removes all entries but keeps the allocation */													\
+static inline void type##ArrayClear(type##Array* array) {											\
+	array->count = 0;																				\
+}
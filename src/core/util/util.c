@@ -1,32 +1,24 @@
 #include "../core.h"
+#include "allocator.h"
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
 #include <stdio.h>
 
 
-void* avAllocate_(uint typeSize, uint count, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* errorMsg) {
-	void* data = malloc(((size_t)typeSize * (size_t)count));
-	if (data == 0) {
-		avAssert_(AV_MEMORY_ERROR, AV_SUCCESS, line, file, func, category, errorMsg);
-		return NULL;
-	}
-	memset(data, 0, ((uint64)typeSize * (uint64)count));
-	return data;
+static void* defaultAllocatorAllocate(uint64 size, void* userData) {
+	return avAllocateEx(size, AV_ALLOCATION_UNINITIALIZED, "allocating through default allocator");
 }
 
-void* avReallocate_(void* data, uint typeSize, uint count, AV_LOCATION_ARGS, AV_CATEGORY_ARGS, const char* errorMsg) {
-	void* ptr = realloc(data, ((size_t)typeSize * (size_t)count));
-	if (ptr == 0) {
-		avAssert_(AV_MEMORY_ERROR, AV_SUCCESS, line, file, func, category, errorMsg);
-		return nullptr;
-	}
-	return ptr;
+static void defaultAllocatorFree(void* data, void* userData) {
+	avFree(data);
 }
 
-void avFree_(void* data,AV_LOCATION_ARGS, AV_CATEGORY_ARGS) {
-	free(data);
-}
+const Allocator defaultAllocator = {
+	.allocate = defaultAllocatorAllocate,
+	.free = defaultAllocatorFree,
+	.userData = nullptr,
+};
 
 bool isDecNumber(char chr) {
 	if (chr >= '0' && chr <= '9') {
@@ -17,6 +17,7 @@ AvResult parseFile(const char* buffer, uint64 size, const char* fileName) {
 
 	// TODO: preprocessor
 
+	destroySyntaxTree(syntaxTree);
 	dynamicArrayDestroy(syntaxTree);
 	avFree(tokens);
 
@@ -34,11 +35,12 @@ AvResult avInterfaceLoadFromFile(AvInterfaceLoadFileInfo info, AvInterface* inte
 	uint64 size = ftell(file);
 	fseek(file, 0, SEEK_SET);
 
-	char* buffer = avAllocate(sizeof(char), size + 1, "allocating space for file parsing");
+	char* buffer = avAllocateEx(size + 1, AV_ALLOCATION_UNINITIALIZED, "allocating space for file parsing");
 	uint64 readSize = fread(buffer, 1, size, file);
 	if (readSize != size) {
 		avAssert(AV_IO_ERROR, 0, "failed to read data");
 	}
+	buffer[readSize] = '\0';
 
 	if (fclose(file)) {
 		avAssert(AV_IO_ERROR, 0, "failed to close file");
@@ -1,33 +1,34 @@
 #include "syntax.h"
+#include "../core/util/typedArray.h"
+#include "../core/memory/poolAllocator.h"
 #include <stdarg.h>
-#include <stdio.h>
 #include <memory.h>
 
 typedef struct SyntaxCheckEntry {
 	TokenType type;
 	Token* ptr;
 }SyntaxCheckEntry;
+AV_DEFINE_ARRAY(SyntaxCheckEntry)
 
 
 void syntaxError(TokenType expectedType, Token token) {
 
-	char msgOut[512] = {};
-
-	sprintf(
-		msgOut, 
-		"syntax error at line %i, %s expected but %s provided", 
-		token.location.lineNumber, 
-		tokenTypeAsString(expectedType), 
+	// the file name is owned by the caller, so it is passed as an argument to be copied with the message
+	avAssertf_(
+		AV_INVALID_SYNTAX, 0, nullptr,
+		token.location.lineNumber, __FILE__, "parsing", AV_LOG_CATEGORY,
+		"syntax error in %s at line %i, %s expected but %s provided",
+		token.location.file,
+		token.location.lineNumber,
+		tokenTypeAsString(expectedType),
 		tokenTypeAsString(token.type)
 	);
-
-	avAssert_(AV_INVALID_SYNTAX, 0, token.location.lineNumber, token.location.file, "parsing", AV_LOG_CATEGORY, msgOut);
 }
 
 bool getSyntax_(uint tokenCount, Token* tokens, uint* index, ...) {
 
-	DynamicArray parameters;
-	dynamicArrayCreate(sizeof(SyntaxCheckEntry), &parameters);
+	SyntaxCheckEntryArray parameters;
+	SyntaxCheckEntryArrayCreate(&parameters);
 
 	{
 		va_list format;
@@ -43,30 +44,32 @@ bool getSyntax_(uint tokenCount, Token* tokens, uint* index, ...) {
 				entry.type = tokenType;
 				entry.ptr = ptr;
 
-				dynamicArrayAdd(&entry, parameters);
+				SyntaxCheckEntryArrayAdd(entry, &parameters);
 			}
 		}
 		va_end(format);
 	}
 
-	uint entryCount = dynamicArrayGetSize(parameters);
+	bool valid = true;
+	uint entryCount = SyntaxCheckEntryArrayGetSize(&parameters);
 	for (uint i = 0; i < entryCount; i++) {
-		SyntaxCheckEntry entry;
-		dynamicArrayGet(&entry, i, parameters);
+		SyntaxCheckEntry entry = SyntaxCheckEntryArrayGet(i, &parameters);
 
 		TokenType type = entry.type;
 		Token* ptr = entry.ptr;
 
 		if (*index >= tokenCount) {
 			avAssert(AV_INVALID_SYNTAX, 0, "unexpected end of file");
-			return false;
+			valid = false;
+			break;
 		}
 
 		Token currentToken = tokens[*index];
 
 		if (!(currentToken.type & type)) {
 			syntaxError(type, currentToken);
-			return false;
+			valid = false;
+			break;
 		}
 
 		if (ptr != nullptr) {
@@ -76,8 +79,8 @@ bool getSyntax_(uint tokenCount, Token* tokens, uint* index, ...) {
 		(*index)++;
 	}
 
-	dynamicArrayDestroy(parameters);
-	return true;
+	SyntaxCheckEntryArrayDestroy(&parameters);
+	return valid;
 }
 
 #define getSyntax(tokenCount, tokens, index, ...) getSyntax_(tokenCount, tokens, index, __VA_ARGS__, TOKEN_TYPE_UNKNOWN)
@@ -196,3 +199,51 @@ AvResult buildSyntaxTree(uint tokenCount, Token* tokens, DynamicArray rootNodes)
 
 	return AV_SUCCESS;
 }
+
+void destroySyntaxNode(SyntaxTreeNode* node) {
+	SyntaxChildArray* children = nullptr;
+	switch (node->type) {
+	case NODE_TYPE_PROTOTYPE:
+		children = &node->prototype.children;
+		break;
+	case NODE_TYPE_COMPONENT:
+		children = &node->component.children;
+		break;
+	case NODE_TYPE_PROPERTY:
+		if (node->property.value) {
+			syntaxNodeFree(node->property.value);
+		}
+		return;
+	default:
+		return;
+	}
+
+	uint childCount = SyntaxChildArrayGetSize(children);
+	for (uint i = 0; i < childCount; i++) {
+		syntaxNodeFree(SyntaxChildArrayGet(i, children));
+	}
+	SyntaxChildArrayDestroy(children);
+}
+
+SyntaxTreeNode* syntaxNodeCreate(NodeType type) {
+	SyntaxTreeNode* node = poolAllocateZeroed(sizeof(SyntaxTreeNode));
+	node->type = type;
+	if (type == NODE_TYPE_PROTOTYPE) {
+		SyntaxChildArrayCreate(&node->prototype.children);
+	} else if (type == NODE_TYPE_COMPONENT) {
+		SyntaxChildArrayCreate(&node->component.children);
+	}
+	return node;
+}
+
+void syntaxNodeFree(SyntaxTreeNode* node) {
+	destroySyntaxNode(node);
+	poolFree(node, sizeof(SyntaxTreeNode));
+}
+
+void destroySyntaxTree(DynamicArray rootNodes) {
+	uint nodeCount = dynamicArrayGetSize(rootNodes);
+	for (uint i = 0; i < nodeCount; i++) {
+		destroySyntaxNode(dynamicArrayGetPtr(i, rootNodes));
+	}
+}
@@ -1,6 +1,11 @@
 #pragma once
 #include "tokenizer.h"
 #include "../core/util/dynamicArray.h"
+#include "../core/util/smallArray.h"
+
+// most nodes have only a handful of children, these stay inside the node
+#define SYNTAX_CHILD_INLINE_COUNT 8
+AV_DEFINE_SMALL_ARRAY(SyntaxChildArray, struct SyntaxTreeNode*, SYNTAX_CHILD_INLINE_COUNT)
 
 typedef enum NodeType {
 	NODE_TYPE_ONCE,
@@ -28,13 +33,13 @@ typedef struct ParamNode {
 typedef struct PrototypeNode {
 	const char* name;
 	const char* type;
-	DynamicArray children;
+	SyntaxChildArray children;
 } PrototypeNode;
 
 typedef struct ComponentNode {
 	const char* name;
 	const char type;
-	DynamicArray children;
+	SyntaxChildArray children;
 } ComponentNode;
 
 typedef struct PropertyNode {
@@ -62,4 +67,15 @@ typedef struct SyntaxTreeNode {
 
 }SyntaxTreeNode;
 
-AvResult buildSyntaxTree(uint tokenCount, Token* tokens, DynamicArray rootNodes);
\ No newline at end of file
+AvResult buildSyntaxTree(uint tokenCount, Token* tokens, DynamicArray rootNodes);
+void destroySyntaxTree(DynamicArray rootNodes);
+
+/// <summary>
+/// allocates a zero initialized node from the pool allocator
+/// </summary>
+SyntaxTreeNode* syntaxNodeCreate(NodeType type);
+
+/// <summary>
+/// destroys the children of the node and returns it to the pool allocator
+/// </summary>
+void syntaxNodeFree(SyntaxTreeNode* node);
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "tokenizer.h"
 #include "../core/core.h"
+#include "../core/memory/poolAllocator.h"
 
 #include <memory.h>
 #include <stdio.h>
@@ -13,7 +14,7 @@ TokenLL* appendToken(TokenLL* currentToken, uint lineNumber, const char* fileNam
 	currentToken->token.location.lineNumber = lineNumber;
 	currentToken->token.location.file = fileName;
 
-	TokenLL* newToken = avAllocate(sizeof(TokenLL), 1, "allocating new token");
+	TokenLL* newToken = poolAllocateZeroed(sizeof(TokenLL));
 	currentToken->next = newToken;
 	return newToken;
 }
@@ -21,11 +22,11 @@ TokenLL* appendToken(TokenLL* currentToken, uint lineNumber, const char* fileNam
 void freeTokensLL(TokenLL* token) {
 	TokenLL* nextToken = token->next;
 	while (nextToken != nullptr) {
-		avFree(token);
+		poolFree(token, sizeof(TokenLL));
 		token = nextToken;
 		nextToken = token->next;
 	}
-	avFree(token);
+	poolFree(token, sizeof(TokenLL));
 }
 
 void convertTokenLLtoTokenArr(TokenLL* tokenList, Token** tokens, uint* tokenCount) {
@@ -40,7 +41,7 @@ void convertTokenLLtoTokenArr(TokenLL* tokenList, Token** tokens, uint* tokenCou
 	}
 
 	// allocate data for array
-	*tokens = avAllocate(sizeof(Token), size, "allocating data for token array");
+	*tokens = avAllocateEx(sizeof(Token) * (uint64)size, AV_ALLOCATION_UNINITIALIZED, "allocating data for token array");
 
 	// copy the tokens into the array
 	current = tokenList;
@@ -134,7 +135,7 @@ AvResult tokenize(const char* buffer, uint64 size, Token** tokens, uint* tokenCo
 	TokenLocationDetails locationDetails = {};
 	locationDetails.file = fileName;
 
-	TokenLL* currentToken = avAllocate(sizeof(TokenLL), 1, "allocationg start token");
+	TokenLL* currentToken = poolAllocateZeroed(sizeof(TokenLL));
 	TokenLL* tokenList = currentToken;
 
 	uint lineNumber = 1;
@@ -325,9 +326,7 @@ AvResult tokenize(const char* buffer, uint64 size, Token** tokens, uint* tokenCo
 				}
 				currentToken = appendToken(currentToken, lineNumber, fileName);
 			} else {
-				char errorMessage[64];
-				sprintf(errorMessage, "invalid character '%c'", c);
-				avAssert(AV_UNABLE_TO_PARSE, AV_SUCCESS, errorMessage);
+				avAssertf(AV_UNABLE_TO_PARSE, AV_SUCCESS, "invalid character '%c'", c);
 				return AV_UNABLE_TO_PARSE;
 			}
 			break;
@@ -1,6 +1,8 @@
 #define AV_LOG_CATEGORY "application"
 #define DEBUG
 #include <avixel/avixel.h>
+#include <stdlib.h>
+#include <string.h>
 
 void buildInterface(AvInstance instance) {
 	AvInterface interface;
@@ -19,6 +21,54 @@ void buildInterface(AvInstance instance) {
 	
 }
 
+// a grid of rounded rectangles, all drawn with a single instanced draw
+void drawTestRects(AvInstance instance) {
+	const uint columns = 32;
+	const uint rows = 18;
+	static AvRect rects[columns * rows];
+	for (uint y = 0; y < rows; y++) {
+		for (uint x = 0; x < columns; x++) {
+			AvRect& rect = rects[y * columns + x];
+			rect.x = 8.0f + x * 39.0f;
+			rect.y = 8.0f + y * 39.0f;
+			rect.width = 35.0f;
+			rect.height = 35.0f;
+			rect.color.r = (byte)(x * 255 / columns);
+			rect.color.g = (byte)(y * 255 / rows);
+			rect.color.b = 160;
+			rect.color.a = 255;
+			rect.cornerRadius = 6.0f;
+			rect.clipIndex = 0;
+		}
+	}
+	avDrawRects(instance, columns * rows, rects);
+}
+
+// tokens of the parser point in to the source without a null terminator and are logged with %.*s,
+// the deferred formatting must not read past the precision
+struct PrecisionCheck {
+	bool logged;
+	bool correct;
+};
+
+void checkPrecisionMessage(void* userData, const AvLogMessage* message) {
+	PrecisionCheck* check = (PrecisionCheck*)userData;
+	const char* text = strstr(message->text, "precision test: ");
+	if (text) {
+		check->logged = true;
+		check->correct = strcmp(text, "precision test: rect re|") == 0;
+	}
+}
+
+void logUnterminatedToken() {
+	// exactly the size of the token, address sanitizers and memory checkers catch a read past it.
+	// the arguments are captured by avLogf, the token can be freed before the message is written
+	char* token = (char*)malloc(4);
+	memcpy(token, "rect", 4);
+	avLogf(AV_TEST_INFO, "precision test: %.*s %.2s|", 4, token, token);
+	free(token);
+}
+
 const char* disabledLogCategories[] = {
 	"avixel",
 	//"avixel_core",
@@ -52,6 +102,13 @@ int main(int argC, const char** argV) {
 	logSettings.validationLevel = AV_VALIDATION_LEVEL_WARNINGS_AND_ERRORS;
 	logSettings.level = AV_LOG_LEVEL_ALL;
 
+	PrecisionCheck precisionCheck = {};
+	AvLogSink precisionSink = {};
+	precisionSink.userData = &precisionCheck;
+	precisionSink.pfnWrite = checkPrecisionMessage;
+	logSettings.sinkCount = 1;
+	logSettings.sinks = &precisionSink;
+
 	AvWindowCreateInfo windowInfo = {};
 	windowInfo.sType = AV_STRUCTURE_TYPE_WINDOW_CREATE_INFO;
 	windowInfo.fullscreen = false;
@@ -72,6 +129,10 @@ int main(int argC, const char** argV) {
 	instanceInfo.projectInfo = projectInfo;
 	instanceInfo.logSettings = &logSettings;
 	instanceInfo.disableDeviceValidation = false;
+	instanceInfo.enableMemoryTracking = true;
+	instanceInfo.pipelineCachePath = "avixel_pipeline.cache";
+	// the test interface is static, so frames are only rendered when the window changes
+	instanceInfo.renderMode = AV_RENDER_MODE_ON_DEMAND;
 	instanceInfo.windowInfo = windowInfo;
 	
 	avAssert(
@@ -81,15 +142,20 @@ int main(int argC, const char** argV) {
 	);
 
 	buildInterface(instance);
+	logUnterminatedToken();
 
+	// avUpdate blocks while nothing changed, so this loop idles instead of spinning
 	while (!avShutdownRequested(instance)) {
 
+		drawTestRects(instance);
 		avUpdate(instance);
 	}
 
+	// reports leaks because memory tracking is enabled
 	avInstanceDestroy(instance);
-	
-	//PRINT_ALL_MEMORY_LEAKS();
+
+	// the message is written by the log writer thread, it has been written once the instance is destroyed
+	avAssert(precisionCheck.logged && precisionCheck.correct ? AV_SUCCESS : AV_TEST_ERROR, AV_SUCCESS, "deferred log formatting stops at the precision of an unterminated string");
 
 	return 0;
 }
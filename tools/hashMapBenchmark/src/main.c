@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <core/util/hashMap.h>
+
+// compares hash map lookups against a linear scan over a key array,
+// the way lookups are done when only a DynamicArray is available
+
+#define LOOKUPS_PER_SIZE 4000000
+
+const uint64 benchmarkSizes[] = { 4, 8, 16, 32, 64, 256, 1024, 16384 };
+const uint benchmarkSizeCount = sizeof(benchmarkSizes) / sizeof(uint64);
+
+static double getTime() {
+	struct timespec time;
+	timespec_get(&time, TIME_UTC);
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+// xorshift, keys should not be sequential to avoid flattering the hash
+static uint64 nextRandom(uint64* state) {
+	uint64 x = *state;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	*state = x;
+	return x;
+}
+
+static uint64 linearScanLookup(uint64 key, uint64 count, const uint64* keys, const uint64* values) {
+	for (uint64 i = 0; i < count; i++) {
+		if (keys[i] == key) {
+			return values[i];
+		}
+	}
+	return 0;
+}
+
+static void benchmarkSize(uint64 size) {
+	uint64* keys = malloc(sizeof(uint64) * size);
+	uint64* values = malloc(sizeof(uint64) * size);
+	uint64* lookupOrder = malloc(sizeof(uint64) * size);
+
+	HashMapCreateInfo createInfo = { 0 };
+	createInfo.keySize = sizeof(uint64);
+	createInfo.valueSize = sizeof(uint64);
+	createInfo.initialCapacity = size;
+	HashMap map;
+	hashMapCreate(createInfo, &map);
+
+	uint64 random = 0x2545F4914F6CDD1DULL;
+	for (uint64 i = 0; i < size; i++) {
+		keys[i] = nextRandom(&random);
+		values[i] = i + 1;
+		hashMapInsert(&keys[i], &values[i], map);
+	}
+	for (uint64 i = 0; i < size; i++) {
+		lookupOrder[i] = keys[nextRandom(&random) % size];
+	}
+
+	uint64 lookups = LOOKUPS_PER_SIZE;
+	if (size > 1024) {
+		// the linear scan gets too slow to run the full amount
+		lookups /= size / 1024;
+	}
+
+	uint64 checksum = 0;
+	double start = getTime();
+	for (uint64 i = 0; i < lookups; i++) {
+		checksum += linearScanLookup(lookupOrder[i % size], size, keys, values);
+	}
+	double linearTime = getTime() - start;
+
+	uint64 mapChecksum = 0;
+	start = getTime();
+	for (uint64 i = 0; i < lookups; i++) {
+		uint64 key = lookupOrder[i % size];
+		uint64* value = hashMapGet(&key, map);
+		mapChecksum += value ? *value : 0;
+	}
+	double mapTime = getTime() - start;
+
+	if (checksum != mapChecksum) {
+		printf("checksum mismatch for size %llu\n", size);
+	}
+
+	double linearNs = linearTime * 1e9 / (double)lookups;
+	double mapNs = mapTime * 1e9 / (double)lookups;
+	printf("%8llu %14.2f %14.2f %10.2fx\n", size, linearNs, mapNs, linearNs / mapNs);
+
+	hashMapDestroy(map);
+	free(lookupOrder);
+	free(values);
+	free(keys);
+}
+
+int main(int argC, const char** argV) {
+	printf("%8s %14s %14s %11s\n", "entries", "linear ns/op", "map ns/op", "speedup");
+	for (uint i = 0; i < benchmarkSizeCount; i++) {
+		benchmarkSize(benchmarkSizes[i]);
+	}
+	return 0;
+}
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <core/logging/logging.h>
+#include <core/logging/logBinary.h>
+#include <core/logging/logConfig.h>
+
+// decodes a binary log written through AvLogSettings.binaryLogFile in to the
+// text format of the regular log output
+//
+// usage: logDecoder <file> [--time] [--relative-time] [--line] [--file] [--func] [--category] [--project] [--no-colors]
+
+// string ids are assigned in order, a log never gets close to this many distinct strings
+#define LOG_DECODER_MAX_STRING_ID (1u << 24)
+
+typedef struct StringTable {
+	char** strings;
+	uint32 capacity;
+} StringTable;
+
+static void stringTableSet(uint32 id, char* str, StringTable* table) {
+	if (id >= table->capacity) {
+		uint32 capacity = table->capacity ? table->capacity : 64;
+		while (capacity <= id) {
+			capacity *= 2;
+		}
+		table->strings = realloc(table->strings, sizeof(char*) * capacity);
+		memset(table->strings + table->capacity, 0, sizeof(char*) * (capacity - table->capacity));
+		table->capacity = capacity;
+	}
+	free(table->strings[id]);
+	table->strings[id] = str;
+}
+
+static const char* stringTableGet(uint32 id, const StringTable* table) {
+	if (id == 0 || id >= table->capacity) {
+		return nullptr;
+	}
+	return table->strings[id];
+}
+
+static void stringTableDestroy(StringTable* table) {
+	for (uint32 i = 0; i < table->capacity; i++) {
+		free(table->strings[i]);
+	}
+	free(table->strings);
+}
+
+// bytes between the read position and the end of the file, sizes read from the file are checked against it
+static uint64 bytesLeft(FILE* file, uint64 fileSize) {
+	long position = ftell(file);
+	if (position < 0 || (uint64)position > fileSize) {
+		return 0;
+	}
+	return fileSize - (uint64)position;
+}
+
+static bool hasArgument(int argC, const char** argV, const char* argument) {
+	for (int i = 2; i < argC; i++) {
+		if (strcmp(argV[i], argument) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int main(int argC, const char** argV) {
+	if (argC < 2) {
+		fprintf(stderr, "usage: %s <file> [--time] [--relative-time] [--line] [--file] [--func] [--category] [--project] [--no-colors]\n", argV[0]);
+		return 1;
+	}
+
+	FILE* file = fopen(argV[1], "rb");
+	if (file == nullptr) {
+		fprintf(stderr, "unable to open %s\n", argV[1]);
+		return 1;
+	}
+
+	LogBinaryHeader header;
+	if (fread(&header, sizeof(LogBinaryHeader), 1, file) != 1 || memcmp(header.magic, LOG_BINARY_MAGIC, sizeof(header.magic)) != 0) {
+		fprintf(stderr, "%s is not a binary log\n", argV[1]);
+		fclose(file);
+		return 1;
+	}
+	if (header.version != LOG_BINARY_VERSION) {
+		fprintf(stderr, "unsupported binary log version %u\n", header.version);
+		fclose(file);
+		return 1;
+	}
+	header.projectName[LOG_BINARY_PROJECT_NAME_SIZE - 1] = '\0';
+
+	long headerEnd = ftell(file);
+	fseek(file, 0, SEEK_END);
+	long end = ftell(file);
+	fseek(file, headerEnd, SEEK_SET);
+	uint64 fileSize = end > 0 ? (uint64)end : 0;
+
+	AvLogSettings settings = avLogSettingsDefault;
+	settings.level = AV_LOG_LEVEL_ALL;
+	settings.disabledCategoryCount = 0;
+	settings.disabledMessageCount = 0;
+	settings.asynchronous = false;
+	settings.binaryLogFile = nullptr;
+	settings.printTime = hasArgument(argC, argV, "--time") || hasArgument(argC, argV, "--relative-time");
+	settings.timeFormat = hasArgument(argC, argV, "--relative-time") ? AV_LOG_TIME_FORMAT_RELATIVE : AV_LOG_TIME_FORMAT_WALL_CLOCK;
+	settings.printLine = hasArgument(argC, argV, "--line");
+	settings.printFile = hasArgument(argC, argV, "--file");
+	settings.printFunc = hasArgument(argC, argV, "--func");
+	settings.printCategory = hasArgument(argC, argV, "--category");
+	settings.printProject = hasArgument(argC, argV, "--project");
+	settings.colors = !hasArgument(argC, argV, "--no-colors");
+	setProjectDetails(header.projectName, header.projectVersion);
+	setLogClockBase(header.timestampStart, header.wallClockStart);
+	setLogSettings(settings);
+
+	StringTable strings = { 0 };
+	byte* payload = nullptr;
+	uint64 payloadCapacity = 0;
+	uint64 messageCount = 0;
+
+	bool corrupt = false;
+	byte type;
+	while (fread(&type, 1, 1, file) == 1) {
+		if (type == LOG_BINARY_ENTRY_TYPE_STRING) {
+			LogBinaryString entry;
+			if (fread(&entry, sizeof(LogBinaryString), 1, file) != 1) {
+				break;
+			}
+			if (entry.id == 0 || entry.id >= LOG_DECODER_MAX_STRING_ID || entry.length > bytesLeft(file, fileSize)) {
+				corrupt = true;
+				break;
+			}
+			char* str = malloc((size_t)entry.length + 1);
+			if (str == nullptr || fread(str, 1, entry.length, file) != entry.length) {
+				free(str);
+				break;
+			}
+			str[entry.length] = '\0';
+			stringTableSet(entry.id, str, &strings);
+		} else if (type == LOG_BINARY_ENTRY_TYPE_MESSAGE) {
+			LogBinaryMessage entry;
+			if (fread(&entry, sizeof(LogBinaryMessage), 1, file) != 1) {
+				break;
+			}
+			if (entry.payloadSize > bytesLeft(file, fileSize)) {
+				corrupt = true;
+				break;
+			}
+			if ((uint64)entry.payloadSize + 1 > payloadCapacity) {
+				byte* grown = realloc(payload, (size_t)entry.payloadSize + 1);
+				if (grown == nullptr) {
+					break;
+				}
+				payload = grown;
+				payloadCapacity = (uint64)entry.payloadSize + 1;
+			}
+			if (fread(payload, 1, entry.payloadSize, file) != entry.payloadSize) {
+				break;
+			}
+			payload[entry.payloadSize] = '\0';
+
+			LogRecord record = { 0 };
+			record.config = logConfigGet();
+			record.type = (LogRecordType)entry.recordType;
+			record.result = (AvResult)entry.result;
+			record.line = entry.line;
+			record.file = stringTableGet(entry.fileId, &strings);
+			record.func = stringTableGet(entry.funcId, &strings);
+			record.category = stringTableGet(entry.categoryId, &strings);
+			record.timestamp = entry.timestamp;
+			if (entry.formatId) {
+				record.message = stringTableGet(entry.formatId, &strings);
+				record.args = payload;
+				record.argsSize = entry.payloadSize;
+			} else {
+				record.message = (const char*)payload;
+			}
+			if (record.message == nullptr) {
+				record.message = "";
+				record.args = nullptr;
+			}
+			writeLogRecord(&record);
+			messageCount++;
+		} else {
+			corrupt = true;
+			break;
+		}
+	}
+	if (corrupt) {
+		fprintf(stderr, "corrupt entry after %llu messages\n", messageCount);
+	}
+
+	shutdownLogging();
+	logConfigReclaim();
+	free(payload);
+	stringTableDestroy(&strings);
+	fclose(file);
+	return corrupt ? 1 : 0;
+}